@@ -2,10 +2,13 @@
 
 // #include "state_machine.h"
 #include "animation/animation.h"
+#include "capture/capture.h"
 #include "common/common.h"
 #include "deferred_exec.h"
 #include "state_machine.h"
 #include "lib/lib8tion/lib8tion.h"
+#include "perf/perf.h"
+#include "trace/trace.h"
 
 // #define DEBUG_FUNCTIONS true
 
@@ -15,6 +18,20 @@ COLOR debug_leds[10] = {0};
 
 static state_machine_t state_machine;
 
+/* Wave that fades out the shimmer of the last wake up, a second after waking up */
+static animation_handle_t wake_end_wave = ANIMATION_HANDLE_NONE;
+
+/* Set while the keyboard keeps itself awake. Blinks still waiting for their delay when it wakes up don't show */
+static bool keeping_awake = false;
+
+static uint32_t keep_awake_blink_cb(uint32_t trigger_time, void *cb_arg) {
+    /* Blinks go in the overlay, so a long idle stretch never fills the queue */
+    if (keeping_awake) {
+        sgv_animation_overlay_set(random8_max(LED_COUNT), animation_color_val(random8() & 1 ? 0x80 : 0x00), 0);
+    }
+    return 0;
+}
+
 uint32_t keep_awake_cb(uint32_t trigger_time, void *cb_arg) {
     // TODO Send key
     const uint16_t codes[] = {
@@ -25,9 +42,10 @@ uint32_t keep_awake_cb(uint32_t trigger_time, void *cb_arg) {
 
     tap_code16(codes[random8_max(codes_size)]);
 
-    animation_t anim = animation_solid_key(random8_max(LED_COUNT), random8() & 1 ? 0x80 : 00, 0xFF, 0xFF);
-    anim.ticks += (random16() >> 5);
-    sgv_animation_add_animation(anim);
+    /* Blinks show up to 2 seconds after the tap, so they don't follow its rhythm. 0 would never be scheduled */
+    if (defer_exec((random16() >> 5) + 1, keep_awake_blink_cb, NULL) == INVALID_DEFERRED_TOKEN) {
+        keep_awake_blink_cb(trigger_time, NULL);
+    }
 
     return (random16() >> 1) + 500;
 }
@@ -47,12 +65,19 @@ bool dip_switch_update_user(uint8_t index, bool active) {
 }
 
 bool process_record_user(uint16_t keycode, keyrecord_t *record) {
+    CAPTURE_KEY(record);
+
     static deferred_token keep_awake_token = INVALID_DEFERRED_TOKEN;
 
     if (keep_awake_token != INVALID_DEFERRED_TOKEN && record->event.pressed) {
         // Cancel idle mode when a key is pressed
         cancel_deferred_exec(keep_awake_token);
         keep_awake_token = INVALID_DEFERRED_TOKEN;
+        keeping_awake    = false;
+        // Blinks would stay over the wake up waves otherwise
+        sgv_animation_overlay_clear_all();
+        // The wave ending the last wake up would cut this one short
+        sgv_animation_cancel(wake_end_wave);
         sgv_animation_add_animation(
             animation_wave_solid(g_led_config.matrix_co[record->event.key.row][record->event.key.col],
                                  animation_color_special(ANIMATION_COLOR_SHIMMER)));
@@ -60,7 +85,9 @@ bool process_record_user(uint16_t keycode, keyrecord_t *record) {
         animation_t anim = animation_wave_solid(g_led_config.matrix_co[record->event.key.row][record->event.key.col],
                                                 animation_color_val(0x00));
         anim.ticks += 1000;
-        sgv_animation_add_animation(anim);
+        // As important as the shimmer it ends, keypress waves must not drop it and leave the shimmer on
+        anim.priority = ANIMATION_PRIORITY_AMBIENT;
+        wake_end_wave = sgv_animation_add_animation(anim);
     }
 
     if (led_matrix_get_mode() == LED_MATRIX_CUSTOM_sgv_custom_led && record->event.pressed) {
@@ -89,9 +116,11 @@ bool process_record_user(uint16_t keycode, keyrecord_t *record) {
             return false;
         case SGV_CAPS:
             if (record->event.pressed) {
+                /* Keys pressed close together share one ripple. It covers what's below it, as white LEDs have no hue
+                   that would keep an added ripple visible over a bright shimmer */
                 sgv_animation_add_animation(
-                    animation_wave(g_led_config.matrix_co[record->event.key.row][record->event.key.col],
-                                   animation_color_val((random8() / 2) + 0x80)));
+                    animation_ripple(g_led_config.matrix_co[record->event.key.row][record->event.key.col],
+                                     animation_color_val((random8() / 2) + 0x80)));
             } else {
                 clear_oneshot_layer_state(ONESHOT_PRESSED);
             }
@@ -99,10 +128,29 @@ bool process_record_user(uint16_t keycode, keyrecord_t *record) {
         case SGV_PRSC:
             if (record->event.pressed) {
                 keep_awake_token = defer_exec(1000, keep_awake_cb, NULL);
+                keeping_awake    = true;
             } else {
                 clear_oneshot_layer_state(ONESHOT_PRESSED);
             }
             break;
+        case SGV_PROF:
+            if (record->event.pressed) {
+#if SGV_PERF
+                perf_print();
+#endif
+            } else {
+                clear_oneshot_layer_state(ONESHOT_PRESSED);
+            }
+            return false;
+        case SGV_CAPT:
+            if (record->event.pressed) {
+#if SGV_CAPTURE
+                capture_print();
+#endif
+            } else {
+                clear_oneshot_layer_state(ONESHOT_PRESSED);
+            }
+            return false;
         default:
             if (!record->event.pressed) {
                 clear_oneshot_layer_state(ONESHOT_PRESSED);
@@ -121,16 +169,22 @@ bool process_record_user(uint16_t keycode, keyrecord_t *record) {
  * @return layer_state_t The new layer to set
  */
 layer_state_t layer_state_set_user(layer_state_t state) {
+    CAPTURE_LAYER(state);
+
     layer_state_t highest = get_highest_layer(state);
     if (highest == BASE) {
-        sgv_animation_add_animation(animation_wave_solid(g_led_config.matrix_co[5][12], // FN
-                                                         animation_color_val(COLOR_OFF)));
+        animation_t anim = animation_wave_solid(g_led_config.matrix_co[5][12], // FN
+                                                animation_color_val(COLOR_OFF));
+        anim.priority    = ANIMATION_PRIORITY_INDICATOR;
+
+        sgv_animation_add_animation(anim);
     } else if (highest == FN) {
         animation_t anim                            = animation_wave_solid(g_led_config.matrix_co[5][12], // FN
                                                                            animation_color_val(0xFF));
         anim.keymap                                 = &keymaps[FN];
         anim.hsv_colors[ANIMATION_HSV_COLOR_BASE_N] = anim.hsv_colors[ANIMATION_HSV_COLOR_RESULT_N] =
             animation_color_val(0x10);
+        anim.priority = ANIMATION_PRIORITY_INDICATOR;
 
         sgv_animation_add_animation(anim);
     } else if (highest == SECRET) {
@@ -143,6 +197,7 @@ layer_state_t layer_state_set_user(layer_state_t state) {
             anim.keymap                                   = &keymaps[SECRET];
             anim.hsv_colors[ANIMATION_HSV_COLOR_BASE_N]   = animation_color_special(ANIMATION_COLOR_RANDOM);
             anim.hsv_colors[ANIMATION_HSV_COLOR_RESULT_N] = animation_color_val(COLOR_OFF);
+            anim.priority                                 = ANIMATION_PRIORITY_INDICATOR;
 
             sgv_animation_add_animation(anim);
         }
@@ -151,6 +206,16 @@ layer_state_t layer_state_set_user(layer_state_t state) {
     return state;
 }
 
+#if SGV_TRACE && defined(CONSOLE_ENABLE)
+/**
+ * @brief Called every loop of the main task
+ * Streams the animation trace over the console a few times a second
+ */
+void housekeeping_task_user(void) {
+    trace_stream();
+}
+#endif
+
 /**
  * @brief Called when about to shutdown, via soft reset or bootloader reset
  * Currently turns off all LEDs so they don't get stuck
@@ -190,9 +255,9 @@ bool led_matrix_indicators_advanced_user(uint8_t led_min, uint8_t led_max) {
     for (uint8_t i = 0; i < 10; ++i) {
         color_t color = debug_leds[i];
         if (i == 0) {
-            led_matrix_set_value(30, color.v);
+            led_matrix_set_value(30, color);
         } else {
-            led_matrix_set_value(20 + i, color.v);
+            led_matrix_set_value(20 + i, color);
         }
     }
 
@@ -41,9 +41,9 @@ const uint16_t PROGMEM keymaps[][MATRIX_ROWS][MATRIX_COLS] = {
 [SECRET] = LAYOUT_tkl_ansi(
      QK_RBT,   _______,  _______,  _______,  _______,  _______,  _______,  _______,  _______,  _______,    _______,    _______,  _______,                  _______,  _______,  QK_BOOT,
      _______,  _______,  _______,  _______,  _______,  _______,  _______,  _______,  _______,  _______,    _______,    _______,  _______,        _______,  _______,  _______,  _______,
-     _______,  _______,  _______,  _______,  _______,  _______,  _______,  _______,  _______,  _______,    _______,    _______,  _______,        _______,  _______,  _______,  _______,
+     _______,  _______,  _______,  _______,  _______,  _______,  _______,  _______,  _______,  _______,    SGV_PROF,   _______,  _______,        _______,  _______,  _______,  _______,
      _______,  _______,  _______,  _______,  _______,  _______,  _______,  _______,  _______,  _______,    _______,    _______,                  _______,
-     _______,            _______,  _______,  _______,  _______,  _______,  _______,  _______,  _______,    _______,    _______,                  _______,            _______,
+     _______,            _______,  _______,  SGV_CAPT, _______,  _______,  _______,  _______,  _______,    _______,    _______,                  _______,            _______,
      _______,  _______,  _______,                                _______,                                  _______,    _______,  _______,        TO(BASE), _______,  _______,  _______),
 
 };
@@ -9,3 +9,17 @@ NKRO_ENABLE = yes
 DEFERRED_EXEC_ENABLE = yes
 
 OPT_DEFS += -DLED_MATRIX_CUSTOM_USER
+
+# Animation engine tracing, streamed over the console or drained over raw HID with trace2chrome.py
+# OPT_DEFS += -DSGV_TRACE=true
+# CONSOLE_ENABLE = yes
+# RAW_ENABLE = yes
+
+# LED task profiling counters, dumped over the console with SGV_PROF on the secret layer
+# OPT_DEFS += -DSGV_PERF=true
+
+# Key event capture, dumped over the console with SGV_CAPT on the secret layer and replayed with animation_replay
+# OPT_DEFS += -DSGV_CAPTURE=true
+
+# Key sequences step through the generated switch statements instead of the generated transition table
+# OPT_DEFS += -DSTATE_MACHINE_TABLE=false
@@ -3,10 +3,11 @@
 #include "state_machine.h"
 #include "animation/animation.h"
 
-/* Defined in state_machine.gen.c */
-state_cb_t state_machine_advance_internal(state_machine_t *state_machine,
-                                          const state_cb_t action_mapping[STATE_NAME(LAST)], uint16_t keycode,
-                                          uint16_t original_keycode);
+/* Defined in state_machine.gen.c, for the table backend */
+extern const uint8_t                      state_machine_class_count;
+extern const state_machine_node_t PROGMEM state_machine_nodes[];
+extern const uint8_t PROGMEM              state_machine_next[];
+uint8_t                                   state_machine_keycode_class(uint16_t keycode);
 
 static const uint32_t COMBO_BREAKER_TICKS = TIME_MS2I(2000) / 100; // This is broken??
 
@@ -39,6 +40,12 @@ static void set_sixty_nine(void) {
                 animation_color_special(ANIMATION_COLOR_TRANS),
                 animation_color_special(ANIMATION_COLOR_TRANS),
             },
+
+        .blend = ANIMATION_BLEND_REPLACE,
+        .alpha = 0xFF,
+
+        /* Typing keeps going after the combo, the feedback must not be pushed out by it */
+        .priority = ANIMATION_PRIORITY_FEEDBACK,
     };
 
     sgv_animation_add_animation(anim);
@@ -55,16 +62,70 @@ void state_machine_init(state_machine_t *state_machine) {
         .current_state_path = STATE_NAME(NONE),
         .terminal_state     = STATE_NAME(NONE),
         .position           = 0,
+        .node               = 0,
         .last_code          = KC_TRANSPARENT,
         .last_tick          = 0,
     };
 }
 
+/**
+ * @brief Node the table backend reaches from a node with a keycode class, or 0 if the class leads nowhere
+ */
+static inline uint8_t table_next(uint8_t node, uint8_t keycode_class) {
+    return pgm_read_byte(&state_machine_next[node * state_machine_class_count + keycode_class]);
+}
+
+state_cb_t state_machine_advance_table(state_machine_t *state_machine,
+                                       const state_cb_t action_mapping[STATE_NAME(LAST)], uint16_t keycode,
+                                       uint16_t original_keycode) {
+    state_t *state = &state_machine->state;
+    state_machine_tick(state_machine, true);
+
+    // Modifiers only extend the combo and do nothing
+    if (IS_MODIFIER_KEYCODE(original_keycode)) {
+        state->last_tick = timer_read32();
+        return action_mapping[STATE_NAME(NONE)];
+    }
+
+    uint8_t keycode_class = state_machine_keycode_class(keycode);
+    uint8_t next          = table_next(state->node, keycode_class);
+
+    // A key that breaks the combo can still start the next one
+    if (next == 0 && state->node != 0) {
+        state_machine_break_combo(state_machine, true);
+        next = table_next(0, keycode_class);
+    }
+
+    if (next == 0) {
+        state_machine_init(state_machine);
+        return action_mapping[STATE_NAME(NONE)];
+    }
+
+    const state_machine_node_t *node     = &state_machine_nodes[next];
+    state_machine_state_e       terminal = pgm_read_byte(&node->terminal);
+    bool                        fires    = pgm_read_byte(&node->fires);
+
+    state_machine->state = (state_t){
+        .current_state_path = pgm_read_byte(&node->path),
+        .terminal_state     = fires ? STATE_NAME(NONE) : terminal,
+        .position           = state->position + 1,
+        .node               = next,
+        .last_code          = keycode,
+        .last_tick          = timer_read32(),
+    };
+
+    return action_mapping[fires ? terminal : STATE_NAME(NONE)];
+}
+
 state_cb_t state_machine_advance(state_machine_t *state_machine, uint16_t keycode) {
     uint8_t  mods         = get_mods();
     uint16_t keycode_mods = ((uint16_t)((((mods >> 4) != 0) << 4) | (mods | (mods >> 4))) << 8);
 
+#if STATE_MACHINE_TABLE
+    return state_machine_advance_table(state_machine, action_mapping, keycode | keycode_mods, keycode);
+#else
     return state_machine_advance_internal(state_machine, action_mapping, keycode | keycode_mods, keycode);
+#endif
 }
 
 void state_machine_break_combo(state_machine_t *state_machine, bool keypress) {
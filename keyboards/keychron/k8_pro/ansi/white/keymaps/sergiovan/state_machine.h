@@ -1,5 +1,10 @@
 #pragma once
 
+/* Steps through the generated transition table. Define as false to use the generated switch statements instead */
+#ifndef STATE_MACHINE_TABLE
+#    define STATE_MACHINE_TABLE true
+#endif
+
 #define STATE_NAME(NAME) STATE_MACHINE_STATE_##NAME
 
 #define STATE_MACHINE_ENUM_VALUE(val) val
@@ -14,10 +19,18 @@ typedef struct {
     state_machine_state_e current_state_path;
     state_machine_state_e terminal_state;
     uint8_t               position;
+    uint8_t               node; /* Node of the table backend */
     uint16_t              last_code;
     uint32_t              last_tick;
 } state_t;
 
+/* Node of the table backend. Only bytes, so it can be read out of PROGMEM one at a time */
+typedef struct {
+    uint8_t path;     /* State the node is part of */
+    uint8_t terminal; /* Sequence that is complete once the node is reached, or STATE_NAME(NONE) */
+    uint8_t fires;    /* If reaching the node runs the terminal action right away, instead of when the combo breaks */
+} state_machine_node_t;
+
 typedef struct {
     state_t state;
 } state_machine_t;
@@ -26,3 +39,17 @@ void       state_machine_init(state_machine_t* state_machine);
 void       state_machine_tick(state_machine_t* state_machine, bool keypress);
 state_cb_t state_machine_advance(state_machine_t* state_machine, uint16_t keycode);
 void       state_machine_break_combo(state_machine_t* state_machine, bool keypress);
+
+/* Backends of `state_machine_advance`, which picks one with STATE_MACHINE_TABLE. Both take the keycode with the
+   modifiers folded in, and return the action of the sequence the keycode completes */
+
+/* Generated switch statements, defined in state_machine.gen.c */
+state_cb_t state_machine_advance_internal(state_machine_t* state_machine,
+                                          const state_cb_t action_mapping[STATE_NAME(LAST)], uint16_t keycode,
+                                          uint16_t original_keycode);
+
+/* Steps through the generated transition table. Every key is one class lookup and one table read, no matter how many
+   sequences there are */
+state_cb_t state_machine_advance_table(state_machine_t* state_machine,
+                                       const state_cb_t action_mapping[STATE_NAME(LAST)], uint16_t keycode,
+                                       uint16_t original_keycode);
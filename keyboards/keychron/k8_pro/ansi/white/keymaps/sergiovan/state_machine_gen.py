@@ -8,6 +8,12 @@ def state_name(name: str):
 def is_merged_state(name: str):
     return name.startswith(state_name(name)[:-2])
 
+def c_state_name(name: list[str]):
+    if len(name) == 1:
+        return state_name(name[0].upper())
+    else:
+        return state_name(STATE_MERGED + hex(hash(frozenset(name))).upper()[3:])
+
 class KeyCode:
     def __init__(self, c_str: str | list[str]):
         self.c_str = [c_str] if isinstance(c_str, str) else c_str
@@ -29,6 +35,9 @@ STATE_NONE = "NONE"
 STATE_LAST = "LAST"
 STATE_MERGED = "MERGED_"
 
+# Node ids of the table backend are bytes, and 0 means "no transition"
+TABLE_MAX_NODES = 256
+
 class State:
     def __init__(self, state_name: str | list[str], position: int, entry_code: str):
         self.state_name = [state_name] if isinstance(state_name, str) else state_name
@@ -112,12 +121,10 @@ class StateMachine:
         all_states: set[str] = set()
 
         def get_state_name(name: list[str]):
-            if len(name) == 1:
-                return state_name(name[0].upper())
-            else:
-                new_name = state_name(STATE_MERGED + hex(hash(frozenset(name))).upper()[3:])
+            new_name = c_state_name(name)
+            if len(name) > 1:
                 merged_states[new_name] = name
-                return new_name
+            return new_name
 
         state_stack = [self.start]
 
@@ -270,19 +277,110 @@ class StateMachine:
 
         return c_code, h_code
 
+    def gen_table(self):
+        """
+        Generates the table backend: every node of the machine gets a row with the node each keycode class leads to.
+        Keycodes that lead to the same nodes from everywhere share a class. Returns the C code and a size report
+        """
+        nodes: list[State] = []
+        ids: dict[int, int] = {}
+
+        queue = [self.start]
+        while len(queue):
+            state = queue.pop(0)
+            if id(state) in ids:
+                continue
+
+            ids[id(state)] = len(nodes)
+            nodes.append(state)
+            queue += state.exits.values()
+
+        if len(nodes) > TABLE_MAX_NODES:
+            raise ValueError(f"Too many nodes for the table backend: {len(nodes)}, at most {TABLE_MAX_NODES} fit")
+
+        keycodes = sorted({k for node in nodes for k in node.exits.keys()})
+
+        # Class 0 is every keycode that never leads anywhere
+        columns: dict[tuple[int, ...], int] = {}
+        keycode_class: dict[str, int] = {}
+        for keycode in keycodes:
+            column = tuple(ids[id(node.exits[keycode])] if keycode in node.exits else 0 for node in nodes)
+            keycode_class[keycode] = columns.setdefault(column, len(columns) + 1)
+
+        class_count = len(columns) + 1
+        rows = [[0] * class_count for _ in nodes]
+        for n, node in enumerate(nodes):
+            for keycode, to in node.exits.items():
+                rows[n][keycode_class[keycode]] = ids[id(to)]
+
+        c_code = f"""
+
+/* Table backend. {len(nodes)} nodes, {class_count} keycode classes. See `state_machine_advance_table` */
+
+const uint8_t state_machine_class_count = {class_count};
+
+uint8_t state_machine_keycode_class(uint16_t keycode) {{
+    switch (keycode) {{
+"""
+        for keycode in keycodes:
+            c_code += f"        case {keycode}:\n            return {keycode_class[keycode]};\n"
+        c_code += """        default:
+            return 0;
+    }
+}
+
+const state_machine_node_t PROGMEM state_machine_nodes[] = {
+"""
+        for node in nodes:
+            if len(node.terminal) > 1:
+                raise ValueError(f"State \"{c_state_name(node.state_name)}\" has too many terminals: {node.terminal}")
+
+            path = c_state_name(node.state_name)
+            terminal = c_state_name(node.terminal) if len(node.terminal) == 1 else state_name(STATE_NONE)
+            fires = 'true' if len(node.terminal) == 1 and path == terminal else 'false'
+            c_code += f"    {{{path}, {terminal}, {fires}}},\n"
+        c_code += """};
+
+const uint8_t PROGMEM state_machine_next[] = {
+"""
+        for n, row in enumerate(rows):
+            c_code += f"    /* {n} */ {', '.join(map(str, row))},\n"
+        c_code += "};\n"
+
+        transition_bytes = len(nodes) * class_count
+        node_bytes = len(nodes) * 3
+        report = f"State machine table: {len(nodes)} nodes x {class_count} keycode classes " \
+                 f"({len(keycodes)} keycodes), {transition_bytes} bytes of transitions, {node_bytes} bytes of nodes"
+
+        return c_code, report
+
 
 if __name__ == "__main__":
     import os
-    here = os.path.dirname(__file__)
-    os.chdir(here)
+    import sys
+
+    # Generated files go next to this script, or to the directory given as the first argument (the simulator
+    # build generates its own copy). Any other argument is one more sequence as name=keys, for machines that only
+    # the tests use
+    out = os.path.abspath(sys.argv[1]) if len(sys.argv) > 1 else None
+    here = os.path.dirname(os.path.abspath(__file__))
+    os.chdir(out or here)
 
     sm = StateMachine()
 
     sm.add_state("69", state_name="sixty_nine")
 
+    for arg in sys.argv[2:]:
+        name, keys = arg.split('=', 1)
+        sm.add_state(keys, state_name=name)
+
     c_code, h_code = sm.gen_c()
+    table_code, report = sm.gen_table()
+
+    print(report)
 
     with open('state_machine.gen.c', 'w') as f:
         f.write(c_code)
+        f.write(table_code)
     with open('state_machine.gen.h', 'w') as f:
         f.write(h_code)
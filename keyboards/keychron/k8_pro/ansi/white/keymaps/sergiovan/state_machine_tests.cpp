@@ -0,0 +1,162 @@
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstdlib>
+#include <utility>
+#include <vector>
+
+extern "C" {
+#include QMK_KEYBOARD_H
+#include "sim.h"
+#include "state_machine.h"
+}
+
+/* Milliseconds between keys typed as one combo. The combo breaks after 20 */
+constexpr uint32_t KEY_GAP = 10;
+
+/* Actions the steps ran, by the state they belong to */
+static std::vector<int> fired;
+
+template <int N>
+static void record() {
+    fired.push_back(N);
+}
+
+template <int... N>
+static constexpr std::array<state_cb_t, sizeof...(N)> make_mapping(std::integer_sequence<int, N...>) {
+    return {record<N>...};
+}
+
+/* Every state gets an action of its own, so the tests can tell which one a backend returned */
+static constexpr auto action_mapping = make_mapping(std::make_integer_sequence<int, STATE_NAME(LAST)>());
+
+typedef state_cb_t (*backend_fn)(state_machine_t* state_machine, const state_cb_t action_mapping[STATE_NAME(LAST)],
+                                 uint16_t keycode, uint16_t original_keycode);
+
+/**
+ * @brief A key typed at some point, `gap` milliseconds after the previous one
+ */
+struct typed_key_t {
+    uint16_t keycode;
+    uint32_t gap = KEY_GAP;
+};
+
+/**
+ * @brief What a backend did with one key
+ */
+struct step_t {
+    std::vector<int> fired;
+    uint8_t          path;
+    uint8_t          terminal;
+    uint8_t          position;
+};
+
+/**
+ * @brief The switch and table backends of the state machine take the same keys to the same states and actions. The
+ *        machine is generated with more sequences than the keymap has, some of them prefixes of others
+ */
+class StateMachineTest : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        sim_reset();
+    }
+
+    void TearDown() override {
+        sim_reset();
+    }
+
+    static std::vector<step_t> run(backend_fn backend, const std::vector<typed_key_t>& keys) {
+        sim_reset();
+        sim_set_time(1000);
+
+        state_machine_t state_machine;
+        state_machine_init(&state_machine);
+
+        std::vector<step_t> steps;
+        for (const typed_key_t& key : keys) {
+            sim_advance_time(key.gap);
+
+            fired.clear();
+            state_cb_t f = backend(&state_machine, action_mapping.data(), key.keycode, key.keycode);
+            if (f) f();
+
+            steps.push_back({fired, state_machine.state.current_state_path, state_machine.state.terminal_state,
+                             state_machine.state.position});
+        }
+        return steps;
+    }
+
+    /* Runs the keys through both backends, and returns what they did if it was the same */
+    static std::vector<step_t> expect_same(const std::vector<typed_key_t>& keys) {
+        std::vector<step_t> internal = run(state_machine_advance_internal, keys);
+        std::vector<step_t> table    = run(state_machine_advance_table, keys);
+
+        EXPECT_EQ(internal.size(), table.size());
+        for (size_t i = 0; i < internal.size() && i < table.size(); ++i) {
+            SCOPED_TRACE(i);
+            EXPECT_EQ(internal[i].fired, table[i].fired);
+            EXPECT_EQ(internal[i].path, table[i].path);
+            EXPECT_EQ(internal[i].terminal, table[i].terminal);
+            EXPECT_EQ(internal[i].position, table[i].position);
+        }
+        return table;
+    }
+
+    static bool fires(const step_t& step, state_machine_state_e state) {
+        return step.fired == std::vector<int>{state};
+    }
+};
+
+TEST_F(StateMachineTest, whole_sequences) {
+    std::vector<step_t> steps = expect_same({{KC_8}, {KC_8}});
+    EXPECT_TRUE(fires(steps.back(), STATE_NAME(EIGHTS)));
+
+    steps = expect_same({{KC_6}, {KC_9}, {KC_9}});
+    EXPECT_TRUE(fires(steps.back(), STATE_NAME(NINES)));
+
+    steps = expect_same({{KC_6}, {KC_8}, {KC_9}, {KC_6}});
+    EXPECT_TRUE(fires(steps.back(), STATE_NAME(LONG)));
+}
+
+TEST_F(StateMachineTest, partial_matches_that_fail) {
+    /* Halfway through LONG, then a key no sequence goes on with */
+    std::vector<step_t> steps = expect_same({{KC_6}, {KC_8}, {KC_A}});
+    EXPECT_EQ(steps.back().path, STATE_NAME(NONE));
+
+    /* Halfway through LONG, then a key that goes nowhere from there but starts another sequence */
+    steps = expect_same({{KC_6}, {KC_8}, {KC_8}});
+    EXPECT_NE(steps.back().path, STATE_NAME(NONE));
+    EXPECT_EQ(steps.back().position, 1);
+}
+
+TEST_F(StateMachineTest, matches_right_after_a_failure) {
+    /* The second 6 breaks LONG and starts SIXTY_NINE, which waits to see if NINES follows */
+    std::vector<step_t> steps = expect_same({{KC_6}, {KC_8}, {KC_6}, {KC_9}});
+    EXPECT_EQ(steps.back().terminal, STATE_NAME(SIXTY_NINE));
+
+    /* The second 8 breaks LONG and starts EIGHTS, which the third one completes */
+    steps = expect_same({{KC_6}, {KC_8}, {KC_8}, {KC_8}});
+    EXPECT_TRUE(fires(steps.back(), STATE_NAME(EIGHTS)));
+}
+
+TEST_F(StateMachineTest, modifiers_and_pauses) {
+    std::vector<step_t> steps = expect_same({{KC_8}, {KC_LSFT}, {KC_8}});
+    EXPECT_TRUE(fires(steps.back(), STATE_NAME(EIGHTS)));
+
+    /* Too long between keys, the second 8 starts over */
+    steps = expect_same({{KC_8}, {KC_8, 100}});
+    EXPECT_FALSE(fires(steps.back(), STATE_NAME(EIGHTS)));
+    EXPECT_EQ(steps.back().position, 1);
+}
+
+TEST_F(StateMachineTest, random_typing) {
+    const uint16_t keycodes[] = {KC_6, KC_8, KC_9, KC_A, KC_LSFT};
+
+    std::srand(69);
+    std::vector<typed_key_t> keys;
+    for (int i = 0; i < 5000; ++i) {
+        keys.push_back({keycodes[std::rand() % 5], std::rand() % 16 == 0 ? 100u : KEY_GAP});
+    }
+
+    expect_same(keys);
+}
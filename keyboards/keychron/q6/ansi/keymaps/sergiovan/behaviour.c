@@ -1,7 +1,10 @@
 #include QMK_KEYBOARD_H // A little comment to avoid weird underlines :)
 #include "animation/animation.h"
+#include "capture/capture.h"
 #include "common/common.h"
 #include "lib/lib8tion/lib8tion.h"
+#include "perf/perf.h"
+#include "trace/trace.h"
 
 #if DEBUG_FUNCTIONS
 COLOR debug_leds[10] = {0};
@@ -46,6 +49,8 @@ bool dip_switch_update_user(uint8_t index, bool active) {
  * @return false Do not
  */
 bool process_record_user(uint16_t keycode, keyrecord_t *record) {
+    CAPTURE_KEY(record);
+
     switch (keycode) {
         case LT(FN, SGV_FN):
             if (record->tap.count && record->event.pressed) {
@@ -93,9 +98,12 @@ bool process_record_user(uint16_t keycode, keyrecord_t *record) {
             break;
         case SGV_ERTH:
             if (record->event.pressed) {
-                sgv_animation_add_animation(
-                    animation_wave(g_led_config.matrix_co[record->event.key.row][record->event.key.col],
-                                   animation_color_hsv(random8(), 0xFF, 0xFF)));
+                animation_t anim =
+                    animation_ripple(g_led_config.matrix_co[record->event.key.row][record->event.key.col],
+                                     animation_color_hsv(random8(), 0xFF, 0xFF));
+                /* Keys pressed close together share one ripple, which adds up with what's below it */
+                anim.blend = ANIMATION_BLEND_ADD;
+                sgv_animation_add_animation(anim);
             } else {
                 clear_oneshot_layer_state(ONESHOT_PRESSED);
             }
@@ -111,13 +119,34 @@ bool process_record_user(uint16_t keycode, keyrecord_t *record) {
             break;
         case SGV_CAPS:
             if (record->event.pressed) {
-                sgv_animation_add_animation(
-                    animation_wave(g_led_config.matrix_co[record->event.key.row][record->event.key.col],
-                                   animation_color_hsv(random8(), 0xFF, 0xFF)));
+                animation_t anim =
+                    animation_ripple(g_led_config.matrix_co[record->event.key.row][record->event.key.col],
+                                     animation_color_hsv(random8(), 0xFF, 0xFF));
+                /* Keys pressed close together share one ripple, which adds up with what's below it */
+                anim.blend = ANIMATION_BLEND_ADD;
+                sgv_animation_add_animation(anim);
             } else {
                 clear_oneshot_layer_state(ONESHOT_PRESSED);
             }
             break;
+        case SGV_PROF:
+            if (record->event.pressed) {
+#if SGV_PERF
+                perf_print();
+#endif
+            } else {
+                clear_oneshot_layer_state(ONESHOT_PRESSED);
+            }
+            return false;
+        case SGV_CAPT:
+            if (record->event.pressed) {
+#if SGV_CAPTURE
+                capture_print();
+#endif
+            } else {
+                clear_oneshot_layer_state(ONESHOT_PRESSED);
+            }
+            return false;
         default:
             if (!record->event.pressed) {
                 clear_oneshot_layer_state(ONESHOT_PRESSED);
@@ -137,16 +166,22 @@ bool process_record_user(uint16_t keycode, keyrecord_t *record) {
  * @return layer_state_t The new layer to set
  */
 layer_state_t layer_state_set_user(layer_state_t state) {
+    CAPTURE_LAYER(state);
+
     layer_state_t highest = get_highest_layer(state);
     if (highest == BASE) {
-        sgv_animation_add_animation(animation_wave_solid(g_led_config.matrix_co[5][12], // FN
-                                                         animation_color_hsv(RGB_OFF)));
+        animation_t anim = animation_wave_solid(g_led_config.matrix_co[5][12], // FN
+                                                animation_color_hsv(RGB_OFF));
+        anim.priority    = ANIMATION_PRIORITY_INDICATOR;
+
+        sgv_animation_add_animation(anim);
     } else if (highest == FN) {
         animation_t anim                            = animation_wave_solid(g_led_config.matrix_co[5][12], // FN
                                                                            animation_color_hsv(HSV_RED));
         anim.keymap                                 = &keymaps[FN];
         anim.hsv_colors[ANIMATION_HSV_COLOR_BASE_N] = anim.hsv_colors[ANIMATION_HSV_COLOR_RESULT_N] =
             animation_color_hsv(HSV_BLUE);
+        anim.priority = ANIMATION_PRIORITY_INDICATOR;
 
         sgv_animation_add_animation(anim);
     } else if (highest == SECRET) {
@@ -159,6 +194,7 @@ layer_state_t layer_state_set_user(layer_state_t state) {
             anim.keymap                                   = &keymaps[SECRET];
             anim.hsv_colors[ANIMATION_HSV_COLOR_BASE_N]   = animation_color_special(ANIMATION_COLOR_RANDOM);
             anim.hsv_colors[ANIMATION_HSV_COLOR_RESULT_N] = animation_color_hsv(RGB_OFF);
+            anim.priority                                 = ANIMATION_PRIORITY_INDICATOR;
 
             sgv_animation_add_animation(anim);
         }
@@ -167,6 +203,16 @@ layer_state_t layer_state_set_user(layer_state_t state) {
     return state;
 }
 
+#if SGV_TRACE && defined(CONSOLE_ENABLE)
+/**
+ * @brief Called every loop of the main task
+ * Streams the animation trace over the console a few times a second
+ */
+void housekeeping_task_user(void) {
+    trace_stream();
+}
+#endif
+
 /**
  * @brief Called when about to shutdown, via soft reset or bootloader reset
  * Currently turns off all LEDs so they don't get stuck
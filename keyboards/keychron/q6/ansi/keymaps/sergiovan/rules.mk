@@ -4,3 +4,14 @@ LTO_ENABLE = yes
 
 # VIA_ENABLE = yes
 RGB_MATRIX_CUSTOM_USER = yes
+
+# Animation engine tracing, streamed over the console or drained over raw HID with trace2chrome.py
+# OPT_DEFS += -DSGV_TRACE=true
+# CONSOLE_ENABLE = yes
+# RAW_ENABLE = yes
+
+# LED task profiling counters, dumped over the console with SGV_PROF on the secret layer
+# OPT_DEFS += -DSGV_PERF=true
+
+# Key event capture, dumped over the console with SGV_CAPT on the secret layer and replayed with animation_replay
+# OPT_DEFS += -DSGV_CAPTURE=true
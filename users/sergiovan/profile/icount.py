@@ -0,0 +1,122 @@
+#!/bin/env python3
+
+"""
+Counts the instructions each firmware kernel takes on a Cortex-M4, by running icount_driver builds under user mode
+QEMU with the insn plugin. Compares the counts to a stored baseline and fails on regressions, and on kernels the
+baseline has no count for.
+
+    icount.py --qemu qemu-arm --plugin libinsn.so --baseline icount_baseline.txt [--update] driver.elf...
+"""
+
+import argparse
+import os
+import re
+import subprocess
+import sys
+import tempfile
+
+INSNS_RE = re.compile(r'insns: (\d+)')
+
+
+def run_driver(qemu: str, plugin: str, driver: str, *args: str) -> tuple[str, int]:
+    """Runs the driver once, returning what it printed and how many instructions it ran"""
+    with tempfile.NamedTemporaryFile('r', suffix='.log') as log:
+        result = subprocess.run([qemu, '-cpu', 'max', '-plugin', plugin, '-d', 'plugin', '-D', log.name, driver, *args],
+                                capture_output=True, text=True)
+        if result.returncode != 0:
+            raise RuntimeError(f"{os.path.basename(driver)} {' '.join(args)} failed: {result.stdout}{result.stderr}")
+
+        insns = sum(int(m) for m in INSNS_RE.findall(log.read()))
+        if not insns:
+            raise RuntimeError('The insn plugin did not report an instruction count')
+
+    return result.stdout, insns
+
+
+def measure(qemu: str, plugin: str, driver: str) -> dict[str, float]:
+    """Instructions per call of every kernel in the driver"""
+    board = os.path.splitext(os.path.basename(driver))[0].removeprefix('icount_')
+    listing, _ = run_driver(qemu, plugin, driver, 'list')
+
+    counts = {}
+    for line in listing.splitlines():
+        kernel, calls = line.split()
+        _, setup = run_driver(qemu, plugin, driver, kernel, 'setup')
+        _, run = run_driver(qemu, plugin, driver, kernel, 'run')
+        counts[f'{board}.{kernel}'] = (run - setup) / int(calls)
+
+    return counts
+
+
+def load_baseline(path: str) -> dict[str, float]:
+    baseline = {}
+    if not os.path.exists(path):
+        return baseline
+
+    with open(path) as f:
+        for line in f:
+            line = line.split('#')[0].strip()
+            if line:
+                name, count = line.split()
+                baseline[name] = float(count)
+
+    return baseline
+
+
+def save_baseline(path: str, counts: dict[str, float]):
+    with open(path, 'w') as f:
+        f.write('# Instructions per call on a Cortex-M4, from icount.py. '
+                'Regenerate with the update_icount_baseline target\n')
+        for name, count in sorted(counts.items()):
+            f.write(f'{name} {count:.1f}\n')
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description='Instruction counts of firmware kernels under qemu-arm')
+    parser.add_argument('--qemu', required=True, help='qemu-arm executable')
+    parser.add_argument('--plugin', required=True, help="QEMU's libinsn.so plugin")
+    parser.add_argument('--baseline', required=True, help='Baseline file to compare against')
+    parser.add_argument('--threshold', type=float, default=2.0, help='Allowed growth in percent before failing')
+    parser.add_argument('--update', action='store_true', help='Write the measured counts as the new baseline')
+    parser.add_argument('drivers', nargs='+', help='icount_driver builds to measure')
+    args = parser.parse_args()
+
+    counts = {}
+    for driver in args.drivers:
+        counts.update(measure(args.qemu, args.plugin, driver))
+
+    if args.update:
+        save_baseline(args.baseline, counts)
+        print(f'Wrote {len(counts)} counts to {args.baseline}')
+        return 0
+
+    baseline = load_baseline(args.baseline)
+    regressions = 0
+    missing = 0
+
+    print(f"{'kernel':<32} {'insns/call':>12} {'baseline':>12} {'change':>9}")
+    for name, count in counts.items():
+        if name not in baseline:
+            print(f"{name:<32} {count:>12.1f} {'-':>12} {'missing':>9}")
+            missing += 1
+            continue
+
+        change = (count - baseline[name]) / baseline[name] * 100 if baseline[name] else 0.0
+        flag = ''
+        if change > args.threshold:
+            flag = '  REGRESSION'
+            regressions += 1
+
+        print(f'{name:<32} {count:>12.1f} {baseline[name]:>12.1f} {change:>+8.1f}%{flag}')
+
+    if missing:
+        print(f'{missing} kernels have no baseline to compare against. Record one with the update_icount_baseline '
+              'target')
+    if regressions:
+        print(f'{regressions} kernels got more than {args.threshold}% slower')
+
+    return 1 if missing or regressions else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
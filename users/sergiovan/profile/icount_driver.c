@@ -0,0 +1,214 @@
+/* Freestanding driver that runs firmware kernels under user mode QEMU, for instruction counting.
+ *
+ * Built for the Cortex-M4 with arm-none-eabi-gcc, without the C library startup code. It talks to QEMU through
+ * plain Linux system calls. Instruction counts come from QEMU's insn plugin, so every kernel is run twice by
+ * icount.py: once with only its setup, and once with setup and calls. The difference divided by the amount of
+ * calls is the cost of one call.
+ *
+ *   icount_driver list              Prints every kernel and how many calls it makes
+ *   icount_driver <kernel> setup    Only runs the setup of the kernel
+ *   icount_driver <kernel> run      Runs the setup and all the calls of the kernel
+ */
+
+#include "animation/animation.h"
+#include "circular_buffer/circular_buffer.h"
+#include "noise/noise_gen.h"
+#include "sim.h"
+
+#include <stddef.h>
+#include <stdlib.h>
+
+/* Linux system calls */
+
+#define SYS_EXIT 1
+#define SYS_WRITE 4
+
+static long sys_call3(long number, long a, long b, long c) {
+    register long r0 __asm__("r0") = a;
+    register long r1 __asm__("r1") = b;
+    register long r2 __asm__("r2") = c;
+    register long r7 __asm__("r7") = number;
+
+    __asm__ volatile("svc #0" : "+r"(r0) : "r"(r1), "r"(r2), "r"(r7) : "memory");
+
+    return r0;
+}
+
+static void write_str(const char *str) {
+    sys_call3(SYS_WRITE, 1, (long)str, strlen(str));
+}
+
+static void write_u32(uint32_t value) {
+    char  buffer[11];
+    char *p = &buffer[sizeof buffer - 1];
+
+    *p = '\0';
+    do {
+        *--p = '0' + value % 10;
+        value /= 10;
+    } while (value);
+
+    write_str(p);
+}
+
+/* The engine allocates its queue with malloc, which ends up here */
+
+static uint8_t heap[4096];
+static size_t  heap_used = 0;
+
+void *_sbrk(ptrdiff_t increment) {
+    if (heap_used + increment > sizeof heap) {
+        return (void *)-1;
+    }
+
+    void *old = &heap[heap_used];
+    heap_used += increment;
+    return old;
+}
+
+/* Sink so the compiler can't drop the kernel calls */
+static volatile uint32_t sink = 0;
+
+/* Kernels */
+
+typedef struct kernel {
+    const char *name;
+    uint32_t    calls; /* Calls per measurement */
+    void (*setup)(void);
+    void (*run)(uint32_t i);
+} kernel_t;
+
+static void setup_none(void) {}
+
+static void run_perlin2d(uint32_t i) {
+    sink += perlin2d_fixed(i % 225, (i * 7) % 65, 0x1666);
+}
+
+static void run_simplex2d(uint32_t i) {
+    sink += simplex2d_fixed(i % 225, (i * 7) % 65, 0x1666);
+}
+
+static void run_perlin3d(uint32_t i) {
+    sink += perlin3d_fixed(i % 225, (i * 7) % 65, i, 0x1666);
+}
+
+static void run_simplex3d(uint32_t i) {
+    sink += simplex3d_fixed(i % 225, (i * 7) % 65, i, 0x1666);
+}
+
+/* Same queue the engine uses */
+static uint8_t            cb_mem[sizeof(animation_t) * 16];
+static circular_buffer_t *cb = NULL;
+static animation_t        cb_elem;
+
+static void setup_circular_buffer(void) {
+    cb = malloc(circular_buffer_type_size);
+    circular_buffer_new(cb, circular_buffer_type_size, cb_mem, sizeof cb_mem, 16, sizeof(animation_t));
+    cb_elem = animation_wave(40, animation_color_hsv(0x80, 0xFF, 0xFF));
+}
+
+static void run_circular_buffer_push(uint32_t i) {
+    cb_elem.led_index = i;
+    sink += circular_buffer_push(cb, &cb_elem);
+}
+
+/* Whole frames, through every LED batch. Time does not move, so every call renders the same frame */
+
+static void setup_frame_idle(void) {
+    sim_reset();
+    sim_set_time(1000);
+    sim_render_frame(true);
+    sim_advance_time(3000);
+    sgv_animation_add_animation(animation_clear());
+    sim_render_frame(false);
+}
+
+static void setup_frame_wave(void) {
+    setup_frame_idle();
+    sgv_animation_add_animation(animation_wave(40, animation_color_hsv(0x80, 0xFF, 0xFF)));
+    sim_advance_time(150);
+    sim_render_frame(false);
+}
+
+static void setup_frame_shimmer(void) {
+    setup_frame_idle();
+    sgv_animation_add_animation(animation_shimmer());
+    sim_advance_time(16);
+    sim_render_frame(false);
+}
+
+static void setup_frame_full(void) {
+    setup_frame_idle();
+    for (uint8_t i = 0; i < 16; ++i) {
+        sgv_animation_add_animation(animation_wave(i * 5, animation_color_hsv(i * 16, 0xFF, 0xFF)));
+        sim_advance_time(8);
+    }
+    sim_render_frame(false);
+}
+
+static void run_frame(uint32_t i) {
+    (void)i;
+    sink += sim_render_frame(false)->writes;
+}
+
+static const kernel_t kernels[] = {
+    {"perlin2d_fixed", 1000, setup_none, run_perlin2d},
+    {"simplex2d_fixed", 1000, setup_none, run_simplex2d},
+    {"perlin3d_fixed", 1000, setup_none, run_perlin3d},
+    {"simplex3d_fixed", 1000, setup_none, run_simplex3d},
+    {"circular_buffer_push", 16, setup_circular_buffer, run_circular_buffer_push},
+    {"frame_idle", 20, setup_frame_idle, run_frame},
+    {"frame_wave", 20, setup_frame_wave, run_frame},
+    {"frame_shimmer", 20, setup_frame_shimmer, run_frame},
+    {"frame_full", 20, setup_frame_full, run_frame},
+};
+
+#define KERNEL_COUNT (sizeof kernels / sizeof kernels[0])
+
+static int icount_main(int argc, char **argv) {
+    if (argc == 2 && strcmp(argv[1], "list") == 0) {
+        for (uint8_t k = 0; k < KERNEL_COUNT; ++k) {
+            write_str(kernels[k].name);
+            write_str(" ");
+            write_u32(kernels[k].calls);
+            write_str("\n");
+        }
+        return 0;
+    }
+
+    if (argc != 3) {
+        write_str("Usage: icount_driver list | <kernel> setup|run\n");
+        return 1;
+    }
+
+    for (uint8_t k = 0; k < KERNEL_COUNT; ++k) {
+        if (strcmp(argv[1], kernels[k].name) != 0) {
+            continue;
+        }
+
+        kernels[k].setup();
+        if (strcmp(argv[2], "run") == 0) {
+            for (uint32_t i = 0; i < kernels[k].calls; ++i) {
+                kernels[k].run(i);
+            }
+        }
+        return 0;
+    }
+
+    write_str("Unknown kernel\n");
+    return 1;
+}
+
+__attribute__((noreturn)) void icount_start(long *stack) {
+    int status = icount_main(stack[0], (char **)&stack[1]);
+
+    sys_call3(SYS_EXIT, status, 0, 0);
+    __builtin_unreachable();
+}
+
+/* Entry point. The kernel leaves argc and argv on the stack */
+__attribute__((naked, noreturn)) void _start(void) {
+    __asm__ volatile(
+        "mov r0, sp\n"
+        "bl icount_start\n");
+}
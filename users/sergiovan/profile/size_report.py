@@ -0,0 +1,105 @@
+#!/bin/env python3
+
+"""
+Reports flash and RAM used by each module of the userspace, per board configuration, and fails when a budget in the
+budget file is exceeded.
+
+    size_report.py --nm arm-none-eabi-nm --budget size_budget.txt config:module:object.o...
+
+Budget lines are `<config>.<module> <section> <bytes>`, where section is one of text, rodata, data, bss, flash or
+ram. Flash is text + rodata + data, RAM is data + bss. `*` as module applies the budget to the whole configuration.
+"""
+
+import argparse
+import subprocess
+import sys
+from collections import defaultdict
+
+SECTIONS = ['text', 'rodata', 'data', 'bss']
+
+# nm symbol types, lowercase for local symbols
+NM_SECTIONS = {'t': 'text', 'r': 'rodata', 'd': 'data', 'b': 'bss', 'c': 'bss'}
+
+
+def read_symbols(nm: str, obj: str) -> list[tuple[str, str, int]]:
+    """(section, name, size) of every sized symbol in an object"""
+    output = subprocess.run([nm, '--print-size', '--size-sort', obj], capture_output=True, text=True, check=True)
+
+    symbols = []
+    for line in output.stdout.splitlines():
+        parts = line.split()
+        if len(parts) != 4:
+            continue
+        _, size, kind, name = parts
+        section = NM_SECTIONS.get(kind.lower())
+        if section:
+            symbols.append((section, name, int(size, 16)))
+
+    return symbols
+
+
+def totals(symbols: list[tuple[str, str, int]]) -> dict[str, int]:
+    result = {section: 0 for section in SECTIONS}
+    for section, _, size in symbols:
+        result[section] += size
+
+    result['flash'] = result['text'] + result['rodata'] + result['data']
+    result['ram'] = result['data'] + result['bss']
+    return result
+
+
+def load_budget(path: str) -> dict[tuple[str, str], int]:
+    budget = {}
+    with open(path) as f:
+        for line in f:
+            line = line.split('#')[0].strip()
+            if line:
+                name, section, size = line.split()
+                budget[(name, section)] = int(size)
+    return budget
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description='Flash and RAM per module and board configuration')
+    parser.add_argument('--nm', default='nm', help='nm executable for the target')
+    parser.add_argument('--budget', help='Budget file to check against')
+    parser.add_argument('--symbols', type=int, default=8, help='Largest symbols to list per module')
+    parser.add_argument('objects', nargs='+', help='config:module:object triplets')
+    args = parser.parse_args()
+
+    modules = defaultdict(list)
+    for entry in args.objects:
+        config, module, obj = entry.split(':', 2)
+        modules[(config, module)].extend(read_symbols(args.nm, obj))
+
+    sizes = {}
+    for (config, module), symbols in sorted(modules.items()):
+        sizes[f'{config}.{module}'] = totals(symbols)
+
+        print(f'{config}.{module}')
+        print('  ' + '  '.join(f'{section} {sizes[f"{config}.{module}"][section]:>6}' for section in SECTIONS))
+        for section, name, size in sorted(symbols, key=lambda s: s[2], reverse=True)[:args.symbols]:
+            print(f'    {size:>6} {section:<7} {name}')
+
+    for config in sorted({config for config, _ in modules}):
+        sizes[f'{config}.*'] = totals([s for (c, _), symbols in modules.items() if c == config for s in symbols])
+        total = sizes[f'{config}.*']
+        print(f'{config} total: flash {total["flash"]}, ram {total["ram"]}')
+
+    if not args.budget:
+        return 0
+
+    over = 0
+    for (name, section), limit in load_budget(args.budget).items():
+        if name not in sizes:
+            continue
+        used = sizes[name][section]
+        if used > limit:
+            print(f'OVER BUDGET: {name} {section} is {used} bytes, budget is {limit}')
+            over += 1
+
+    return 1 if over else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,154 @@
+#!/bin/env python3
+
+"""
+Turns animation engine traces into Chrome trace JSON, to open in chrome://tracing or ui.perfetto.dev.
+
+    trace2chrome.py [-o trace.json] dump.txt...           Console logs or animation_sim -t output
+    trace2chrome.py [-o trace.json] --hidraw /dev/hidrawN  Drains the keyboard over raw HID
+
+Text dumps are read line by line, and only `trace <time> <type> <arg> <data>` lines are used, so whole console logs
+can be given as they are. Event types and arguments match trace_event_type_e in src/trace/trace.h.
+"""
+
+import argparse
+import json
+import os
+import re
+import struct
+import sys
+
+TRACE_RE = re.compile(r'trace (\d+) (\d+) (\d+) (\d+)')
+DROPPED_RE = re.compile(r'trace dropped (\d+)')
+
+# trace_event_type_e
+FRAME_BEGIN, FRAME_END, APPLY, PUSH, EVICT, PRUNE, CANCEL, DROP, REJECT, ABSORB = range(10)
+
+# animation_type_e
+ANIMATION_TYPES = ['SOLID_KEY', 'SOLID_ALL', 'SHIMMER', 'WAVE', 'RIPPLE']
+
+# animation_priority_e
+ANIMATION_PRIORITIES = ['COSMETIC', 'AMBIENT', 'FEEDBACK', 'INDICATOR']
+
+# apply_res_e in animation_kernel.h
+APPLY_RESULTS = ['APPLY_OK', 'APPLY_CLEAR_THIS', 'APPLY_NEW_BASE', 'BECOME_FIRST', 'BECOME_NEXT']
+
+# Raw HID reports are 32 bytes. The first byte is the amount of events in the report
+HID_REPORT_SIZE = 32
+HID_EVENT = struct.Struct('<IBBH')
+
+# Threads events are put on in the viewer
+TID_FRAME, TID_APPLY, TID_QUEUE = range(3)
+
+
+def name_of(names: list[str], value: int) -> str:
+    return names[value] if value < len(names) else str(value)
+
+
+def read_text(path: str) -> list[tuple[int, int, int, int]]:
+    events = []
+    with open(path) as f:
+        for line in f:
+            if m := DROPPED_RE.search(line):
+                if int(m.group(1)):
+                    print(f'{path}: {m.group(1)} events were dropped by the keyboard', file=sys.stderr)
+            elif m := TRACE_RE.search(line):
+                events.append(tuple(int(g) for g in m.groups()))
+    return events
+
+
+def read_hidraw(path: str) -> list[tuple[int, int, int, int]]:
+    events = []
+    fd = os.open(path, os.O_RDWR)
+    try:
+        while True:
+            # Report ID 0, then the report
+            os.write(fd, b'\0T' + bytes(HID_REPORT_SIZE - 1))
+            report = os.read(fd, HID_REPORT_SIZE)
+            count = report[0]
+            if not count:
+                break
+            for i in range(count):
+                events.append(HID_EVENT.unpack_from(report, 1 + i * HID_EVENT.size))
+    finally:
+        os.close(fd)
+    return events
+
+
+def unwrap(events: list[tuple[int, int, int, int]]) -> list[tuple[int, int, int, int]]:
+    """Timestamps are 32 bit microseconds, which wrap every 71 minutes"""
+    result = []
+    offset = 0
+    last = None
+    for time, kind, arg, data in events:
+        if last is not None and time + offset < last - (1 << 31):
+            offset += 1 << 32
+        last = time + offset
+        result.append((last, kind, arg, data))
+    return result
+
+
+def to_chrome(events: list[tuple[int, int, int, int]]) -> list[dict]:
+    out = [
+        {'ph': 'M', 'pid': 0, 'name': 'process_name', 'args': {'name': 'animation engine'}},
+        {'ph': 'M', 'pid': 0, 'tid': TID_FRAME, 'name': 'thread_name', 'args': {'name': 'frames'}},
+        {'ph': 'M', 'pid': 0, 'tid': TID_APPLY, 'name': 'thread_name', 'args': {'name': 'animations'}},
+        {'ph': 'M', 'pid': 0, 'tid': TID_QUEUE, 'name': 'thread_name', 'args': {'name': 'queue'}},
+    ]
+
+    for time, kind, arg, data in events:
+        event = {'pid': 0, 'ts': time}
+        if kind in (FRAME_BEGIN, FRAME_END):
+            event.update(ph='B' if kind == FRAME_BEGIN else 'E', tid=TID_FRAME, name=f'batch {arg}')
+            out.append({'pid': 0, 'ts': time, 'ph': 'C', 'name': 'queue length', 'args': {'length': data}})
+        elif kind == APPLY:
+            event.update(ph='X', tid=TID_APPLY, dur=data, name=name_of(ANIMATION_TYPES, arg))
+        elif kind == PUSH:
+            event.update(ph='i', s='t', tid=TID_QUEUE, name=f'push {name_of(ANIMATION_TYPES, arg)}',
+                         args={'length': data})
+        elif kind == EVICT:
+            event.update(ph='i', s='t', tid=TID_QUEUE, name=f'evict {name_of(ANIMATION_TYPES, arg)}',
+                         args={'priority': name_of(ANIMATION_PRIORITIES, data)})
+        elif kind == PRUNE:
+            event.update(ph='i', s='t', tid=TID_QUEUE, name=name_of(APPLY_RESULTS, arg), args={'dropped': data})
+        elif kind == CANCEL:
+            event.update(ph='i', s='t', tid=TID_QUEUE, name=f'cancel {name_of(ANIMATION_TYPES, arg)}',
+                         args={'length': data})
+        elif kind in (DROP, REJECT):
+            event.update(ph='i', s='t', tid=TID_QUEUE,
+                         name=f'{"drop" if kind == DROP else "reject"} {name_of(ANIMATION_TYPES, arg)}',
+                         args={'priority': name_of(ANIMATION_PRIORITIES, data)})
+        elif kind == ABSORB:
+            event.update(ph='i', s='t', tid=TID_QUEUE, name=f'absorb {name_of(ANIMATION_TYPES, arg)}',
+                         args={'origins': data})
+        else:
+            event.update(ph='i', s='t', tid=TID_QUEUE, name=f'unknown {kind}', args={'arg': arg, 'data': data})
+        out.append(event)
+
+    return out
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description='Animation engine traces to Chrome trace JSON')
+    parser.add_argument('-o', '--output', help='Output file, stdout by default')
+    parser.add_argument('--hidraw', help='Drain the trace from this raw HID device instead of reading dumps')
+    parser.add_argument('dumps', nargs='*', help='Console logs or animation_sim trace files')
+    args = parser.parse_args()
+
+    if bool(args.hidraw) == bool(args.dumps):
+        parser.error('Give either dump files or --hidraw')
+
+    events = read_hidraw(args.hidraw) if args.hidraw else [e for dump in args.dumps for e in read_text(dump)]
+    trace = {'traceEvents': to_chrome(unwrap(events)), 'displayTimeUnit': 'ms'}
+
+    if args.output:
+        with open(args.output, 'w') as f:
+            json.dump(trace, f)
+    else:
+        json.dump(trace, sys.stdout)
+
+    print(f'{len(events)} events', file=sys.stderr)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
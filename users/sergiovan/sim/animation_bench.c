@@ -0,0 +1,104 @@
+#include <stdio.h>
+#include <time.h>
+
+#include "animation/animation.h"
+#include "scenarios.h"
+
+/* Milliseconds between frames, and how many times each scenario is run */
+#define STEP 16
+#define RUNS 20
+
+typedef struct type_stats {
+    uint64_t ns;    /* Time spent applying animations of this type */
+    uint64_t calls; /* Amount of times an animation of this type was applied */
+} type_stats_t;
+
+typedef struct breakdown {
+    uint64_t     started; /* When the current animation started being applied */
+    type_stats_t types[ANIMATION_TYPE_COUNT];
+} breakdown_t;
+
+static const char *type_names[ANIMATION_TYPE_COUNT] = {
+    [SOLID_KEY] = "SOLID_KEY",
+    [SOLID_ALL] = "SOLID_ALL",
+    [SHIMMER]   = "SHIMMER",
+    [WAVE]      = "WAVE",
+    [RIPPLE]    = "RIPPLE",
+};
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void on_animation(void *arg, uint8_t type, bool end) {
+    breakdown_t *breakdown = arg;
+
+    if (!end) {
+        breakdown->started = now_ns();
+    } else if (type < ANIMATION_TYPE_COUNT) {
+        breakdown->types[type].ns += now_ns() - breakdown->started;
+        breakdown->types[type].calls++;
+    }
+}
+
+static void bench(const sim_scenario_t *scenario) {
+    /* Warm up caches */
+    sim_scenario_run(scenario, STEP, NULL, NULL);
+
+    /* Whole frames, without the hook getting in the way */
+    uint32_t frames = 0;
+    uint64_t start  = now_ns();
+    for (uint32_t run = 0; run < RUNS; ++run) {
+        frames += sim_scenario_run(scenario, STEP, NULL, NULL);
+    }
+    double ns_per_frame = (double)(now_ns() - start) / frames;
+
+    /* Same runs again, timing each animation type */
+    breakdown_t breakdown = {0};
+    sim_set_animation_hook(on_animation, &breakdown);
+    for (uint32_t run = 0; run < RUNS; ++run) {
+        sim_scenario_run(scenario, STEP, NULL, NULL);
+    }
+    sim_set_animation_hook(NULL, NULL);
+
+    printf("%-10s %8u %12.0f", scenario->name, frames / RUNS, ns_per_frame);
+    for (uint8_t type = 0; type < ANIMATION_TYPE_COUNT; ++type) {
+        type_stats_t *stats = &breakdown.types[type];
+        if (stats->calls) {
+            printf(" %8.2f %8.0f", (double)stats->calls / frames, (double)stats->ns / stats->calls);
+        } else {
+            printf(" %8s %8s", "-", "-");
+        }
+    }
+    printf("\n");
+}
+
+int main(int argc, char **argv) {
+    printf("%s, %u LEDs, one frame every %ums, %u runs per scenario\n", SIM_BOARD_NAME, SIM_FRAME_LEDS, STEP, RUNS);
+    printf("Per type: animations applied per frame, then ns per animation\n\n");
+
+    printf("%-10s %8s %12s", "scenario", "frames", "ns/frame");
+    for (uint8_t type = 0; type < ANIMATION_TYPE_COUNT; ++type) {
+        printf(" %17s", type_names[type]);
+    }
+    printf("\n");
+
+    if (argc > 1) {
+        for (int i = 1; i < argc; ++i) {
+            const sim_scenario_t *scenario = sim_scenario_find(argv[i]);
+            if (!scenario) {
+                fprintf(stderr, "Unknown scenario '%s'\n", argv[i]);
+                return 1;
+            }
+            bench(scenario);
+        }
+    } else {
+        for (const sim_scenario_t *scenario = sim_scenarios; scenario->name; ++scenario) {
+            bench(scenario);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,446 @@
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "animation/animation.h"
+#include "scenarios.h"
+
+/* Milliseconds between frames, same as the other simulator tools */
+#define STEP 16
+
+/* Scripts add animations during this many milliseconds, then run until everything they started is over */
+#define SCRIPT_MS 3000
+
+/* Longest an animation can be scheduled in the future */
+#define FUTURE_MS 1500
+
+/* Slowest matrix speed scripts run at. Waves take 400ms at full speed and about 100 seconds at speed 0 */
+#define MIN_SPEED 8
+
+/* Different keymap masks per script */
+#define SCRIPT_MASKS 4
+
+/* Failures printed in full, the rest are only counted */
+#define MAX_REPORTS 10
+
+/**
+ * @brief Deterministic random numbers for one script, independent of the thread that runs it
+ */
+typedef struct fuzz_rand {
+    uint64_t state;
+} fuzz_rand_t;
+
+/**
+ * @brief Everything one run of a script needs. Two runs of the same script generate the same animations
+ */
+typedef struct fuzz_script {
+    fuzz_rand_t rand;
+    uint32_t    id;
+    uint8_t     speed;
+    uint32_t    duration; /* Milliseconds until every animation is over */
+    uint32_t    next;     /* When the next animation is added */
+
+    animation_handle_t last; /* Last animation added, cancelled, retimed or recolored now and then */
+
+    uint16_t masks[SCRIPT_MASKS][MATRIX_ROWS][MATRIX_COLS];
+} fuzz_script_t;
+
+/**
+ * @brief Frames of the reference run of a script, compared against the optimized run
+ */
+typedef struct frame_log {
+    sim_frame_t *frames;
+    uint32_t     count;
+    uint32_t     capacity;
+} frame_log_t;
+
+typedef struct fuzz_options {
+    uint32_t scripts;
+    uint32_t threads;
+    uint32_t seed;
+    int64_t  only; /* Single script to run, or -1 */
+    bool     verbose;
+} fuzz_options_t;
+
+typedef struct fuzz_pool {
+    const fuzz_options_t *options;
+
+    atomic_uint_fast32_t next;     /* Next script to hand out */
+    atomic_uint_fast64_t frames;   /* Frames rendered, both runs */
+    atomic_uint_fast32_t failures; /* Scripts that broke an invariant or differed from the reference */
+
+    pthread_mutex_t report_lock;
+} fuzz_pool_t;
+
+static void usage(const char *self) {
+    fprintf(stderr, "Usage: %s [-n scripts] [-j threads] [-s seed] [-i script] [-v]\n", self);
+    fprintf(stderr, "  Runs random animation scripts on every core, checking the engine invariants after every frame\n");
+    fprintf(stderr, "  and comparing every frame against the reference kernels\n");
+    fprintf(stderr, "  -i reruns a single script of a seed, as numbered in the failure reports\n");
+}
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* splitmix64, so nearby script ids still give unrelated scripts */
+static uint32_t fuzz_next(fuzz_rand_t *rand) {
+    uint64_t z = (rand->state += 0x9E3779B97F4A7C15ULL);
+    z          = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z          = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return (uint32_t)((z ^ (z >> 31)) >> 32);
+}
+
+static uint32_t fuzz_below(fuzz_rand_t *rand, uint32_t max) {
+    return fuzz_next(rand) % max;
+}
+
+static uint8_t fuzz_u8(fuzz_rand_t *rand) {
+    return fuzz_next(rand) & 0xFF;
+}
+
+static bool fuzz_chance(fuzz_rand_t *rand, uint8_t in_256) {
+    return fuzz_u8(rand) < in_256;
+}
+
+/**
+ * @brief Any color an animation can have: plain, brightness only, off, or one of the special ones
+ */
+static animation_color_t fuzz_color(fuzz_rand_t *rand) {
+    switch (fuzz_below(rand, 4)) {
+        case 0:
+            return animation_color_hsv(fuzz_u8(rand), fuzz_u8(rand), fuzz_u8(rand));
+        case 1:
+            return animation_color_val(fuzz_u8(rand));
+        case 2:
+            return animation_color_hsv(fuzz_u8(rand), fuzz_u8(rand), fuzz_chance(rand, 0x80) ? 0 : 0xFF);
+        default:
+            return animation_color_special(fuzz_below(rand, ANIMATION_COLOR_SHIMMER + 1));
+    }
+}
+
+/**
+ * @brief One animation out of any of the constructors, maybe masked by a keymap, starting later or blended
+ */
+static animation_t fuzz_animation(fuzz_script_t *script) {
+    fuzz_rand_t *rand = &script->rand;
+    uint8_t      led  = fuzz_below(rand, SIM_FRAME_LEDS);
+    animation_t  animation;
+
+    switch (fuzz_below(rand, 9)) {
+        case 0:
+            animation = animation_clear();
+            break;
+        case 1:
+            animation = animation_clear_key(led);
+            break;
+        case 2:
+            animation = animation_solid(fuzz_u8(rand), fuzz_u8(rand), fuzz_u8(rand));
+            break;
+        case 3:
+            animation = animation_solid_key(led, fuzz_u8(rand), fuzz_u8(rand), fuzz_u8(rand));
+            break;
+        case 4:
+            animation = animation_wave(led, fuzz_color(rand));
+            break;
+        case 5:
+            animation = animation_wave_solid(led, fuzz_color(rand));
+            break;
+        case 6:
+            animation = animation_wave_solid_2(led, fuzz_color(rand), fuzz_color(rand));
+            break;
+        case 7:
+            animation = animation_ripple(led, fuzz_color(rand));
+            break;
+        default:
+            animation = animation_shimmer();
+            break;
+    }
+
+    if (fuzz_chance(rand, 0x40)) {
+        animation.keymap                                  = &script->masks[fuzz_below(rand, SCRIPT_MASKS)];
+        animation.hsv_colors[ANIMATION_HSV_COLOR_BASE_N]   = fuzz_color(rand);
+        animation.hsv_colors[ANIMATION_HSV_COLOR_RESULT_N] = fuzz_color(rand);
+    }
+
+    if (fuzz_chance(rand, 0x40)) {
+        animation.ticks += fuzz_below(rand, FUTURE_MS);
+    }
+
+    if (fuzz_chance(rand, 0x40)) {
+        animation.blend = fuzz_below(rand, ANIMATION_BLEND_COUNT);
+        animation.alpha = fuzz_u8(rand);
+    }
+
+    /* Mostly cosmetic, like the keymaps, so the important ones have something to push out */
+    if (fuzz_chance(rand, 0x40)) {
+        animation.priority = fuzz_below(rand, ANIMATION_PRIORITY_COUNT);
+    }
+
+    return animation;
+}
+
+/**
+ * @brief Sets up a script from its id. Everything random about it comes from the seed and the id
+ */
+static void script_begin(fuzz_script_t *script, uint32_t seed, uint32_t id) {
+    script->rand  = (fuzz_rand_t){.state = ((uint64_t)seed << 32) | id};
+    script->id    = id;
+    script->speed = MIN_SPEED + fuzz_below(&script->rand, 256 - MIN_SPEED);
+    script->next  = 0;
+    script->last  = ANIMATION_HANDLE_NONE;
+
+    /* Every wave has to be over once the last animation is added, wherever it starts */
+    uint32_t wave_ms = (400 * 256) / (1 + script->speed);
+    script->duration = SCRIPT_MS + FUTURE_MS + wave_ms + 2 * STEP;
+
+    for (uint8_t m = 0; m < SCRIPT_MASKS; ++m) {
+        for (uint8_t r = 0; r < MATRIX_ROWS; ++r) {
+            for (uint8_t c = 0; c < MATRIX_COLS; ++c) {
+                script->masks[m][r][c] = fuzz_chance(&script->rand, 0x80) ? KC_A : KC_NO;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Changes the last animation added through its handle, if it's still queued. Retimed animations start again
+ *        now, so they are over by the end of the script like the rest
+ */
+static void fuzz_touch(fuzz_script_t *script) {
+    fuzz_rand_t *rand = &script->rand;
+
+    switch (fuzz_below(rand, 5)) {
+        case 0:
+            sgv_animation_cancel(script->last);
+            break;
+        case 1:
+            sgv_animation_retime(script->last, timer_read32());
+            break;
+        case 2:
+            /* Half of the overlays stay until cleared */
+            sgv_animation_overlay_set(fuzz_below(rand, SIM_FRAME_LEDS), fuzz_color(rand),
+                                      fuzz_chance(rand, 0x80) ? 0 : fuzz_below(rand, 3000));
+            break;
+        case 3:
+            sgv_animation_overlay_clear(fuzz_below(rand, SIM_FRAME_LEDS));
+            break;
+        default:
+            sgv_animation_recolor(script->last, fuzz_below(rand, ANIMATION_HSV_COLOR_COUNT), fuzz_color(rand));
+            break;
+    }
+}
+
+/**
+ * @brief Adds the animations of the script that are due by `elapsed`
+ */
+static void script_step(fuzz_script_t *script, uint32_t elapsed) {
+    while (script->next <= elapsed && script->next < SCRIPT_MS) {
+        if (fuzz_chance(&script->rand, 0x20)) {
+            fuzz_touch(script);
+        }
+
+        script->last = sgv_animation_add_animation(fuzz_animation(script));
+        script->next += fuzz_below(&script->rand, 300);
+    }
+}
+
+static void report(fuzz_pool_t *pool, uint32_t id, uint32_t frame, const char *what) {
+    uint32_t failures = atomic_fetch_add(&pool->failures, 1);
+    if (failures >= MAX_REPORTS) {
+        return;
+    }
+
+    pthread_mutex_lock(&pool->report_lock);
+    fprintf(stderr, "script %u, frame %u: %s\n", id, frame, what);
+    pthread_mutex_unlock(&pool->report_lock);
+}
+
+static bool log_frame(frame_log_t *log, const sim_frame_t *frame) {
+    if (log->count == log->capacity) {
+        uint32_t     capacity = log->capacity ? log->capacity * 2 : 1024;
+        sim_frame_t *frames   = realloc(log->frames, capacity * sizeof(sim_frame_t));
+        if (!frames) {
+            return false;
+        }
+        log->frames   = frames;
+        log->capacity = capacity;
+    }
+
+    log->frames[log->count++] = *frame;
+    return true;
+}
+
+/**
+ * @brief Runs one script from a freshly reset simulator
+ *
+ * @param reference If the reference kernels are used. Reference frames are logged, the rest are compared to them
+ * @return true If every invariant held and every frame matched the reference
+ * @return false Otherwise. The failure was already reported
+ */
+static bool run_script(fuzz_pool_t *pool, uint32_t id, bool reference, frame_log_t *log) {
+    fuzz_script_t script;
+    script_begin(&script, pool->options->seed, id);
+
+    sim_reset();
+    sim_set_time(SIM_START_TIME);
+    sim_set_matrix_speed(script.speed);
+    sgv_animation_set_reference_kernels(reference);
+
+    if (reference) {
+        log->count = 0;
+    }
+
+    uint32_t frame = 0;
+    for (uint32_t elapsed = 0; elapsed < script.duration; elapsed += STEP, ++frame) {
+        script_step(&script, elapsed);
+
+        const sim_frame_t *rendered = sim_render_frame(elapsed == 0);
+
+        const char *broken = sgv_animation_check();
+        if (broken) {
+            report(pool, id, frame, broken);
+            return false;
+        }
+
+        if (reference) {
+            if (!log_frame(log, rendered)) {
+                report(pool, id, frame, "out of memory for the reference frames");
+                return false;
+            }
+        } else if (frame >= log->count || memcmp(rendered->leds, log->frames[frame].leds, sizeof rendered->leds)) {
+            char what[128];
+            for (uint8_t led = 0; frame < log->count && led < SIM_FRAME_LEDS; ++led) {
+                const sim_pixel_t *a = &rendered->leds[led];
+                const sim_pixel_t *b = &log->frames[frame].leds[led];
+                if (a->r != b->r || a->g != b->g || a->b != b->b) {
+                    snprintf(what, sizeof what, "LED %u is %02x%02x%02x, reference is %02x%02x%02x", led, a->r, a->g,
+                             a->b, b->r, b->g, b->b);
+                    break;
+                }
+            }
+            if (frame >= log->count) {
+                snprintf(what, sizeof what, "more frames than the reference");
+            }
+            report(pool, id, frame, what);
+            return false;
+        }
+
+        sim_advance_time(STEP);
+    }
+
+    atomic_fetch_add(&pool->frames, frame);
+    return true;
+}
+
+static void *worker(void *arg) {
+    fuzz_pool_t *pool = arg;
+    frame_log_t  log  = {0};
+
+    for (;;) {
+        uint32_t id = atomic_fetch_add(&pool->next, 1);
+        if (id >= pool->options->scripts) {
+            break;
+        }
+        if (pool->options->only >= 0) {
+            id = pool->options->only;
+        }
+
+        if (run_script(pool, id, true, &log) && run_script(pool, id, false, &log) && pool->options->verbose) {
+            pthread_mutex_lock(&pool->report_lock);
+            fprintf(stderr, "script %u: %u frames\n", id, log.count);
+            pthread_mutex_unlock(&pool->report_lock);
+        }
+    }
+
+    sgv_animation_set_reference_kernels(false);
+    free(log.frames);
+    return NULL;
+}
+
+int main(int argc, char **argv) {
+    long           cores   = sysconf(_SC_NPROCESSORS_ONLN);
+    fuzz_options_t options = {
+        .scripts = 2000,
+        .threads = cores > 0 ? cores : 1,
+        .seed    = 1,
+        .only    = -1,
+        .verbose = false,
+    };
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:j:s:i:vh")) != -1) {
+        switch (opt) {
+            case 'n':
+                options.scripts = strtoul(optarg, NULL, 10);
+                break;
+            case 'j':
+                options.threads = strtoul(optarg, NULL, 10);
+                break;
+            case 's':
+                options.seed = strtoul(optarg, NULL, 10);
+                break;
+            case 'i':
+                options.only = strtoul(optarg, NULL, 10);
+                break;
+            case 'v':
+                options.verbose = true;
+                break;
+            default:
+                usage(argv[0]);
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    if (optind != argc || !options.threads) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (options.only >= 0) {
+        options.scripts = 1;
+        options.threads = 1;
+    }
+    if (options.threads > options.scripts) {
+        options.threads = options.scripts ? options.scripts : 1;
+    }
+
+    fuzz_pool_t pool = {.options = &options};
+    atomic_init(&pool.next, 0);
+    atomic_init(&pool.frames, 0);
+    atomic_init(&pool.failures, 0);
+    pthread_mutex_init(&pool.report_lock, NULL);
+
+    pthread_t *threads = calloc(options.threads, sizeof(pthread_t));
+    if (!threads) {
+        perror("calloc");
+        return 1;
+    }
+
+    uint64_t start   = now_ns();
+    uint32_t started = 0;
+    for (; started < options.threads; ++started) {
+        if (pthread_create(&threads[started], NULL, worker, &pool) != 0) {
+            perror("pthread_create");
+            break;
+        }
+    }
+    for (uint32_t i = 0; i < started; ++i) {
+        pthread_join(threads[i], NULL);
+    }
+    double seconds = (now_ns() - start) / 1e9;
+
+    free(threads);
+    pthread_mutex_destroy(&pool.report_lock);
+
+    uint32_t failures = atomic_load(&pool.failures);
+    fprintf(stderr, "%s: %u scripts of seed %u, %llu frames on %u threads in %.2fs, %u failed\n", SIM_BOARD_NAME,
+            options.scripts, options.seed, (unsigned long long)atomic_load(&pool.frames), started, seconds, failures);
+
+    return started && !failures ? 0 : 1;
+}
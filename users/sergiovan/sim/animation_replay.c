@@ -0,0 +1,139 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "frame_dump.h"
+#include "replay.h"
+
+/* Default milliseconds between frames, close to what QMK does with the default LED flush limit */
+#define DEFAULT_STEP 16
+
+typedef struct replay_output {
+    FILE    *file;   /* Text frames, or NULL */
+    uint64_t last;   /* When the previous frame finished */
+    uint64_t worst;  /* Slowest frame, in nanoseconds */
+    bool     ok;
+} replay_output_t;
+
+static void usage(const char *self) {
+    fprintf(stderr, "Usage: %s [-s step_ms] [-f none|text] [-o output] [-r runs] capture.log\n", self);
+    fprintf(stderr, "  capture.log is a console log with the lines SGV_CAPT prints, other lines are skipped\n");
+    fprintf(stderr, "  text writes one line per frame to output, or stdout\n");
+    fprintf(stderr, "  runs replays the session that many times and reports the average frame time\n");
+}
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void on_frame(void *arg, const sim_frame_t *frame) {
+    replay_output_t *out = arg;
+
+    uint64_t now = now_ns();
+    if (now - out->last > out->worst) {
+        out->worst = now - out->last;
+    }
+
+    if (out->file) {
+        out->ok = frame_dump_text(out->file, frame) && out->ok;
+    }
+
+    /* Dumping frames isn't part of the frame time */
+    out->last = now_ns();
+}
+
+int main(int argc, char **argv) {
+    uint32_t        step = DEFAULT_STEP;
+    uint32_t        runs = 1;
+    const char     *path = NULL;
+    replay_output_t out  = {.file = stdout, .last = 0, .worst = 0, .ok = true};
+
+    int opt;
+    while ((opt = getopt(argc, argv, "s:f:o:r:h")) != -1) {
+        switch (opt) {
+            case 's':
+                step = strtoul(optarg, NULL, 10);
+                break;
+            case 'f':
+                if (strcmp(optarg, "none") == 0) {
+                    out.file = NULL;
+                } else if (strcmp(optarg, "text") == 0) {
+                    out.file = stdout;
+                } else {
+                    usage(argv[0]);
+                    return 1;
+                }
+                break;
+            case 'o':
+                path = optarg;
+                break;
+            case 'r':
+                runs = strtoul(optarg, NULL, 10);
+                break;
+            default:
+                usage(argv[0]);
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    if (optind != argc - 1 || !step || !runs) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    FILE *log = fopen(argv[optind], "r");
+    if (!log) {
+        perror(argv[optind]);
+        return 1;
+    }
+
+    sim_replay_t replay;
+    bool         loaded = sim_replay_load(log, &replay);
+    fclose(log);
+
+    if (!loaded) {
+        fprintf(stderr, "Failed to read '%s'\n", argv[optind]);
+        return 1;
+    }
+
+    if (out.file && path) {
+        out.file = fopen(path, "w");
+        if (!out.file) {
+            perror(path);
+            sim_replay_free(&replay);
+            return 1;
+        }
+    }
+
+    /* Frames are only written on the first run, every run renders the same frames */
+    uint32_t frames = 0;
+    uint64_t start  = now_ns();
+    for (uint32_t run = 0; run < runs; ++run) {
+        out.last = now_ns();
+        frames += sim_replay_run(&replay, step, on_frame, &out);
+
+        if (out.file && out.file != stdout && fclose(out.file) != 0) {
+            out.ok = false;
+        }
+        out.file = NULL;
+    }
+    uint64_t total = now_ns() - start;
+
+    if (!out.ok) {
+        fprintf(stderr, "Failed to write some frames\n");
+        sim_replay_free(&replay);
+        return 1;
+    }
+
+    fprintf(stderr, "%s: %u events, %u frames of %u LEDs\n", argv[optind], replay.count, frames / runs,
+            SIM_FRAME_LEDS);
+    if (runs > 1) {
+        fprintf(stderr, "%.0f ns/frame, worst frame %llu ns\n", (double)total / frames, (unsigned long long)out.worst);
+    }
+
+    sim_replay_free(&replay);
+    return 0;
+}
@@ -0,0 +1,193 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "frame_dump.h"
+#include "perf/perf.h"
+#include "scenarios.h"
+#include "trace/trace.h"
+
+/* Default milliseconds between frames, close to what QMK does with the default LED flush limit */
+#define DEFAULT_STEP 16
+
+typedef enum output_format {
+    OUTPUT_NONE,
+    OUTPUT_TEXT,
+    OUTPUT_PPM,
+} output_format_e;
+
+typedef struct output {
+    output_format_e format;
+    const char     *path; /* Text file, or prefix of the PPM images */
+    FILE           *file;
+    uint32_t        frame;
+    FILE           *trace; /* Trace events, drained after every frame */
+    bool            ok;
+} output_t;
+
+static void usage(const char *self) {
+    fprintf(stderr, "Usage: %s [-s step_ms] [-f none|text|ppm] [-o output] [-t trace] [-p] scenario\n", self);
+    fprintf(stderr, "  text writes one line per frame to output, or stdout\n");
+    fprintf(stderr, "  ppm writes output_NNNNN.ppm for every frame\n");
+    fprintf(stderr, "  trace gets the engine trace events, for profile/trace2chrome.py\n");
+    fprintf(stderr, "  -p prints the profiling counters once the scenario is done\n\n");
+    fprintf(stderr, "Scenarios:\n");
+    for (const sim_scenario_t *scenario = sim_scenarios; scenario->name; ++scenario) {
+        fprintf(stderr, "  %-10s %s\n", scenario->name, scenario->description);
+    }
+}
+
+static void on_frame(void *arg, const sim_frame_t *frame) {
+    output_t *out = arg;
+
+    switch (out->format) {
+        case OUTPUT_NONE:
+            break;
+        case OUTPUT_TEXT:
+            out->ok = frame_dump_text(out->file, frame) && out->ok;
+            break;
+        case OUTPUT_PPM: {
+            char path[4096];
+            snprintf(path, sizeof path, "%s_%05u.ppm", out->path, out->frame);
+            out->ok = frame_dump_ppm(path, frame) && out->ok;
+            break;
+        }
+    }
+
+    if (out->trace) {
+        trace_event_t event;
+        uint16_t      dropped = trace_dropped();
+
+        if (dropped) {
+            fprintf(out->trace, "trace dropped %u\n", dropped);
+        }
+        while (trace_drain(&event, 1)) {
+            fprintf(out->trace, "trace %u %u %u %u\n", event.time, event.type, event.arg, event.data);
+        }
+    }
+
+    out->frame++;
+}
+
+/**
+ * @brief Same report perf_print sends over the console, with averages and the histogram as percentages
+ */
+static void print_perf(FILE *file) {
+    fprintf(file, "%-16s %8s %10s %10s %10s  (%s)\n", "counter", "count", "min", "avg", "max", PERF_UNIT);
+
+    for (uint8_t i = 0; i < PERF_COUNTER_COUNT; ++i) {
+        const perf_stats_t *stats = perf_get(i);
+        if (!stats->count) {
+            continue;
+        }
+
+        fprintf(file, "%-16s %8u %10u %10llu %10u ", perf_name(i), stats->count, stats->min,
+                (unsigned long long)(stats->total / stats->count), stats->max);
+        for (uint8_t b = 0; b < PERF_HISTOGRAM_BUCKETS; ++b) {
+            if (stats->histogram[b]) {
+                fprintf(file, " >=%u:%.0f%%", b ? 1U << (2 * (b - 1)) : 0U, 100.0 * stats->histogram[b] / stats->count);
+            }
+        }
+        fprintf(file, "\n");
+    }
+
+    const perf_queue_stats_t *queue = perf_get_queue();
+    if (queue->count) {
+        fprintf(file, "%-16s %8u %10u %10.1f %10u ", "queue depth", queue->count, queue->min,
+                (double)queue->total / queue->count, queue->max);
+        for (uint8_t d = 0; d < PERF_QUEUE_DEPTHS; ++d) {
+            if (queue->depths[d]) {
+                fprintf(file, " %u:%.0f%%", d, 100.0 * queue->depths[d] / queue->count);
+            }
+        }
+        fprintf(file, "\n");
+    }
+}
+
+int main(int argc, char **argv) {
+    uint32_t step = DEFAULT_STEP;
+    bool     perf = false;
+    output_t out  = {.format = OUTPUT_TEXT, .path = NULL, .file = stdout, .frame = 0, .trace = NULL, .ok = true};
+
+    int opt;
+    while ((opt = getopt(argc, argv, "s:f:o:t:ph")) != -1) {
+        switch (opt) {
+            case 's':
+                step = strtoul(optarg, NULL, 10);
+                break;
+            case 'f':
+                if (strcmp(optarg, "none") == 0) {
+                    out.format = OUTPUT_NONE;
+                } else if (strcmp(optarg, "text") == 0) {
+                    out.format = OUTPUT_TEXT;
+                } else if (strcmp(optarg, "ppm") == 0) {
+                    out.format = OUTPUT_PPM;
+                } else {
+                    usage(argv[0]);
+                    return 1;
+                }
+                break;
+            case 'o':
+                out.path = optarg;
+                break;
+            case 'p':
+                perf = true;
+                break;
+            case 't':
+                out.trace = fopen(optarg, "w");
+                if (!out.trace) {
+                    perror(optarg);
+                    return 1;
+                }
+                break;
+            default:
+                usage(argv[0]);
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    if (optind != argc - 1 || !step) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    const sim_scenario_t *scenario = sim_scenario_find(argv[optind]);
+    if (!scenario) {
+        fprintf(stderr, "Unknown scenario '%s'\n\n", argv[optind]);
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (out.format == OUTPUT_PPM && !out.path) {
+        out.path = scenario->name;
+    } else if (out.format == OUTPUT_TEXT && out.path) {
+        out.file = fopen(out.path, "w");
+        if (!out.file) {
+            perror(out.path);
+            return 1;
+        }
+    }
+
+    uint32_t frames = sim_scenario_run(scenario, step, on_frame, &out);
+
+    if (out.file != stdout && fclose(out.file) != 0) {
+        out.ok = false;
+    }
+
+    if (out.trace && fclose(out.trace) != 0) {
+        out.ok = false;
+    }
+
+    if (!out.ok) {
+        fprintf(stderr, "Failed to write some frames\n");
+        return 1;
+    }
+
+    fprintf(stderr, "%s: %u frames of %u LEDs\n", scenario->name, frames, SIM_FRAME_LEDS);
+
+    if (perf) {
+        print_perf(stderr);
+    }
+
+    return 0;
+}
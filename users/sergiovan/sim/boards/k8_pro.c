@@ -0,0 +1,40 @@
+#include "sim.h"
+
+#ifdef SIM_BOARD_K8_PRO
+
+/* LED geometry of the Keychron K8 Pro (ANSI, white backlight). Physical positions are derived from the key layout in
+   QMK units, (0, 0) top left to (224, 64) bottom right. LEDs are numbered row by row, left to right */
+
+// clang-format off
+led_config_t g_led_config = {
+    .matrix_co =
+        {
+            {  0,   1,   2,   3,   4,   5,   6,   7,   8,   9,  10,  11,  12, NO_LED,  13,  14,  15},
+            { 16,  17,  18,  19,  20,  21,  22,  23,  24,  25,  26,  27,  28,  29,  30,  31,  32},
+            { 33,  34,  35,  36,  37,  38,  39,  40,  41,  42,  43,  44,  45,  46,  47,  48,  49},
+            { 50,  51,  52,  53,  54,  55,  56,  57,  58,  59,  60,  61, NO_LED,  62, NO_LED, NO_LED, NO_LED},
+            { 63, NO_LED,  64,  65,  66,  67,  68,  69,  70,  71,  72,  73, NO_LED,  74, NO_LED,  75, NO_LED},
+            { 76,  77,  78, NO_LED, NO_LED, NO_LED,  79, NO_LED, NO_LED, NO_LED,  80,  81,  82,  83,  84,  85,  86},
+        },
+    .point =
+        {
+            {  0,  0}, { 26,  0}, { 39,  0}, { 52,  0}, { 65,  0}, { 84,  0}, { 97,  0}, {110,  0}, {123,  0}, {143,  0}, {156,  0}, {169,  0}, {182,  0}, {198,  0}, {211,  0}, {224,  0},
+            {  0, 15}, { 13, 15}, { 26, 15}, { 39, 15}, { 52, 15}, { 65, 15}, { 78, 15}, { 91, 15}, {104, 15}, {117, 15}, {130, 15}, {143, 15}, {156, 15}, {175, 15}, {198, 15}, {211, 15}, {224, 15},
+            {  3, 27}, { 19, 27}, { 32, 27}, { 45, 27}, { 58, 27}, { 71, 27}, { 84, 27}, { 97, 27}, {110, 27}, {123, 27}, {136, 27}, {149, 27}, {162, 27}, {179, 27}, {198, 27}, {211, 27}, {224, 27},
+            {  5, 40}, { 23, 40}, { 36, 40}, { 49, 40}, { 62, 40}, { 75, 40}, { 88, 40}, {101, 40}, {114, 40}, {127, 40}, {140, 40}, {153, 40}, {174, 40},
+            {  8, 52}, { 29, 52}, { 42, 52}, { 55, 52}, { 68, 52}, { 81, 52}, { 94, 52}, {107, 52}, {120, 52}, {133, 52}, {146, 52}, {170, 52}, {211, 52},
+            {  2, 64}, { 18, 64}, { 34, 64}, { 83, 64}, {131, 64}, {148, 64}, {164, 64}, {180, 64}, {198, 64}, {211, 64}, {224, 64},
+        },
+    .flags =
+        {
+            4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+            4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+            4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+            4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+            4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+            4, 4, 4, 4, 4, 4, 4,
+        },
+};
+// clang-format on
+
+#endif
@@ -0,0 +1,41 @@
+#include "sim.h"
+
+#ifdef SIM_BOARD_Q6
+
+/* LED geometry of the Keychron Q6 (ANSI). Physical positions are derived from the key layout in
+   QMK units, (0, 0) top left to (224, 64) bottom right. LEDs are numbered row by row, left to right */
+
+// clang-format off
+led_config_t g_led_config = {
+    .matrix_co =
+        {
+            {  0,   1,   2,   3,   4,   5,   6,   7,   8,   9,  10,  11,  12,  13,  14,  15,  16,  17,  18,  19, NO_LED},
+            { 20,  21,  22,  23,  24,  25,  26,  27,  28,  29,  30,  31,  32,  33,  34,  35,  36,  37,  38,  39,  40},
+            { 41,  42,  43,  44,  45,  46,  47,  48,  49,  50,  51,  52,  53,  54,  55,  56,  57,  58,  59,  60, NO_LED},
+            { 61,  62,  63,  64,  65,  66,  67,  68,  69,  70,  71,  72, NO_LED,  73, NO_LED, NO_LED, NO_LED,  74,  75,  76,  77},
+            { 78, NO_LED,  79,  80,  81,  82,  83,  84,  85,  86,  87,  88, NO_LED,  89, NO_LED,  90, NO_LED,  91,  92,  93, NO_LED},
+            { 94,  95,  96, NO_LED, NO_LED, NO_LED,  97, NO_LED, NO_LED, NO_LED,  98,  99, 100, 101, 102, 103, 104, 105, NO_LED, 106, 107},
+        },
+    .point =
+        {
+            {  0,  0}, { 13,  0}, { 23,  0}, { 34,  0}, { 44,  0}, { 57,  0}, { 68,  0}, { 78,  0}, { 89,  0}, {102,  0}, {112,  0}, {122,  0}, {133,  0}, {148,  0}, {159,  0}, {169,  0}, {193,  0}, {203,  0}, {214,  0}, {224,  0},
+            {  0, 15}, { 10, 15}, { 21, 15}, { 31, 15}, { 42, 15}, { 52, 15}, { 63, 15}, { 73, 15}, { 83, 15}, { 94, 15}, {104, 15}, {115, 15}, {125, 15}, {141, 15}, {159, 15}, {169, 15}, {180, 15}, {193, 15}, {203, 15}, {214, 15}, {224, 15},
+            {  3, 27}, { 16, 27}, { 26, 27}, { 36, 27}, { 47, 27}, { 57, 27}, { 68, 27}, { 78, 27}, { 89, 27}, { 99, 27}, {109, 27}, {120, 27}, {130, 27}, {143, 27}, {159, 27}, {169, 27}, {180, 27}, {193, 27}, {203, 27}, {214, 27},
+            {  4, 40}, { 18, 40}, { 29, 40}, { 39, 40}, { 49, 40}, { 60, 40}, { 70, 40}, { 81, 40}, { 91, 40}, {102, 40}, {112, 40}, {122, 40}, {139, 40}, {193, 40}, {203, 40}, {214, 40}, {224, 40},
+            {  7, 52}, { 23, 52}, { 34, 52}, { 44, 52}, { 55, 52}, { 65, 52}, { 76, 52}, { 86, 52}, { 96, 52}, {107, 52}, {117, 52}, {137, 52}, {169, 52}, {193, 52}, {203, 52}, {214, 52},
+            {  1, 64}, { 14, 64}, { 27, 64}, { 66, 64}, {105, 64}, {119, 64}, {132, 64}, {145, 64}, {159, 64}, {169, 64}, {180, 64}, {198, 64}, {214, 64}, {224, 64},
+        },
+    .flags =
+        {
+            4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+            4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+            4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+            4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+            4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+            4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+            4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+        },
+};
+// clang-format on
+
+#endif
@@ -0,0 +1,81 @@
+#include "frame_dump.h"
+
+#include <inttypes.h>
+
+/* LED coordinates go from (0, 0) to (224, 64). Keys are roughly 13 units apart */
+#define BOARD_W 225
+#define BOARD_H 65
+#define KEY_PITCH 13
+
+/* Image pixels per LED coordinate unit, and size of each drawn LED */
+#define PPM_SCALE 4
+#define PPM_LED_SIZE ((KEY_PITCH - 2) * PPM_SCALE)
+#define PPM_MARGIN (KEY_PITCH * PPM_SCALE / 2)
+
+#define PPM_W (BOARD_W * PPM_SCALE + 2 * PPM_MARGIN)
+#define PPM_H (BOARD_H * PPM_SCALE + 2 * PPM_MARGIN)
+
+/* Color of the board between keys */
+#define PPM_BACKGROUND 0x20
+
+bool frame_dump_ppm(const char *path, const sim_frame_t *frame) {
+    static sim_pixel_t image[PPM_H][PPM_W];
+
+    memset(image, PPM_BACKGROUND, sizeof image);
+
+    for (uint8_t led = 0; led < SIM_FRAME_LEDS; ++led) {
+        int32_t cx = PPM_MARGIN + g_led_config.point[led].x * PPM_SCALE;
+        int32_t cy = PPM_MARGIN + g_led_config.point[led].y * PPM_SCALE;
+
+        for (int32_t y = cy - PPM_LED_SIZE / 2; y < cy + PPM_LED_SIZE / 2; ++y) {
+            for (int32_t x = cx - PPM_LED_SIZE / 2; x < cx + PPM_LED_SIZE / 2; ++x) {
+                if (x < 0 || y < 0 || x >= PPM_W || y >= PPM_H) {
+                    continue;
+                }
+                image[y][x] = frame->leds[led];
+            }
+        }
+    }
+
+    FILE *file = fopen(path, "wb");
+    if (!file) {
+        return false;
+    }
+
+    fprintf(file, "P6\n%d %d\n255\n", PPM_W, PPM_H);
+    bool ok = fwrite(image, sizeof image, 1, file) == 1;
+
+    return fclose(file) == 0 && ok;
+}
+
+bool frame_dump_text(FILE *file, const sim_frame_t *frame) {
+    if (fprintf(file, "%" PRIu32, frame->time) < 0) {
+        return false;
+    }
+
+    for (uint8_t led = 0; led < SIM_FRAME_LEDS; ++led) {
+        const sim_pixel_t *p = &frame->leds[led];
+        if (fprintf(file, " %02X%02X%02X", p->r, p->g, p->b) < 0) {
+            return false;
+        }
+    }
+
+    return fputc('\n', file) != EOF;
+}
+
+bool frame_load_text(FILE *file, sim_frame_t *frame) {
+    if (fscanf(file, "%" SCNu32, &frame->time) != 1) {
+        return false;
+    }
+
+    for (uint8_t led = 0; led < SIM_FRAME_LEDS; ++led) {
+        unsigned int rgb;
+        if (fscanf(file, " %6x", &rgb) != 1) {
+            return false;
+        }
+
+        frame->leds[led] = (sim_pixel_t){.r = rgb >> 16, .g = (rgb >> 8) & 0xFF, .b = rgb & 0xFF};
+    }
+
+    return true;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <stdio.h>
+
+#include "sim.h"
+
+/**
+ * @brief Writes one frame as a binary PPM image. Each LED is drawn as a square at its physical position on the
+ *        board, so the image looks like the keyboard
+ *
+ * @param path File to write the image to
+ * @param frame Frame to draw
+ * @return true If the image was written
+ * @return false Otherwise
+ */
+bool frame_dump_ppm(const char *path, const sim_frame_t *frame);
+
+/**
+ * @brief Appends one frame to a text sequence. Each frame is one line with the time in milliseconds followed by
+ *        the RRGGBB color of every LED, in LED order
+ *
+ * @param file File to append to
+ * @param frame Frame to write
+ * @return true If the frame was written
+ * @return false Otherwise
+ */
+bool frame_dump_text(FILE *file, const sim_frame_t *frame);
+
+/**
+ * @brief Reads back one frame written by `frame_dump_text`
+ *
+ * @param file File to read from
+ * @param frame Frame to fill. Only time and LEDs are read
+ * @return true If a whole frame was read
+ * @return false On end of file or malformed input
+ */
+bool frame_load_text(FILE *file, sim_frame_t *frame);
@@ -0,0 +1,138 @@
+#include "sim.h"
+
+#include "deferred_exec.h"
+
+/* Same amount of deferred callbacks QMK allows by default */
+#define SIM_DEFERRED_MAX 8
+
+typedef struct sim_deferred {
+    deferred_token         token;    /* INVALID_DEFERRED_TOKEN when the slot is free */
+    uint32_t               trigger;  /* When the callback runs next */
+    deferred_exec_callback callback; /* Function to call */
+    void                  *arg;      /* Argument to the callback */
+} sim_deferred_t;
+
+SGV_THREAD_LOCAL layer_state_t layer_state         = 0;
+SGV_THREAD_LOCAL layer_state_t default_layer_state = 0;
+
+static SGV_THREAD_LOCAL uint8_t mods        = 0;
+static SGV_THREAD_LOCAL uint8_t matrix_mode = 0;
+
+static SGV_THREAD_LOCAL sim_deferred_t deferred[SIM_DEFERRED_MAX] = {0};
+static SGV_THREAD_LOCAL deferred_token last_token                 = INVALID_DEFERRED_TOKEN;
+
+void sim_keyboard_reset(void) {
+    layer_state         = 0;
+    default_layer_state = 0;
+    mods                = 0;
+    matrix_mode         = 0;
+    last_token          = INVALID_DEFERRED_TOKEN;
+
+    memset(deferred, 0, sizeof deferred);
+}
+
+void sim_set_mods(uint8_t new_mods) {
+    mods = new_mods;
+}
+
+void sim_run_deferred(void) {
+    uint32_t now = timer_read32();
+
+    for (uint8_t i = 0; i < SIM_DEFERRED_MAX; ++i) {
+        sim_deferred_t *entry = &deferred[i];
+        if (entry->token == INVALID_DEFERRED_TOKEN || !timer_expired32(now, entry->trigger)) {
+            continue;
+        }
+
+        uint32_t delay = entry->callback(entry->trigger, entry->arg);
+        if (delay) {
+            entry->trigger += delay;
+        } else {
+            entry->token = INVALID_DEFERRED_TOKEN;
+        }
+    }
+}
+
+/* QMK stubs */
+
+uint8_t get_highest_layer(layer_state_t state) {
+    return state ? 31 - __builtin_clz(state) : 0;
+}
+
+void default_layer_set(layer_state_t state) {
+    default_layer_state = state;
+}
+
+void set_oneshot_layer(uint8_t layer, uint8_t state) {}
+
+void clear_oneshot_layer_state(uint8_t state) {}
+
+uint8_t get_mods(void) {
+    return mods;
+}
+
+void tap_code16(uint16_t code) {}
+
+deferred_token defer_exec(uint32_t delay_ms, deferred_exec_callback callback, void *cb_arg) {
+    for (uint8_t i = 0; i < SIM_DEFERRED_MAX; ++i) {
+        if (deferred[i].token != INVALID_DEFERRED_TOKEN) {
+            continue;
+        }
+
+        /* Tokens are never 0, which is INVALID_DEFERRED_TOKEN */
+        if (++last_token == INVALID_DEFERRED_TOKEN) {
+            ++last_token;
+        }
+
+        deferred[i] = (sim_deferred_t){
+            .token    = last_token,
+            .trigger  = timer_read32() + delay_ms,
+            .callback = callback,
+            .arg      = cb_arg,
+        };
+        return last_token;
+    }
+
+    return INVALID_DEFERRED_TOKEN;
+}
+
+bool cancel_deferred_exec(deferred_token token) {
+    for (uint8_t i = 0; i < SIM_DEFERRED_MAX; ++i) {
+        if (token != INVALID_DEFERRED_TOKEN && deferred[i].token == token) {
+            deferred[i].token = INVALID_DEFERRED_TOKEN;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+#if RGB_MATRIX_ENABLE
+void rgb_matrix_mode(uint8_t mode) {
+    matrix_mode = mode;
+}
+
+void rgb_matrix_mode_noeeprom(uint8_t mode) {
+    matrix_mode = mode;
+}
+
+uint8_t rgb_matrix_get_mode(void) {
+    return matrix_mode;
+}
+
+void rgb_matrix_update_pwm_buffers(void) {}
+#else
+void led_matrix_mode(uint8_t mode) {
+    matrix_mode = mode;
+}
+
+void led_matrix_mode_noeeprom(uint8_t mode) {
+    matrix_mode = mode;
+}
+
+uint8_t led_matrix_get_mode(void) {
+    return matrix_mode;
+}
+
+void led_matrix_update_pwm_buffers(void) {}
+#endif
@@ -0,0 +1,16 @@
+#pragma once
+
+/* Host stand-in for QMK's deferred_exec.h. Callbacks run from `sim_run_deferred`, which replays call once per frame
+   like QMK's main loop does */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef uint8_t deferred_token;
+
+#define INVALID_DEFERRED_TOKEN 0
+
+typedef uint32_t (*deferred_exec_callback)(uint32_t trigger_time, void *cb_arg);
+
+deferred_token defer_exec(uint32_t delay_ms, deferred_exec_callback callback, void *cb_arg);
+bool           cancel_deferred_exec(deferred_token token);
@@ -0,0 +1,242 @@
+#pragma once
+
+/* Host stand-in for QMK_KEYBOARD_H. Provides just enough of QMK for the animation engine to run off-device.
+   Everything declared here is implemented in sim.c or the board geometry files */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+/* Board selection. Must match one of the geometry tables in sim/boards */
+#if defined(SIM_BOARD_K8_PRO)
+#    define LED_MATRIX_ENABLE 1
+#    define MATRIX_ROWS 6
+#    define MATRIX_COLS 17
+#    define LED_MATRIX_LED_COUNT 87
+#    define SIM_LED_COUNT LED_MATRIX_LED_COUNT
+#    define SIM_BOARD_NAME "K8 Pro"
+#elif defined(SIM_BOARD_Q6)
+#    define RGB_MATRIX_ENABLE 1
+#    define MATRIX_ROWS 6
+#    define MATRIX_COLS 21
+#    define RGB_MATRIX_LED_COUNT 108
+#    define SIM_LED_COUNT RGB_MATRIX_LED_COUNT
+#    define SIM_BOARD_NAME "Q6"
+#else
+#    error "Define SIM_BOARD_K8_PRO or SIM_BOARD_Q6 to pick the simulated board"
+#endif
+
+#define PROGMEM
+#define pgm_read_byte(address) (*(const uint8_t *)(address))
+#define PACKED __attribute__((packed))
+
+/* Engine and simulator state is per thread, so several simulated keyboards can run in parallel. Firmware builds of
+   the modules (size report, instruction counts) have no threads */
+#if defined(__arm__)
+#    define SGV_THREAD_LOCAL
+#elif defined(__cplusplus)
+#    define SGV_THREAD_LOCAL thread_local
+#else
+#    define SGV_THREAD_LOCAL _Thread_local
+#endif
+
+/* lib8tion keeps its random generator in a global. Every simulator thread gets its own instead, through this
+   function, so parallel runs stay reproducible. Must come before lib8tion.h is included */
+uint16_t *sim_rand16seed(void);
+
+#define rand16seed (*sim_rand16seed())
+
+/* Keycodes and keymap layouts */
+
+#include "sim_keycodes.h"
+#include "sim_layouts.h"
+
+/* Timer */
+
+uint32_t timer_read32(void);
+uint32_t timer_elapsed32(uint32_t last);
+
+#define timer_expired32(current, future) ((uint32_t)((current) - (future)) < UINT32_MAX / 2)
+
+/* Trace events are timestamped with the host clock instead, so they show how long the engine really takes */
+uint32_t sim_trace_clock(void);
+
+#define TRACE_CLOCK() sim_trace_clock()
+
+/* Profiling counters measure host nanoseconds, there are no cycles to count */
+uint32_t sim_perf_clock(void);
+
+#define PERF_CLOCK() sim_perf_clock()
+#define PERF_UNIT "ns"
+
+/* Colors */
+
+typedef struct PACKED {
+    uint8_t h;
+    uint8_t s;
+    uint8_t v;
+} HSV;
+
+typedef struct PACKED {
+    uint8_t r;
+    uint8_t g;
+    uint8_t b;
+} RGB;
+
+#define RGB_OFF 0x00, 0x00, 0x00
+#define HSV_RED 0, 255, 255
+#define HSV_BLUE 170, 255, 255
+
+/**
+ * @brief Same conversion QMK does, without the CIE1931 curve
+ */
+RGB hsv_to_rgb(HSV hsv);
+
+/* LED configuration */
+
+#define NO_LED 255
+
+#define LED_FLAG_NONE 0x00
+#define LED_FLAG_KEYLIGHT 0x04
+#define LED_FLAG_ALL 0xFF
+
+#define HAS_ANY_FLAGS(bits, flags) ((bits & flags) != 0x00)
+
+typedef struct PACKED {
+    uint8_t x;
+    uint8_t y;
+} led_point_t;
+
+typedef struct PACKED {
+    uint8_t     matrix_co[MATRIX_ROWS][MATRIX_COLS];
+    led_point_t point[SIM_LED_COUNT];
+    uint8_t     flags[SIM_LED_COUNT];
+} led_config_t;
+
+extern led_config_t g_led_config;
+
+typedef struct {
+    uint8_t iter;
+    uint8_t flags;
+    bool    init;
+} effect_params_t;
+
+/* Matrix effects */
+
+#if RGB_MATRIX_ENABLE
+#    define RGB_MATRIX_LED_PROCESS_LIMIT ((RGB_MATRIX_LED_COUNT + 4) / 5)
+
+#    define RGB_MATRIX_USE_LIMITS_ITER(min, max, iter)   \
+        uint8_t min = RGB_MATRIX_LED_PROCESS_LIMIT * (iter); \
+        uint8_t max = min + RGB_MATRIX_LED_PROCESS_LIMIT;    \
+        if (max > RGB_MATRIX_LED_COUNT) max = RGB_MATRIX_LED_COUNT;
+#    define RGB_MATRIX_USE_LIMITS(min, max) RGB_MATRIX_USE_LIMITS_ITER(min, max, params->iter)
+#    define RGB_MATRIX_TEST_LED_FLAGS() \
+        if (!HAS_ANY_FLAGS(g_led_config.flags[i], params->flags)) continue
+
+HSV     rgb_matrix_get_hsv(void);
+uint8_t rgb_matrix_get_speed(void);
+uint8_t rgb_matrix_get_val(void);
+bool    rgb_matrix_is_enabled(void);
+bool    rgb_matrix_check_finished_leds(uint8_t led_idx);
+void    rgb_matrix_set_color(int index, uint8_t red, uint8_t green, uint8_t blue);
+void    rgb_matrix_set_color_all(uint8_t red, uint8_t green, uint8_t blue);
+#else
+#    define LED_MATRIX_LED_PROCESS_LIMIT ((LED_MATRIX_LED_COUNT + 4) / 5)
+
+#    define LED_MATRIX_USE_LIMITS_ITER(min, max, iter)   \
+        uint8_t min = LED_MATRIX_LED_PROCESS_LIMIT * (iter); \
+        uint8_t max = min + LED_MATRIX_LED_PROCESS_LIMIT;    \
+        if (max > LED_MATRIX_LED_COUNT) max = LED_MATRIX_LED_COUNT;
+#    define LED_MATRIX_USE_LIMITS(min, max) LED_MATRIX_USE_LIMITS_ITER(min, max, params->iter)
+#    define LED_MATRIX_TEST_LED_FLAGS() \
+        if (!HAS_ANY_FLAGS(g_led_config.flags[i], params->flags)) continue
+
+uint8_t led_matrix_get_speed(void);
+uint8_t led_matrix_get_val(void);
+bool    led_matrix_is_enabled(void);
+bool    led_matrix_check_finished_leds(uint8_t led_idx);
+void    led_matrix_set_value(int index, uint8_t value);
+void    led_matrix_set_value_all(uint8_t value);
+#endif
+
+/* Matrix modes. Only the modes the keymaps switch to exist */
+
+#if RGB_MATRIX_ENABLE
+enum rgb_matrix_effects {
+    RGB_MATRIX_NONE,
+    RGB_MATRIX_CUSTOM_sgv_custom_rgb,
+};
+
+void    rgb_matrix_mode(uint8_t mode);
+void    rgb_matrix_mode_noeeprom(uint8_t mode);
+uint8_t rgb_matrix_get_mode(void);
+void    rgb_matrix_update_pwm_buffers(void);
+#else
+enum led_matrix_effects {
+    LED_MATRIX_NONE,
+    LED_MATRIX_CUSTOM_sgv_custom_led,
+};
+
+void    led_matrix_mode(uint8_t mode);
+void    led_matrix_mode_noeeprom(uint8_t mode);
+uint8_t led_matrix_get_mode(void);
+void    led_matrix_update_pwm_buffers(void);
+#endif
+
+/* Key events */
+
+typedef struct {
+    uint8_t col;
+    uint8_t row;
+} keypos_t;
+
+typedef struct {
+    keypos_t key;
+    bool     pressed;
+    uint16_t time;
+} keyevent_t;
+
+typedef struct {
+    bool    interrupted : 1;
+    bool    reserved2 : 1;
+    bool    reserved1 : 1;
+    bool    reserved0 : 1;
+    uint8_t count : 4;
+} tap_t;
+
+typedef struct {
+    keyevent_t event;
+    tap_t      tap;
+} keyrecord_t;
+
+/* Layers. Replays set the layer state from the captured layer changes, so nothing here switches layers by itself */
+
+typedef uint32_t layer_state_t;
+
+extern SGV_THREAD_LOCAL layer_state_t layer_state;
+extern SGV_THREAD_LOCAL layer_state_t default_layer_state;
+
+uint8_t get_highest_layer(layer_state_t state);
+void    default_layer_set(layer_state_t state);
+
+#define ONESHOT_PRESSED 0b01
+#define ONESHOT_OTHER_KEY_PRESSED 0b10
+#define ONESHOT_START 0b11
+
+void set_oneshot_layer(uint8_t layer, uint8_t state);
+void clear_oneshot_layer_state(uint8_t state);
+
+/* Modifiers and key sending */
+
+uint8_t get_mods(void);
+void    tap_code16(uint16_t code);
+
+/* ChibiOS time conversion, the simulated system tick is one millisecond */
+#define TIME_MS2I(ms) (ms)
+
+/* Keymap hooks, implemented by the keymaps */
+
+void          keyboard_post_init_user(void);
+bool          process_record_user(uint16_t keycode, keyrecord_t *record);
+layer_state_t layer_state_set_user(layer_state_t state);
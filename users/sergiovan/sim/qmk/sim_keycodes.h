@@ -0,0 +1,181 @@
+#pragma once
+
+/* Keycodes used by the keymaps, with the same values QMK gives them. Keyboard specific keycodes only need to be
+   unique, nothing in the simulator acts on them */
+
+// clang-format off
+
+#define KC_NO 0x0000
+#define KC_TRANSPARENT 0x0001
+#define KC_TRNS KC_TRANSPARENT
+#define _______ KC_TRANSPARENT
+
+/* Basic keycodes, same as the HID usage IDs */
+
+#define KC_A 0x0004
+#define KC_B 0x0005
+#define KC_C 0x0006
+#define KC_D 0x0007
+#define KC_E 0x0008
+#define KC_F 0x0009
+#define KC_G 0x000A
+#define KC_H 0x000B
+#define KC_I 0x000C
+#define KC_J 0x000D
+#define KC_K 0x000E
+#define KC_L 0x000F
+#define KC_M 0x0010
+#define KC_N 0x0011
+#define KC_O 0x0012
+#define KC_P 0x0013
+#define KC_Q 0x0014
+#define KC_R 0x0015
+#define KC_S 0x0016
+#define KC_T 0x0017
+#define KC_U 0x0018
+#define KC_V 0x0019
+#define KC_W 0x001A
+#define KC_X 0x001B
+#define KC_Y 0x001C
+#define KC_Z 0x001D
+#define KC_1 0x001E
+#define KC_2 0x001F
+#define KC_3 0x0020
+#define KC_4 0x0021
+#define KC_5 0x0022
+#define KC_6 0x0023
+#define KC_7 0x0024
+#define KC_8 0x0025
+#define KC_9 0x0026
+#define KC_0 0x0027
+#define KC_ENT 0x0028
+#define KC_ESC 0x0029
+#define KC_BSPC 0x002A
+#define KC_TAB 0x002B
+#define KC_SPC 0x002C
+#define KC_MINS 0x002D
+#define KC_EQL 0x002E
+#define KC_LBRC 0x002F
+#define KC_RBRC 0x0030
+#define KC_BSLS 0x0031
+#define KC_SCLN 0x0033
+#define KC_QUOT 0x0034
+#define KC_GRV 0x0035
+#define KC_COMM 0x0036
+#define KC_DOT 0x0037
+#define KC_SLSH 0x0038
+#define KC_CAPS 0x0039
+#define KC_F1 0x003A
+#define KC_F2 0x003B
+#define KC_F3 0x003C
+#define KC_F4 0x003D
+#define KC_F5 0x003E
+#define KC_F6 0x003F
+#define KC_F7 0x0040
+#define KC_F8 0x0041
+#define KC_F9 0x0042
+#define KC_F10 0x0043
+#define KC_F11 0x0044
+#define KC_F12 0x0045
+#define KC_PSCR 0x0046
+#define KC_INS 0x0049
+#define KC_HOME 0x004A
+#define KC_PGUP 0x004B
+#define KC_DEL 0x004C
+#define KC_END 0x004D
+#define KC_PGDN 0x004E
+#define KC_RGHT 0x004F
+#define KC_LEFT 0x0050
+#define KC_DOWN 0x0051
+#define KC_UP 0x0052
+#define KC_NUM 0x0053
+#define KC_PSLS 0x0054
+#define KC_PAST 0x0055
+#define KC_PMNS 0x0056
+#define KC_PPLS 0x0057
+#define KC_PENT 0x0058
+#define KC_P1 0x0059
+#define KC_P2 0x005A
+#define KC_P3 0x005B
+#define KC_P4 0x005C
+#define KC_P5 0x005D
+#define KC_P6 0x005E
+#define KC_P7 0x005F
+#define KC_P8 0x0060
+#define KC_P9 0x0061
+#define KC_P0 0x0062
+#define KC_PDOT 0x0063
+
+/* Media and mouse keys */
+
+#define KC_MUTE 0x00A8
+#define KC_VOLU 0x00A9
+#define KC_VOLD 0x00AA
+#define KC_MNXT 0x00AB
+#define KC_MPRV 0x00AC
+#define KC_MPLY 0x00AE
+#define KC_BRIU 0x00BD
+#define KC_BRID 0x00BE
+#define KC_MS_BTN4 0x00D4
+#define KC_MS_BTN5 0x00D5
+
+/* Modifiers */
+
+#define KC_LCTL 0x00E0
+#define KC_LSFT 0x00E1
+#define KC_LALT 0x00E2
+#define KC_LGUI 0x00E3
+#define KC_RCTL 0x00E4
+#define KC_RSFT 0x00E5
+#define KC_RALT 0x00E6
+#define KC_RGUI 0x00E7
+#define KC_LWIN KC_LGUI
+#define KC_RWIN KC_RGUI
+
+#define IS_MODIFIER_KEYCODE(code) ((code) >= KC_LCTL && (code) <= KC_RGUI)
+
+/* Layers */
+
+#define QK_LAYER_TAP 0x4000
+#define QK_TO 0x5200
+#define QK_MOMENTARY 0x5220
+
+#define LT(layer, kc) (QK_LAYER_TAP | (((layer) & 0xF) << 8) | ((kc) & 0xFF))
+#define TO(layer) (QK_TO | ((layer) & 0x1F))
+#define MO(layer) (QK_MOMENTARY | ((layer) & 0x1F))
+
+#define IS_QK_LAYER_TAP(code) ((code) >= QK_LAYER_TAP && (code) <= (QK_LAYER_TAP | 0x0FFF))
+#define QK_LAYER_TAP_GET_LAYER(code) (((code) >> 8) & 0xF)
+
+/* Quantum, lighting and keyboard specific keycodes */
+
+#define QK_BOOT 0x7C00
+#define QK_RBT 0x7C01
+#define NK_TOGG 0x7013
+#define BL_TOGG 0x7802
+#define BL_STEP 0x7805
+#define BL_DOWN 0x7803
+#define BL_UP 0x7804
+#define RGB_TOG 0x7820
+#define RGB_MOD 0x7821
+#define RGB_RMOD 0x7822
+#define RGB_HUI 0x7823
+#define RGB_HUD 0x7824
+#define RGB_SAI 0x7825
+#define RGB_SAD 0x7826
+#define RGB_VAI 0x7827
+#define RGB_VAD 0x7828
+#define RGB_SPI 0x7829
+#define RGB_SPD 0x782A
+
+#define KC_TASK 0x7E00
+#define KC_FILE 0x7E01
+#define KC_CTANA 0x7E02
+#define BT_HST1 0x7E03
+#define BT_HST2 0x7E04
+#define BT_HST3 0x7E05
+#define BAT_LVL 0x7E06
+
+#define SAFE_RANGE 0x7E40
+
+// clang-format on
@@ -0,0 +1,161 @@
+#include "replay.h"
+
+#include "animation/animation.h"
+#include "common/common.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* Layer state each key was pressed with. QMK releases keys on the layer they were pressed on */
+static layer_state_t press_layers[MATRIX_ROWS][MATRIX_COLS] = {0};
+
+bool sim_replay_load(FILE *file, sim_replay_t *replay) {
+    uint32_t capacity = 256;
+
+    replay->count  = 0;
+    replay->events = malloc(capacity * sizeof(capture_event_t));
+    if (!replay->events) {
+        return false;
+    }
+
+    char line[256];
+    while (fgets(line, sizeof line, file)) {
+        /* Console logs can have anything before the event */
+        const char *start = strstr(line, "capture ");
+        if (!start) {
+            continue;
+        }
+
+        unsigned long time;
+        unsigned      type, row, col, tap, mods, layers;
+        if (sscanf(start, "capture %lu %u %u %u %u %u %u", &time, &type, &row, &col, &tap, &mods, &layers) != 7) {
+            continue;
+        }
+
+        if (type >= CAPTURE_EVENT_COUNT || row >= MATRIX_ROWS || col >= MATRIX_COLS) {
+            continue;
+        }
+
+        if (replay->count == capacity) {
+            capacity *= 2;
+            capture_event_t *events = realloc(replay->events, capacity * sizeof(capture_event_t));
+            if (!events) {
+                sim_replay_free(replay);
+                return false;
+            }
+            replay->events = events;
+        }
+
+        replay->events[replay->count++] = (capture_event_t){
+            .time   = time,
+            .layers = layers,
+            .type   = type,
+            .row    = row,
+            .col    = col,
+            .tap    = tap,
+            .mods   = mods,
+        };
+    }
+
+    return !ferror(file);
+}
+
+void sim_replay_free(sim_replay_t *replay) {
+    free(replay->events);
+    replay->events = NULL;
+    replay->count  = 0;
+}
+
+uint32_t sim_replay_duration(const sim_replay_t *replay) {
+    if (!replay->count) {
+        return SIM_REPLAY_TAIL;
+    }
+
+    return replay->events[replay->count - 1].time - replay->events[0].time + SIM_REPLAY_TAIL;
+}
+
+/**
+ * @brief Finds the keycode QMK would have sent for a key: the highest active layer that doesn't have the key
+ *        transparent
+ */
+static uint16_t replay_keycode(uint8_t row, uint8_t col, layer_state_t layers) {
+    layers |= default_layer_state;
+
+    for (int8_t layer = LAYER_COUNT - 1; layer >= 0; --layer) {
+        if (!(layers & (1UL << layer))) {
+            continue;
+        }
+
+        uint16_t keycode = keymaps[layer][row][col];
+        if (keycode != KC_TRANSPARENT) {
+            return keycode;
+        }
+    }
+
+    return KC_NO;
+}
+
+/**
+ * @brief Feeds one captured event through the keymap hooks
+ */
+static void replay_event(const capture_event_t *event) {
+    if (event->type == CAPTURE_LAYER) {
+        layer_state = layer_state_set_user(event->layers);
+        return;
+    }
+
+    bool pressed = event->type == CAPTURE_KEY_DOWN;
+    if (pressed) {
+        press_layers[event->row][event->col] = event->layers;
+    }
+
+    keyrecord_t record = {
+        .event =
+            {
+                .key     = {.col = event->col, .row = event->row},
+                .pressed = pressed,
+                .time    = timer_read32(),
+            },
+        .tap = {.count = event->tap},
+    };
+
+    sim_set_mods(event->mods);
+    process_record_user(replay_keycode(event->row, event->col, press_layers[event->row][event->col]), &record);
+}
+
+uint32_t sim_replay_run(const sim_replay_t *replay, uint32_t step, sim_frame_fn on_frame, void *arg) {
+    if (!replay || !step) {
+        return 0;
+    }
+
+    sim_reset();
+    sim_set_time(SIM_START_TIME);
+    memset(press_layers, 0, sizeof press_layers);
+
+    keyboard_post_init_user();
+
+    uint32_t duration = sim_replay_duration(replay);
+    uint32_t base     = replay->count ? replay->events[0].time : 0;
+    uint32_t next     = 0;
+    uint32_t frames   = 0;
+
+    for (uint32_t elapsed = 0; elapsed < duration; elapsed += step) {
+        /* Events land at their own time, between frames */
+        while (next < replay->count && replay->events[next].time - base <= elapsed) {
+            sim_set_time(SIM_START_TIME + replay->events[next].time - base);
+            replay_event(&replay->events[next++]);
+        }
+
+        sim_set_time(SIM_START_TIME + elapsed);
+        sim_run_deferred();
+
+        const sim_frame_t *frame = sim_render_frame(elapsed == 0);
+        frames++;
+
+        if (on_frame) {
+            on_frame(arg, frame);
+        }
+    }
+
+    return frames;
+}
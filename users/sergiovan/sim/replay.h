@@ -0,0 +1,50 @@
+#pragma once
+
+#include "capture/capture.h"
+#include "scenarios.h"
+
+#include <stdio.h>
+
+/* Milliseconds rendered after the last event, so the animations it started can finish */
+#define SIM_REPLAY_TAIL 3000
+
+/**
+ * @brief A captured typing session
+ */
+typedef struct sim_replay {
+    capture_event_t *events; /* Events in the order they were captured */
+    uint32_t         count;  /* Amount of events */
+} sim_replay_t;
+
+/**
+ * @brief Reads every `capture <time> <type> <row> <col> <tap> <mods> <layers>` line of a console log. Other lines
+ *        are skipped
+ *
+ * @param file File to read from
+ * @param replay Receives the events. Free with `sim_replay_free`
+ * @return true If the file could be read
+ * @return false Otherwise
+ */
+bool sim_replay_load(FILE *file, sim_replay_t *replay);
+
+/**
+ * @brief Frees the events of a loaded replay
+ */
+void sim_replay_free(sim_replay_t *replay);
+
+/**
+ * @brief Length of a replay in milliseconds, from the first event to the end of the tail
+ */
+uint32_t sim_replay_duration(const sim_replay_t *replay);
+
+/**
+ * @brief Replays a captured session through the keymap hooks and the animation engine from a freshly reset
+ *        simulator, with the original timing. Renders one frame every `step` milliseconds
+ *
+ * @param replay Session to replay
+ * @param step Milliseconds between frames
+ * @param on_frame Called after every frame. May be NULL
+ * @param arg Argument passed to `on_frame`
+ * @return uint32_t Amount of frames rendered
+ */
+uint32_t sim_replay_run(const sim_replay_t *replay, uint32_t step, sim_frame_fn on_frame, void *arg);
@@ -0,0 +1,192 @@
+#include "scenarios.h"
+
+#include "animation/animation.h"
+#include "lib/lib8tion/lib8tion.h"
+
+/* The startup animation is done by then */
+#define SIM_STARTUP_DONE 2500
+
+/* Rough footprint of the FN and SECRET layers of both keyboards. Non-zero entries are keys the layer maps */
+#define MAPPED 2
+
+static const uint16_t fn_mask[MATRIX_ROWS][MATRIX_COLS] = {
+    [0] = {0, MAPPED, MAPPED, MAPPED, MAPPED, MAPPED, MAPPED, MAPPED, MAPPED, MAPPED, MAPPED, MAPPED, MAPPED},
+    [1] = {0, MAPPED, MAPPED, MAPPED},
+    [2] = {MAPPED, MAPPED, MAPPED, MAPPED, MAPPED, MAPPED},
+    [4] = {[6] = MAPPED, [7] = MAPPED, [9] = MAPPED, [10] = MAPPED},
+    [5] = {[12] = MAPPED},
+};
+
+static const uint16_t secret_mask[MATRIX_ROWS][MATRIX_COLS] = {
+    [0] = {MAPPED, [16] = MAPPED},
+    [5] = {[13] = MAPPED},
+};
+
+/**
+ * @brief Convenience function to check if a point in time falls inside the current frame
+ */
+static inline bool at(uint32_t elapsed, uint32_t step, uint32_t when) {
+    return when >= elapsed && when < elapsed + step;
+}
+
+/**
+ * @brief Convenience function to check if a periodic event happens during the current frame
+ */
+static inline bool every(uint32_t elapsed, uint32_t step, uint32_t period) {
+    return elapsed % period < step;
+}
+
+/**
+ * @brief LED under the FN key, where layer animations start
+ */
+static inline uint8_t fn_led(void) {
+    return g_led_config.matrix_co[5][12];
+}
+
+/* Scenarios */
+
+static void startup_step(uint32_t elapsed, uint32_t step) {
+    (void)elapsed;
+    (void)step;
+}
+
+static void typing_step(uint32_t elapsed, uint32_t step) {
+    if (elapsed < SIM_STARTUP_DONE || !every(elapsed, step, 120)) {
+        return;
+    }
+
+    uint8_t led = random8_max(SIM_FRAME_LEDS);
+
+    if (random8() < 0x20) {
+        sgv_animation_add_animation(animation_wave_solid_2(led, animation_color_hsv(random8(), 0xFF, 0xFF),
+                                                           animation_color_special(ANIMATION_COLOR_SHIMMER)));
+    } else {
+        sgv_animation_add_animation(animation_wave(led, animation_color_hsv(random8(), 0xFF, 0xFF)));
+    }
+}
+
+static void storm_step(uint32_t elapsed, uint32_t step) {
+    /* 15 keys per second, each one a wave on press and another on release */
+    static uint8_t led = 0;
+
+    if (elapsed < SIM_STARTUP_DONE) {
+        return;
+    }
+
+    if (every(elapsed, step, 67)) {
+        led = random8_max(SIM_FRAME_LEDS);
+        sgv_animation_add_animation(animation_wave_solid(led, animation_color_special(ANIMATION_COLOR_SHIMMER)));
+    } else if (every(elapsed - 40, step, 67)) {
+        sgv_animation_add_animation(animation_wave_solid(led, animation_color_val(0x00)));
+    }
+}
+
+static void layers_step(uint32_t elapsed, uint32_t step) {
+    /* Same animations the keymaps play when entering each layer */
+    if (elapsed < SIM_STARTUP_DONE || !every(elapsed, step, 800)) {
+        return;
+    }
+
+    switch ((elapsed / 800) % 3) {
+        case 0: {
+            animation_t anim = animation_wave_solid(fn_led(), animation_color_hsv(HSV_RED));
+            anim.keymap      = &fn_mask;
+            anim.hsv_colors[ANIMATION_HSV_COLOR_BASE_N] = anim.hsv_colors[ANIMATION_HSV_COLOR_RESULT_N] =
+                animation_color_hsv(HSV_BLUE);
+            sgv_animation_add_animation(anim);
+            break;
+        }
+        case 1: {
+            animation_t anim = animation_wave_solid(fn_led(), animation_color_special(ANIMATION_COLOR_SHIMMER));
+            anim.keymap      = &secret_mask;
+            anim.hsv_colors[ANIMATION_HSV_COLOR_BASE_N]   = animation_color_special(ANIMATION_COLOR_RANDOM);
+            anim.hsv_colors[ANIMATION_HSV_COLOR_RESULT_N] = animation_color_hsv(RGB_OFF);
+            sgv_animation_add_animation(anim);
+            break;
+        }
+        default:
+            sgv_animation_add_animation(animation_wave_solid(fn_led(), animation_color_hsv(RGB_OFF)));
+            break;
+    }
+}
+
+static void full_step(uint32_t elapsed, uint32_t step) {
+    /* Waves come in faster than they finish, so the queue stays 16 deep */
+    if (elapsed < SIM_STARTUP_DONE || !every(elapsed, step, 32)) {
+        return;
+    }
+
+    sgv_animation_add_animation(
+        animation_wave(random8_max(SIM_FRAME_LEDS), animation_color_hsv(random8(), 0xFF, 0xFF)));
+}
+
+static void ripples_step(uint32_t elapsed, uint32_t step) {
+    /* 25 keys per second, the ripples of keys pressed close together share an animation */
+    if (elapsed < SIM_STARTUP_DONE || !every(elapsed, step, 40)) {
+        return;
+    }
+
+    animation_t anim = animation_ripple(random8_max(SIM_FRAME_LEDS), animation_color_hsv(random8(), 0xFF, 0xFF));
+    anim.blend       = ANIMATION_BLEND_ADD;
+    sgv_animation_add_animation(anim);
+}
+
+static void shimmer_step(uint32_t elapsed, uint32_t step) {
+    if (at(elapsed, step, SIM_STARTUP_DONE)) {
+        sgv_animation_add_animation(animation_shimmer());
+    }
+    if (at(elapsed, step, 4500)) {
+        sim_set_matrix_speed(0xFF);
+    }
+    if (at(elapsed, step, 6000)) {
+        sim_set_matrix_val(0x60);
+    }
+}
+
+const sim_scenario_t sim_scenarios[] = {
+    {"startup", "Boot animation only", 4000, startup_step},
+    {"typing", "Random colored waves from a key press every 120ms", 8000, typing_step},
+    {"storm", "15 keys per second, with a wave on every press and release", 8000, storm_step},
+    {"layers", "FN and SECRET layer waves with keymap masks", 8000, layers_step},
+    {"shimmer", "Whole keyboard shimmer, then faster and dimmer", 7500, shimmer_step},
+    {"full", "A new wave every 32ms, keeping the queue 16 deep", 6000, full_step},
+    {"ripples", "A ripple every 40ms, joining the newest ripple while it has room", 6000, ripples_step},
+    {NULL, NULL, 0, NULL},
+};
+
+const sim_scenario_t *sim_scenario_find(const char *name) {
+    for (const sim_scenario_t *scenario = sim_scenarios; scenario->name; ++scenario) {
+        if (strcmp(scenario->name, name) == 0) {
+            return scenario;
+        }
+    }
+
+    return NULL;
+}
+
+uint32_t sim_scenario_run(const sim_scenario_t *scenario, uint32_t step, sim_frame_fn on_frame, void *arg) {
+    if (!scenario || !step) {
+        return 0;
+    }
+
+    sim_reset();
+    sim_set_time(SIM_START_TIME);
+
+    uint32_t frames = 0;
+    for (uint32_t elapsed = 0; elapsed < scenario->duration; elapsed += step) {
+        if (scenario->step) {
+            scenario->step(elapsed, step);
+        }
+
+        const sim_frame_t *frame = sim_render_frame(elapsed == 0);
+        frames++;
+
+        if (on_frame) {
+            on_frame(arg, frame);
+        }
+
+        sim_advance_time(step);
+    }
+
+    return frames;
+}
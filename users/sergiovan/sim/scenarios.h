@@ -0,0 +1,51 @@
+#pragma once
+
+#include "sim.h"
+
+/* Time the simulated keyboard has been on when a scenario or replay starts */
+#define SIM_START_TIME 1000
+
+/**
+ * @brief A scripted run of the animation engine, driven only through the public animation API
+ */
+typedef struct sim_scenario {
+    const char *name;        /* Short name, used to pick the scenario from the command line */
+    const char *description; /* One line description */
+    uint32_t    duration;    /* Length of the scenario in milliseconds */
+
+    /**
+     * @brief Called before each frame with the time since the scenario started, to add animations or change
+     *        matrix settings
+     *
+     * @param elapsed Milliseconds since the scenario started
+     * @param step Milliseconds between frames
+     */
+    void (*step)(uint32_t elapsed, uint32_t step);
+} sim_scenario_t;
+
+/**
+ * @brief Frame callback for `sim_scenario_run`
+ */
+typedef void (*sim_frame_fn)(void *arg, const sim_frame_t *frame);
+
+/* All available scenarios, ending in an entry with a NULL name */
+extern const sim_scenario_t sim_scenarios[];
+
+/**
+ * @brief Finds a scenario by name
+ *
+ * @param name Name of the scenario
+ * @return const sim_scenario_t* The scenario, or NULL if there is none with that name
+ */
+const sim_scenario_t *sim_scenario_find(const char *name);
+
+/**
+ * @brief Runs a scenario from a freshly reset simulator, rendering one frame every `step` milliseconds
+ *
+ * @param scenario Scenario to run
+ * @param step Milliseconds between frames
+ * @param on_frame Called after every frame. May be NULL
+ * @param arg Argument passed to `on_frame`
+ * @return uint32_t Amount of frames rendered
+ */
+uint32_t sim_scenario_run(const sim_scenario_t *scenario, uint32_t step, sim_frame_fn on_frame, void *arg);
@@ -0,0 +1,329 @@
+#include "sim.h"
+
+#include "animation/animation.h"
+#include "capture/capture.h"
+#include "lib/lib8tion/lib8tion.h"
+#include "perf/perf.h"
+#include "trace/trace.h"
+
+#include <time.h>
+
+/* Random seed every simulation starts from, so runs are reproducible */
+#define SIM_RANDOM_SEED 1337
+
+/* Same defaults QMK boots the matrix with */
+#define SIM_DEFAULT_SPEED 127
+#define SIM_DEFAULT_VAL 255
+
+/* Simulated hardware state, one per thread */
+
+static SGV_THREAD_LOCAL uint32_t     manual_time = 0;
+static SGV_THREAD_LOCAL sim_clock_fn clock_fn    = NULL;
+static SGV_THREAD_LOCAL void        *clock_arg   = NULL;
+
+static SGV_THREAD_LOCAL sim_sink_fn sink_fn  = NULL;
+static SGV_THREAD_LOCAL void       *sink_arg = NULL;
+
+static SGV_THREAD_LOCAL sim_hook_fn hook_fn  = NULL;
+static SGV_THREAD_LOCAL void       *hook_arg = NULL;
+
+static SGV_THREAD_LOCAL sim_frame_t frame = {0};
+
+static SGV_THREAD_LOCAL bool    matrix_enabled = true;
+static SGV_THREAD_LOCAL uint8_t matrix_speed   = SIM_DEFAULT_SPEED;
+static SGV_THREAD_LOCAL uint8_t matrix_val     = SIM_DEFAULT_VAL;
+static SGV_THREAD_LOCAL HSV     matrix_hsv     = {.h = 0, .s = 0xFF, .v = SIM_DEFAULT_VAL};
+
+static SGV_THREAD_LOCAL uint16_t random_seed = SIM_RANDOM_SEED;
+
+static SGV_THREAD_LOCAL bool engine_ready = false;
+
+/**
+ * @brief Convenience function that routes one LED write to the current sink
+ */
+static inline void sink(uint8_t led, uint8_t r, uint8_t g, uint8_t b) {
+    if (led >= SIM_FRAME_LEDS) {
+        return;
+    }
+
+    frame.writes++;
+
+    if (sink_fn) {
+        sink_fn(sink_arg, led, r, g, b);
+    } else {
+        frame.leds[led] = (sim_pixel_t){.r = r, .g = g, .b = b};
+    }
+}
+
+/* Simulator API */
+
+void sim_reset(void) {
+    manual_time = 0;
+    clock_fn    = NULL;
+    clock_arg   = NULL;
+
+    memset(&frame, 0, sizeof frame);
+
+    matrix_enabled = true;
+    matrix_speed   = SIM_DEFAULT_SPEED;
+    matrix_val     = SIM_DEFAULT_VAL;
+    matrix_hsv     = (HSV){.h = 0, .s = 0xFF, .v = SIM_DEFAULT_VAL};
+
+    random16_set_seed(SIM_RANDOM_SEED);
+
+    if (!engine_ready) {
+        sgv_animation_preinit();
+        engine_ready = true;
+    }
+    sgv_animation_reset();
+    sim_keyboard_reset();
+
+#if SGV_TRACE
+    trace_clear();
+#endif
+#if SGV_PERF
+    perf_reset();
+#endif
+#if SGV_CAPTURE
+    capture_clear();
+#endif
+}
+
+void sim_set_clock(sim_clock_fn clock, void *arg) {
+    clock_fn  = clock;
+    clock_arg = arg;
+}
+
+void sim_set_time(uint32_t ms) {
+    manual_time = ms;
+}
+
+void sim_advance_time(uint32_t ms) {
+    manual_time += ms;
+}
+
+void sim_set_sink(sim_sink_fn sink, void *arg) {
+    sink_fn  = sink;
+    sink_arg = arg;
+}
+
+void sim_set_animation_hook(sim_hook_fn hook, void *arg) {
+    hook_fn  = hook;
+    hook_arg = arg;
+}
+
+const sim_frame_t *sim_current_frame(void) {
+    return &frame;
+}
+
+void sim_set_matrix_enabled(bool enabled) {
+    matrix_enabled = enabled;
+}
+
+void sim_set_matrix_speed(uint8_t speed) {
+    matrix_speed = speed;
+}
+
+void sim_set_matrix_val(uint8_t val) {
+    matrix_val = val;
+}
+
+void sim_set_matrix_hsv(uint8_t h, uint8_t s, uint8_t v) {
+    matrix_hsv = (HSV){.h = h, .s = s, .v = v};
+}
+
+/**
+ * @brief Same as the sgv_custom_led/sgv_custom_rgb effects in the keymaps
+ */
+static bool sim_effect(effect_params_t *params) {
+    if (params->init) {
+#if RGB_MATRIX_ENABLE
+        rgb_matrix_set_color_all(0, 0, 0);
+#else
+        led_matrix_set_value_all(0);
+#endif
+        sgv_animation_init();
+    }
+
+    return sgv_animation_update(params);
+}
+
+const sim_frame_t *sim_render_frame(bool init) {
+    effect_params_t params = {
+        .iter  = 0,
+        .flags = LED_FLAG_ALL,
+        .init  = init,
+    };
+
+    frame.time   = timer_read32();
+    frame.writes = 0;
+
+    while (sim_effect(&params)) {
+        params.iter++;
+        params.init = false;
+    }
+
+    return &frame;
+}
+
+/* Engine hooks */
+
+#if ANIMATION_HOOKS
+void animation_hook_begin(animation_type_e type) {
+    if (hook_fn) {
+        hook_fn(hook_arg, type, false);
+    }
+}
+
+void animation_hook_end(animation_type_e type) {
+    if (hook_fn) {
+        hook_fn(hook_arg, type, true);
+    }
+}
+#endif
+
+/* QMK stubs */
+
+uint16_t *sim_rand16seed(void) {
+    return &random_seed;
+}
+
+uint32_t timer_read32(void) {
+    return clock_fn ? clock_fn(clock_arg) : manual_time;
+}
+
+uint32_t timer_elapsed32(uint32_t last) {
+    return timer_read32() - last;
+}
+
+#if SGV_TRACE
+uint32_t sim_trace_clock(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)(now.tv_sec * 1000000 + now.tv_nsec / 1000);
+}
+#endif
+
+#if SGV_PERF
+uint32_t sim_perf_clock(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)(now.tv_sec * 1000000000 + now.tv_nsec);
+}
+#endif
+
+RGB hsv_to_rgb(HSV hsv) {
+    RGB      rgb;
+    uint8_t  region, remainder, p, q, t;
+    uint16_t h, s, v;
+
+    if (hsv.s == 0) {
+        rgb.r = rgb.g = rgb.b = hsv.v;
+        return rgb;
+    }
+
+    h = hsv.h;
+    s = hsv.s;
+    v = hsv.v;
+
+    region    = h * 6 / 255;
+    remainder = (h * 2 - region * 85) * 3;
+
+    p = (v * (255 - s)) >> 8;
+    q = (v * (255 - ((s * remainder) >> 8))) >> 8;
+    t = (v * (255 - ((s * (255 - remainder)) >> 8))) >> 8;
+
+    switch (region) {
+        case 6:
+        case 0:
+            rgb.r = v;
+            rgb.g = t;
+            rgb.b = p;
+            break;
+        case 1:
+            rgb.r = q;
+            rgb.g = v;
+            rgb.b = p;
+            break;
+        case 2:
+            rgb.r = p;
+            rgb.g = v;
+            rgb.b = t;
+            break;
+        case 3:
+            rgb.r = p;
+            rgb.g = q;
+            rgb.b = v;
+            break;
+        case 4:
+            rgb.r = t;
+            rgb.g = p;
+            rgb.b = v;
+            break;
+        default:
+            rgb.r = v;
+            rgb.g = p;
+            rgb.b = q;
+            break;
+    }
+
+    return rgb;
+}
+
+#if RGB_MATRIX_ENABLE
+HSV rgb_matrix_get_hsv(void) {
+    return matrix_hsv;
+}
+
+uint8_t rgb_matrix_get_speed(void) {
+    return matrix_speed;
+}
+
+uint8_t rgb_matrix_get_val(void) {
+    return matrix_val;
+}
+
+bool rgb_matrix_is_enabled(void) {
+    return matrix_enabled;
+}
+
+bool rgb_matrix_check_finished_leds(uint8_t led_idx) {
+    return led_idx < RGB_MATRIX_LED_COUNT;
+}
+
+void rgb_matrix_set_color(int index, uint8_t red, uint8_t green, uint8_t blue) {
+    sink(index, red, green, blue);
+}
+
+void rgb_matrix_set_color_all(uint8_t red, uint8_t green, uint8_t blue) {
+    for (uint8_t i = 0; i < RGB_MATRIX_LED_COUNT; ++i) {
+        sink(i, red, green, blue);
+    }
+}
+#else
+uint8_t led_matrix_get_speed(void) {
+    return matrix_speed;
+}
+
+uint8_t led_matrix_get_val(void) {
+    return matrix_val;
+}
+
+bool led_matrix_is_enabled(void) {
+    return matrix_enabled;
+}
+
+bool led_matrix_check_finished_leds(uint8_t led_idx) {
+    return led_idx < LED_MATRIX_LED_COUNT;
+}
+
+void led_matrix_set_value(int index, uint8_t value) {
+    sink(index, value, value, value);
+}
+
+void led_matrix_set_value_all(uint8_t value) {
+    for (uint8_t i = 0; i < LED_MATRIX_LED_COUNT; ++i) {
+        sink(i, value, value, value);
+    }
+}
+#endif
@@ -0,0 +1,121 @@
+#pragma once
+
+#include QMK_KEYBOARD_H // Resolves to qmk/sim_keyboard.h in simulator builds
+
+/* Amount of LEDs on the simulated board */
+#define SIM_FRAME_LEDS SIM_LED_COUNT
+
+/**
+ * @brief One LED as the driver would have received it. LED_MATRIX boards fill r, g and b with the same value
+ */
+typedef struct sim_pixel {
+    uint8_t r;
+    uint8_t g;
+    uint8_t b;
+} sim_pixel_t;
+
+/**
+ * @brief One complete frame, as captured by the default frame sink
+ */
+typedef struct sim_frame {
+    uint32_t    time;                 /* Simulated time at which the frame was rendered */
+    uint16_t    writes;               /* Amount of set_color calls that made up this frame */
+    sim_pixel_t leds[SIM_FRAME_LEDS]; /* Final color of each LED */
+} sim_frame_t;
+
+/**
+ * @brief Clock source. Returns the current time in milliseconds
+ */
+typedef uint32_t (*sim_clock_fn)(void *arg);
+
+/**
+ * @brief Frame sink. Called once for every `rgb_matrix_set_color`/`led_matrix_set_value` call
+ */
+typedef void (*sim_sink_fn)(void *arg, uint8_t led, uint8_t r, uint8_t g, uint8_t b);
+
+/**
+ * @brief Resets the simulator: manual clock at 0, matrix enabled at full brightness and default speed, and a
+ *        fixed random seed. The frame sink and animation hook are kept
+ */
+void sim_reset(void);
+
+/**
+ * @brief Replaces the clock used by `timer_read32`
+ *
+ * @param clock Clock function, or NULL to go back to the manual clock
+ * @param arg Argument passed to the clock function
+ */
+void sim_set_clock(sim_clock_fn clock, void *arg);
+
+/**
+ * @brief Sets the manual clock to a specific time
+ *
+ * @param ms Time in milliseconds
+ */
+void sim_set_time(uint32_t ms);
+
+/**
+ * @brief Moves the manual clock forward
+ *
+ * @param ms Milliseconds to advance
+ */
+void sim_advance_time(uint32_t ms);
+
+/**
+ * @brief Replaces the frame sink. The default sink stores everything into the current frame
+ *
+ * @param sink Sink function, or NULL to go back to the default sink
+ * @param arg Argument passed to the sink function
+ */
+void sim_set_sink(sim_sink_fn sink, void *arg);
+
+/**
+ * @brief Animation hook. Called with `end` false right before the engine applies an animation, and with `end`
+ *        true right after
+ */
+typedef void (*sim_hook_fn)(void *arg, uint8_t type, bool end);
+
+/**
+ * @brief Sets a hook that is called around every animation the engine applies
+ *
+ * @param hook Hook function, or NULL to remove it
+ * @param arg Argument passed to the hook function
+ */
+void sim_set_animation_hook(sim_hook_fn hook, void *arg);
+
+/**
+ * @brief Returns the frame captured by the default sink
+ */
+const sim_frame_t *sim_current_frame(void);
+
+/* Matrix settings, as seen by rgb_matrix_get_* and led_matrix_get_* */
+
+void sim_set_matrix_enabled(bool enabled);
+void sim_set_matrix_speed(uint8_t speed);
+void sim_set_matrix_val(uint8_t val);
+void sim_set_matrix_hsv(uint8_t h, uint8_t s, uint8_t v);
+
+/* Keyboard state seen by keymap code, for replays. See keyboard.c */
+
+/**
+ * @brief Resets layers, modifiers, matrix mode and pending deferred callbacks. Called by `sim_reset`
+ */
+void sim_keyboard_reset(void);
+
+/**
+ * @brief Sets the modifiers `get_mods` returns
+ */
+void sim_set_mods(uint8_t mods);
+
+/**
+ * @brief Runs the deferred callbacks that are due, like QMK's main loop does
+ */
+void sim_run_deferred(void);
+
+/**
+ * @brief Renders one frame of the animation engine, going through every LED batch like QMK's effect task does
+ *
+ * @param init If this is the first frame of the effect, which (re)initializes the engine
+ * @return const sim_frame_t* The frame captured by the default sink
+ */
+const sim_frame_t *sim_render_frame(bool init);
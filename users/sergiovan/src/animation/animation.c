@@ -1,8 +1,11 @@
 #include "animation.h"
+#include "animation_kernel.h"
 #include "circular_buffer/circular_buffer.h"
 #include "lib/lib8tion/lib8tion.h"
 
 #include "noise/noise_gen.h"
+#include "perf/perf.h"
+#include "trace/trace.h"
 
 #include <stdlib.h>
 
@@ -10,398 +13,1697 @@
 #    error "LED_COUNT was not defined"
 #endif
 
-/* Circular buffer boilerplate */
+#if ANIMATION_HOOKS
+#    define HOOK_BEGIN(type) animation_hook_begin(type)
+#    define HOOK_END(type) animation_hook_end(type)
+#else
+#    define HOOK_BEGIN(type)
+#    define HOOK_END(type)
+#endif
 
-#define CIRCULAR_BUFFER_ELEM_SIZE sizeof(animation_t)
+/* Circular buffer boilerplate. The queue holds slots of the animation pool, which has room for a full queue */
+
+#define CIRCULAR_BUFFER_ELEM_SIZE sizeof(uint8_t)
 #define CIRCULAR_BUFFER_ELEMS 16
 #define CIRCULAR_BUFFER_BYTE_SIZE (CIRCULAR_BUFFER_ELEM_SIZE * CIRCULAR_BUFFER_ELEMS)
 
+/* Handles keep the pool slot in the low byte and its generation in the high byte. Generation 0 is never used */
+#define HANDLE_SLOT(handle) ((handle) & 0xFF)
+#define HANDLE_GENERATION(handle) ((handle) >> 8)
+#define MAKE_HANDLE(slot, generation) ((animation_handle_t)(((generation) << 8) | (slot)))
+
+/* Colors each context can hold at once. Entry 0 is always off. Animations rarely have more than two colors of their
+   own, an animation that needs one more when the table is full is rejected */
+#define COLOR_TABLE_SIZE (2 * CIRCULAR_BUFFER_ELEMS + 1)
+#define COLOR_TABLE_OFF 0
+
+/* Keymaps each context can mask animations with at once */
+#define MASK_TABLE_SIZE 8
+#define NO_MASK 0xFF
+/* Bytes of the bitmap of LEDs each keymap in the mask table lets through */
+#define MASK_BYTES ((LED_COUNT + 7) / 8)
+
+/* Ripples each context can hold at once. Queued ripples point at their entry with `packed_animation_t.led_index` */
+#define RIPPLE_TABLE_SIZE 4
+#define NO_RIPPLE 0xFF
+
+/* Start times are relative to a time base, which catches up with the frame clock once it's this far behind */
+#define TIME_REBASE_MS 0x2000
+
+/* Bits of each special color in `packed_animation_t.specials` */
+#define SPECIAL_BITS 4
+#define SPECIAL_MASK ((1 << SPECIAL_BITS) - 1)
+
 typedef struct keymap_point {
     uint8_t r;
     uint8_t c;
 } keymap_point_t;
 
-/* Memory for the circular buffer. Contains raw data */
-static uint8_t circular_buffer_mem[CIRCULAR_BUFFER_BYTE_SIZE] = {0};
+/* Reverse LED map : LED Index => Keyboard position */
+static SGV_THREAD_LOCAL keymap_point_t reverse_led_map[LED_COUNT] = {0};
 
-/* Circular buffer handle */
-static circular_buffer_t *animations = NULL;
+/* Private functions */
 
-/* Reverse LED map : LED Index => Keyboard position */
-static keymap_point_t reverse_led_map[LED_COUNT] = {0};
+/* Thickness in units of the wave. Keys are on average 10 units apart */
+#define WAVE_THICKNESS 23
+/* Longest a wave can take at full speed, in milliseconds. Lower matrix speeds stretch it */
+#define WAVE_TIME_MS 400
+#define WAVE_TIME_Q16 ((uint32_t)WAVE_TIME_MS << 16)
+#define WAVE_THICKNESS_FACTOR ((255 / (WAVE_THICKNESS)) + 1)
+
+/* Frame buffers hold one plane per channel, padded to a multiple of the word size so kernels can always
+   work on whole words */
+#define PLANE_SIZE ((LED_COUNT + sizeof(uint32_t) - 1) & ~(sizeof(uint32_t) - 1))
+
+/**
+ * @brief Color of every LED, stored as a structure of arrays. LED_MATRIX boards only have a value plane
+ */
+typedef struct color_planes {
+#if USING_RGB
+    uint8_t h[PLANE_SIZE]; /* Hue of each LED */
+    uint8_t s[PLANE_SIZE]; /* Saturation of each LED */
+#endif
+    uint8_t v[PLANE_SIZE]; /* Value of each LED */
+} color_planes_t;
+
+/* Scratch planes for the WAVE kernel: color each LED is going towards, and how far along it is */
+static SGV_THREAD_LOCAL color_planes_t wave_target          = {0};
+static SGV_THREAD_LOCAL uint8_t        wave_val[PLANE_SIZE] = {0};
+
+/* Scratch plane with the noise hue of each LED, for the animation being applied */
+static SGV_THREAD_LOCAL uint8_t noise_field[PLANE_SIZE] = {0};
+
+/* Scratch planes with what's below the blended animation being applied */
+static SGV_THREAD_LOCAL color_planes_t blend_below = {0};
+
+#if USING_RGB
+/* Final color of each LED, staged here before being written out to the driver */
+static SGV_THREAD_LOCAL RGB rgb_frame[PLANE_SIZE] = {0};
+
+/* Fully saturated, full value color of every hue at the brightness in `hue_lut_val`. Shimmer, noise and random
+   colors all end up here instead of going through hsv_to_rgb */
+static SGV_THREAD_LOCAL RGB     hue_lut[256]  = {0};
+static SGV_THREAD_LOCAL uint8_t hue_lut_val   = 0;
+static SGV_THREAD_LOCAL bool    hue_lut_ready = false;
+#endif
+
+/**
+ * @brief Time as seen by all animations in one frame. Sampled once when a frame starts
+ */
+typedef struct frame_clock {
+    uint32_t now;     /* Milliseconds at the start of the frame */
+    uint8_t  speed;   /* Matrix speed at the start of the frame */
+    uint32_t shimmer; /* Speed scaled time for the shimmer noise */
+} frame_clock_t;
+
+/**
+ * @brief Origins of one ripple. The first one is where the ripple was added, and uses the colors of the animation
+ */
+typedef struct ripple_origins {
+    uint16_t delays[ANIMATION_RIPPLE_ORIGINS]; /* When each wave starts, in milliseconds after the animation */
+    uint8_t  leds[ANIMATION_RIPPLE_ORIGINS];   /* LED each wave starts at */
+    uint8_t  colors[ANIMATION_RIPPLE_ORIGINS]; /* Color table entry of the base color of each wave but the first */
+    uint8_t  count;                            /* Amount of origins. 0 if the entry is free */
+} ripple_origins_t;
+
+_Static_assert(sizeof(packed_animation_t) == 12, "Queued animations must stay 12 bytes");
+_Static_assert(ANIMATION_TYPE_CAPACITY <= 16, "Animation types don't fit in packed_animation_t.type");
+_Static_assert(ANIMATION_TYPE_CAPACITY >= ANIMATION_TYPE_COUNT, "No room for the built in animation types");
+_Static_assert(ANIMATION_BLEND_COUNT <= 8, "Blend modes don't fit in packed_animation_t.blend");
+_Static_assert(ANIMATION_COLOR_SHIMMER <= SPECIAL_MASK, "Special colors don't fit in packed_animation_t.specials");
+_Static_assert(ANIMATION_HSV_COLOR_COUNT * SPECIAL_BITS <= 16, "Special colors don't fit in packed_animation_t");
+
+/**
+ * @brief One animation engine. Draws the LEDs of its zone from its own queue, frame buffers and clock, so zones can
+ *        run different animations and render at different rates
+ */
+struct sgv_animation_ctx {
+    packed_animation_t pool[CIRCULAR_BUFFER_ELEMS];       /* Every animation, queued or not */
+    uint8_t            generation[CIRCULAR_BUFFER_ELEMS]; /* Generation of each slot. Changes when the slot is freed */
+    bool               cancelled[CIRCULAR_BUFFER_ELEMS];  /* Slots that were cancelled but are still in the queue */
+    uint8_t            priority[CIRCULAR_BUFFER_ELEMS];   /* Priority of each slot. See `animation_priority_e` */
+    uint8_t            free_slots[CIRCULAR_BUFFER_ELEMS]; /* Stack of the slots that aren't in the queue */
+    uint8_t            free_count;                        /* Amount of free slots */
+
+    uint8_t                   queue_mem[CIRCULAR_BUFFER_BYTE_SIZE]; /* Memory for the elements of the circular buffer */
+    circular_buffer_storage_t queue_handle;                        /* Memory for the circular buffer handle */
+    circular_buffer_t        *animations;                          /* Circular buffer handle, in `queue_handle` */
+
+    COLOR   color_table[COLOR_TABLE_SIZE]; /* Colors of the pooled animations */
+    uint8_t color_refs[COLOR_TABLE_SIZE];  /* Colors of pooled animations using each entry. Entry 0 isn't counted */
+
+    const uint16_t (*mask_table[MASK_TABLE_SIZE])[MATRIX_ROWS][MATRIX_COLS]; /* Keymaps of the pooled animations */
+    uint8_t mask_refs[MASK_TABLE_SIZE];             /* Pooled animations using each keymap */
+    uint8_t mask_leds[MASK_TABLE_SIZE][MASK_BYTES]; /* LEDs each keymap lets through, one bit each */
+
+    ripple_origins_t ripples[RIPPLE_TABLE_SIZE]; /* Origins of the pooled ripples */
+
+    uint8_t  overlay_leds[MASK_BYTES];   /* LEDs with an overlay, one bit each */
+    COLOR    overlay_colors[LED_COUNT];  /* Color of each overlay */
+    int16_t  overlay_start[LED_COUNT];   /* When each overlay was set, relative to the time base */
+    uint16_t overlay_fade_ms[LED_COUNT]; /* How long each overlay takes to fade out. 0 if it never does */
+
+    uint32_t time_base; /* Start times of the pooled animations are relative to this */
+
+    color_planes_t base_state;  /* Base state at the start of each frame of all the LEDs */
+    color_planes_t calc_state;  /* Current calculated state of each LED in this frame */
+    frame_clock_t  frame_clock; /* Time of the current frame */
+
+    uint8_t shimmer_field[PLANE_SIZE]; /* Shimmer hue of each LED this frame. Filled the first time it's needed */
+    bool    shimmer_ready;             /* If `shimmer_field` was filled since the clock was last sampled */
+
+    uint16_t random_seeds[CIRCULAR_BUFFER_ELEMS]; /* Seed of the random colors of each slot, drawn when it gets any */
+    uint8_t  random_field[PLANE_SIZE];            /* Random hue of each LED of the zone, for `random_slot` */
+    uint8_t  random_slot; /* Slot `random_field` was filled for, or CIRCULAR_BUFFER_ELEMS if none */
+
+    uint8_t led_count;           /* Amount of LEDs in the zone */
+    uint8_t leds[LED_COUNT];     /* LEDs in the zone, in the order they are drawn */
+    bool    in_zone[PLANE_SIZE]; /* If each LED is part of the zone */
+};
+
+const size_t sgv_animation_ctx_type_size = sizeof(sgv_animation_ctx_t);
 
-/* Convenience functions that act on the circular buffer */
+/* Context the sgv_animation_ functions without a context work on. Covers every LED */
+static SGV_THREAD_LOCAL sgv_animation_ctx_t default_ctx = {0};
 
-static inline bool push(animation_t animation) {
-    return circular_buffer_push(animations, &animation);
+/* Convenience functions that read packed animations */
+
+static inline animation_color_special_e packed_special(const packed_animation_t *animation, uint8_t index) {
+    return (animation->specials >> (index * SPECIAL_BITS)) & SPECIAL_MASK;
+}
+
+static inline bool packed_has_random(const packed_animation_t *animation) {
+    for (uint8_t i = 0; i < ANIMATION_HSV_COLOR_COUNT; ++i) {
+        if (packed_special(animation, i) == ANIMATION_COLOR_RANDOM) {
+            return true;
+        }
+    }
+    return false;
 }
 
-static inline animation_t *pop(animation_t *animation) {
-    return circular_buffer_pop(animations, animation);
+static inline void packed_set_special(packed_animation_t *animation, uint8_t index, animation_color_special_e special) {
+    animation->specials &= ~(SPECIAL_MASK << (index * SPECIAL_BITS));
+    animation->specials |= special << (index * SPECIAL_BITS);
 }
 
-static inline bool unshift(animation_t animation) {
-    return circular_buffer_unshift(animations, &animation);
+static inline animation_color_t packed_color(sgv_animation_ctx_t *ctx, const packed_animation_t *animation,
+                                             uint8_t index) {
+    return (animation_color_t){
+        .color   = ctx->color_table[animation->colors[index]],
+        .special = packed_special(animation, index),
+    };
 }
 
-static inline animation_t *shift(animation_t *animation) {
-    return circular_buffer_shift(animations, animation);
+static inline uint32_t packed_ticks(sgv_animation_ctx_t *ctx, const packed_animation_t *animation) {
+    return ctx->time_base + animation->start;
 }
 
-static inline animation_t *at(uint8_t i) {
-    return circular_buffer_at(animations, i);
+/**
+ * @brief Converts a time to a start time relative to the time base of a context
+ *
+ * @param ctx Context the start time is for
+ * @param ticks Time to convert
+ * @param long_ago Set if the time is too far in the past to be kept, and was moved forward
+ * @return int16_t Relative start time. Times too far in the future are moved back, see `starts_too_late`
+ */
+static inline int16_t relative_start(sgv_animation_ctx_t *ctx, uint32_t ticks, bool *long_ago) {
+    int32_t start = (int32_t)(ticks - ctx->time_base);
+
+    *long_ago = start < INT16_MIN;
+    return start < INT16_MIN ? INT16_MIN : start > INT16_MAX ? INT16_MAX : start;
 }
 
-static inline bool empty(void) {
-    return circular_buffer_empty(animations);
+/**
+ * @brief Checks if a time is further in the future than a start time relative to a context can reach. Animations
+ *        that start that late are turned away instead of starting early
+ *
+ * @param ctx Context the start time is for
+ * @param ticks Time to check
+ * @return true If `relative_start` would have to move the time back
+ * @return false Otherwise
+ */
+static inline bool starts_too_late(sgv_animation_ctx_t *ctx, uint32_t ticks) {
+    return (int32_t)(ticks - ctx->time_base) > INT16_MAX;
 }
 
-static inline uint8_t length(void) {
-    return circular_buffer_length(animations);
+/* Convenience functions that act on the color and mask tables */
+
+/**
+ * @brief Finds a color in the color table, or adds it if it isn't there yet
+ *
+ * @param ctx Context to look in
+ * @param color Color to find
+ * @return uint8_t Color table entry, or COLOR_TABLE_SIZE if the table is full
+ */
+static uint8_t color_acquire(sgv_animation_ctx_t *ctx, COLOR color) {
+    if (memcmp(&color, &ctx->color_table[COLOR_TABLE_OFF], sizeof color) == 0) {
+        return COLOR_TABLE_OFF;
+    }
+
+    uint8_t free = COLOR_TABLE_SIZE;
+    for (uint8_t i = COLOR_TABLE_OFF + 1; i < COLOR_TABLE_SIZE; ++i) {
+        if (ctx->color_refs[i] == 0) {
+            free = free == COLOR_TABLE_SIZE ? i : free;
+        } else if (memcmp(&color, &ctx->color_table[i], sizeof color) == 0) {
+            ctx->color_refs[i]++;
+            return i;
+        }
+    }
+
+    if (free != COLOR_TABLE_SIZE) {
+        ctx->color_table[free] = color;
+        ctx->color_refs[free]  = 1;
+    }
+
+    return free;
 }
 
-static inline bool full(void) {
-    return circular_buffer_full(animations);
+static inline void color_release(sgv_animation_ctx_t *ctx, uint8_t entry) {
+    if (entry != COLOR_TABLE_OFF) {
+        ctx->color_refs[entry]--;
+    }
 }
 
-/* Private functions */
+/**
+ * @brief Finds a keymap in the mask table, or adds it if it isn't there yet
+ *
+ * @param ctx Context to look in
+ * @param keymap Keymap to find
+ * @return uint8_t Mask table entry, or MASK_TABLE_SIZE if the table is full
+ */
+static uint8_t mask_acquire(sgv_animation_ctx_t *ctx, const uint16_t (*keymap)[MATRIX_ROWS][MATRIX_COLS]) {
+    uint8_t free = MASK_TABLE_SIZE;
+    for (uint8_t i = 0; i < MASK_TABLE_SIZE; ++i) {
+        if (ctx->mask_refs[i] == 0) {
+            free = free == MASK_TABLE_SIZE ? i : free;
+        } else if (ctx->mask_table[i] == keymap) {
+            ctx->mask_refs[i]++;
+            return i;
+        }
+    }
 
-/* Thickness in units of the wave. Keys are on average 10 units apart */
-#define WAVE_THICKNESS 23
-#define WAVE_THICKNESS_FACTOR ((255 / (WAVE_THICKNESS)) + 1)
+    if (free != MASK_TABLE_SIZE) {
+        ctx->mask_table[free] = keymap;
+        ctx->mask_refs[free]  = 1;
 
-/* Base state at the start of each frame of all the LEDs */
-static COLOR base_state[LED_COUNT] = {{0}};
+        /* Keymaps never change, so which LEDs they let through only needs to be worked out once */
+        memset(ctx->mask_leds[free], 0, MASK_BYTES);
+        for (uint8_t led = 0; led < LED_COUNT; ++led) {
+            keymap_point_t key = reverse_led_map[led];
+            if ((*keymap)[key.r][key.c] > KC_TRANSPARENT) {
+                ctx->mask_leds[free][led >> 3] |= 1 << (led & 7);
+            }
+        }
+    }
 
-/* Current calculated state of each LED in this frame */
-static COLOR calc_state[LED_COUNT] = {{0}};
+    return free;
+}
 
 /**
- * @brief Enum holding the action that must be taken after each animation is processed
+ * @brief Takes a free entry of the ripple table
+ *
+ * @param ctx Context to look in
+ * @param led LED the first wave of the ripple starts at
+ * @return uint8_t Ripple table entry, or RIPPLE_TABLE_SIZE if the table is full
  */
-typedef enum apply_res : uint8_t {
-    APPLY_OK,         /* No action needed */
-    APPLY_CLEAR_THIS, /* Remove this element from the buffer if it's the first one */
-    APPLY_NEW_BASE,   /* Remove all elements before and including this one from the buffer */
-    BECOME_FIRST,     /* Remove all elements before this one from the buffer */
-    BECOME_SHIMMER,   /* Remove this element from the buffer if it's the first one,
-                         and convert animation into shimmer */
-} apply_res_e;
+static uint8_t ripple_acquire(sgv_animation_ctx_t *ctx, uint8_t led) {
+    for (uint8_t i = 0; i < RIPPLE_TABLE_SIZE; ++i) {
+        if (ctx->ripples[i].count == 0) {
+            ctx->ripples[i] = (ripple_origins_t){
+                .delays = {0},
+                .leds   = {led},
+                .colors = {COLOR_TABLE_OFF},
+                .count  = 1,
+            };
+            return i;
+        }
+    }
+
+    return RIPPLE_TABLE_SIZE;
+}
+
+static void ripple_release(sgv_animation_ctx_t *ctx, uint8_t entry) {
+    ripple_origins_t *ripple = &ctx->ripples[entry];
+
+    for (uint8_t i = 1; i < ripple->count; ++i) {
+        color_release(ctx, ripple->colors[i]);
+    }
+    ripple->count = 0;
+}
 
 /**
- * @brief Resets base state and calculated state to 0
+ * @brief Gives back the table entries of a packed animation
+ *
+ * @param ctx Context the animation belongs to
+ * @param animation Animation to release
+ * @param colors Amount of colors to release, from the first one
  */
-static inline void clear_all_state(void) {
-    memset(calc_state, 0, sizeof calc_state);
-    memset(base_state, 0, sizeof base_state);
+static void packed_release(sgv_animation_ctx_t *ctx, packed_animation_t *animation, uint8_t colors) {
+    for (uint8_t i = 0; i < colors; ++i) {
+        color_release(ctx, animation->colors[i]);
+    }
+
+    if (animation->mask != NO_MASK) {
+        ctx->mask_refs[animation->mask]--;
+        animation->mask = NO_MASK;
+    }
+
+    if (animation->type == RIPPLE && animation->led_index != NO_RIPPLE) {
+        ripple_release(ctx, animation->led_index);
+        animation->led_index = NO_RIPPLE;
+    }
 }
 
 /**
- * @brief Resets calc state to current base state
+ * @brief Packs an animation, taking the color and mask table entries it needs
  *
+ * @param ctx Context the animation is for
+ * @param packed Receives the packed animation
+ * @param animation Animation to pack
+ * @return true If the animation was packed
+ * @return false If one of the tables is full. Nothing was taken
  */
-static inline void clear_calc_state(void) {
-    memcpy(&calc_state, &base_state, sizeof base_state);
+static bool pack(sgv_animation_ctx_t *ctx, packed_animation_t *packed, const animation_t *animation) {
+    bool long_ago;
+
+    *packed = (packed_animation_t){
+        .start     = relative_start(ctx, animation->ticks, &long_ago),
+        .led_index = animation->type == RIPPLE ? NO_RIPPLE : animation->led_index,
+        .mask      = NO_MASK,
+        .type      = animation->type,
+        .done      = animation->done,
+        .blend     = animation->blend,
+        .alpha     = animation->alpha,
+        .specials  = 0,
+    };
+
+    /* Nothing plays for that long, except waves at the lowest speeds. Those finish now */
+    packed->done |= long_ago;
+
+    if (animation->keymap != NULL) {
+        packed->mask = mask_acquire(ctx, animation->keymap);
+        if (packed->mask == MASK_TABLE_SIZE) {
+            packed->mask = NO_MASK;
+            return false;
+        }
+    }
+
+    for (uint8_t i = 0; i < ANIMATION_HSV_COLOR_COUNT; ++i) {
+        animation_color_t color = animation->hsv_colors[i];
+
+        packed_set_special(packed, i, color.special);
+        packed->colors[i] = color.special == ANIMATION_COLOR_NONE ? color_acquire(ctx, color.color) : COLOR_TABLE_OFF;
+
+        if (packed->colors[i] == COLOR_TABLE_SIZE) {
+            packed_release(ctx, packed, i);
+            return false;
+        }
+    }
+
+    if (animation->type == RIPPLE) {
+        uint8_t entry = ripple_acquire(ctx, animation->led_index);
+        if (entry == RIPPLE_TABLE_SIZE) {
+            packed_release(ctx, packed, ANIMATION_HSV_COLOR_COUNT);
+            return false;
+        }
+        packed->led_index = entry;
+    }
+
+    return true;
 }
 
+/* Convenience functions that act on the pool and the circular buffer */
+
 /**
- * @brief Convenience function to test if a color is off, i.e. if the value is 0
+ * @brief Moves a slot to its next generation, so the handles to it stop working
  *
- * @param color The color to test for
- * @return true The value of the color is 0
- * @return false The color is visible on a LED
+ * @param ctx Context the slot belongs to
+ * @param slot Slot to move on
  */
-static inline bool hsv_is_off(COLOR color) {
-    return color.v == 0;
+static inline void next_generation(sgv_animation_ctx_t *ctx, uint8_t slot) {
+    ctx->generation[slot] = ctx->generation[slot] == 0xFF ? 1 : ctx->generation[slot] + 1;
 }
 
-/* Functions to bridge LED AND RGB */
-static inline COLOR get_matrix_default_color(void) {
-#if USING_RGB
-    return rgb_matrix_get_hsv();
+/**
+ * @brief Returns a slot to the pool, along with its table entries. Handles to it stop working
+ *
+ * @param ctx Context the slot belongs to
+ * @param slot Slot to free
+ */
+static inline void free_slot(sgv_animation_ctx_t *ctx, uint8_t slot) {
+    packed_release(ctx, &ctx->pool[slot], ANIMATION_HSV_COLOR_COUNT);
+    next_generation(ctx, slot);
+    ctx->cancelled[slot] = false;
+
+    if (ctx->random_slot == slot) {
+        ctx->random_slot = CIRCULAR_BUFFER_ELEMS;
+    }
+
+    ctx->free_slots[ctx->free_count++] = slot;
+}
+
+static inline animation_handle_t push(sgv_animation_ctx_t *ctx, const packed_animation_t *animation,
+                                      animation_priority_e priority) {
+    if (ctx->free_count == 0) {
+        return ANIMATION_HANDLE_NONE;
+    }
+
+    uint8_t slot = ctx->free_slots[ctx->free_count - 1];
+    if (!circular_buffer_push(ctx->animations, &slot)) {
+        return ANIMATION_HANDLE_NONE;
+    }
+
+    ctx->free_count--;
+    ctx->pool[slot]     = *animation;
+    ctx->priority[slot] = priority;
+
+    if (packed_has_random(animation)) {
+        ctx->random_seeds[slot] = random16();
+    }
+
+    return MAKE_HANDLE(slot, ctx->generation[slot]);
+}
+
+static inline uint8_t *slot_at(sgv_animation_ctx_t *ctx, uint8_t i) {
+    return circular_buffer_at(ctx->animations, i);
+}
+
+/**
+ * @brief Removes the first animation of the queue and frees its slot
+ *
+ * @param ctx Context to remove from
+ */
+static inline void drop_first(sgv_animation_ctx_t *ctx) {
+    uint8_t slot;
+    if (circular_buffer_shift(ctx->animations, &slot)) {
+        free_slot(ctx, slot);
+    }
+}
+
+/**
+ * @brief Removes an animation from anywhere in the queue without applying it, and frees its slot
+ *
+ * @param ctx Context to remove from
+ * @param i Position of the animation in the queue
+ */
+static inline void drop_at(sgv_animation_ctx_t *ctx, uint8_t i) {
+    uint8_t slot = *slot_at(ctx, i);
+
+    /* Everything in front of it moves back one place, then the front goes */
+    for (; i > 0; --i) {
+        *slot_at(ctx, i) = *slot_at(ctx, i - 1);
+    }
+
+    uint8_t front;
+    circular_buffer_shift(ctx->animations, &front);
+    free_slot(ctx, slot);
+}
+
+/**
+ * @brief Finds the animation a handle refers to
+ *
+ * @param ctx Context the handle belongs to
+ * @param handle Handle to look up
+ * @return packed_animation_t* The animation, or NULL if it already finished or was cancelled
+ */
+static inline packed_animation_t *handle_get(sgv_animation_ctx_t *ctx, animation_handle_t handle) {
+    uint8_t slot = HANDLE_SLOT(handle);
+    if (slot >= CIRCULAR_BUFFER_ELEMS || ctx->generation[slot] != HANDLE_GENERATION(handle) || ctx->cancelled[slot]) {
+        return NULL;
+    }
+
+    return &ctx->pool[slot];
+}
+
+static inline bool empty(sgv_animation_ctx_t *ctx) {
+    return circular_buffer_empty(ctx->animations);
+}
+
+static inline uint8_t length(sgv_animation_ctx_t *ctx) {
+    return circular_buffer_length(ctx->animations);
+}
+
+static inline bool full(sgv_animation_ctx_t *ctx) {
+    return circular_buffer_full(ctx->animations);
+}
+
+/* Where the frame clock gets the time from. NULL means `timer_read32` */
+static SGV_THREAD_LOCAL animation_clock_fn frame_clock_source = NULL;
+
+#if ANIMATION_HOOKS
+/* Hosts can swap the plane kernels and the hue table for plain per LED code, to check them against it. See
+   `sgv_animation_set_reference_kernels` */
+static SGV_THREAD_LOCAL bool reference_kernels = false;
+
+#    define REFERENCE_KERNELS() (reference_kernels)
 #else
-    return MAKE_COLOR(led_matrix_get_val());
+#    define REFERENCE_KERNELS() false
 #endif
+
+/**
+ * @brief Resets base state and calculated state to 0
+ *
+ * @param ctx Context to reset
+ */
+static inline void clear_all_state(sgv_animation_ctx_t *ctx) {
+    memset(&ctx->calc_state, 0, sizeof ctx->calc_state);
+    memset(&ctx->base_state, 0, sizeof ctx->base_state);
 }
 
-static inline uint8_t get_matrix_speed(void) {
+/**
+ * @brief Resets calc state to current base state
+ *
+ * @param ctx Context to reset
+ */
+static inline void clear_calc_state(sgv_animation_ctx_t *ctx) {
+    memcpy(&ctx->calc_state, &ctx->base_state, sizeof ctx->base_state);
+}
+
+/**
+ * @brief Convenience function to read the color of one LED out of a set of planes
+ *
+ * @param planes Planes to read from
+ * @param led LED index
+ * @return COLOR The color of the LED
+ */
+static inline COLOR planes_get(const color_planes_t *planes, uint8_t led) {
 #if USING_RGB
-    return rgb_matrix_get_speed();
+    return MAKE_COLOR(.h = planes->h[led], .s = planes->s[led], .v = planes->v[led]);
 #else
-    return led_matrix_get_speed();
+    return planes->v[led];
 #endif
 }
 
-static inline uint8_t get_matrix_val(void) {
+/**
+ * @brief Convenience function to write the color of one LED into a set of planes. Colors that are off are stored
+ *        without hue or saturation, like `planes_clear_off` leaves them
+ *
+ * @param planes Planes to write to
+ * @param led LED index
+ * @param color The color of the LED
+ */
+static inline void planes_set(color_planes_t *planes, uint8_t led, COLOR color) {
 #if USING_RGB
-    return rgb_matrix_get_val();
-#else
-    return led_matrix_get_val();
+    uint8_t keep = color.v ? 0xFF : 0x00;
+
+    planes->h[led] = color.h & keep;
+    planes->s[led] = color.s & keep;
 #endif
+    planes->v[led] = COLOR_VAL(color);
 }
 
-static inline bool get_matrix_enabled(void) {
+/* Plane kernels. These work on whole planes at once and avoid branches so loops can be vectorized */
+
+/**
+ * @brief Maps every value in `plane` towards the one in `to` by the amount in `vals`. Works like `map8`, but
+ *        the start can be larger than the end
+ *
+ * @param plane Plane with the start of each range. Receives the result
+ * @param vals How far along the range each value is, 0 being the start and 255 the end
+ * @param to Plane with the end of each range
+ * @param count Amount of values to map
+ */
+static inline void plane_map8(uint8_t *restrict plane, const uint8_t *restrict vals, const uint8_t *restrict to,
+                              uint8_t count) {
+    for (uint8_t i = 0; i < count; ++i) {
+        uint8_t a    = plane[i];
+        uint8_t b    = to[i];
+        uint8_t low  = a < b ? a : b;
+        uint8_t high = a < b ? b : a;
+        uint8_t in   = a < b ? vals[i] : 255 - vals[i];
+
+        plane[i] = low + scale8(in, high - low);
+    }
+}
+
+/**
+ * @brief Scales every value of a plane
+ *
+ * @param out Plane receiving the scaled values
+ * @param in Plane to scale
+ * @param scale Scale to apply, 255 being the identity
+ * @param count Amount of values to scale
+ */
+static inline void plane_scale8(uint8_t *restrict out, const uint8_t *restrict in, uint8_t scale, uint8_t count) {
+    for (uint8_t i = 0; i < count; ++i) {
+        out[i] = scale8(in[i], scale);
+    }
+}
+
+/**
+ * @brief Maps every color in `planes` towards the one in `to` by the amount in `vals`
+ */
+static inline void planes_map8(color_planes_t *restrict planes, const uint8_t *restrict vals,
+                               const color_planes_t *restrict to) {
 #if USING_RGB
-    return rgb_matrix_is_enabled();
-#else
-    return led_matrix_is_enabled();
+    plane_map8(planes->h, vals, to->h, PLANE_SIZE);
+    plane_map8(planes->s, vals, to->s, PLANE_SIZE);
 #endif
+    plane_map8(planes->v, vals, to->v, PLANE_SIZE);
 }
 
-static inline int matrix_check_finished_leds(uint8_t led_max) {
+/**
+ * @brief When fading between a color that is off and one that isn't, gives the off color the hue and
+ *        saturation of the other one so only the value changes. Nothing to do with only a value plane
+ *
+ * @param from Colors at the start of the fade
+ * @param to Colors at the end of the fade
+ */
+static inline void planes_match_off(color_planes_t *restrict from, color_planes_t *restrict to) {
 #if USING_RGB
-    return rgb_matrix_check_finished_leds(led_max);
+    for (uint8_t i = 0; i < PLANE_SIZE; ++i) {
+        bool from_only = from->v[i] == 0 && to->v[i] != 0;
+        bool to_only   = from->v[i] != 0 && to->v[i] == 0;
+
+        uint8_t from_h = from->h[i];
+        uint8_t from_s = from->s[i];
+
+        from->h[i] = from_only ? to->h[i] : from_h;
+        from->s[i] = from_only ? to->s[i] : from_s;
+        to->h[i]   = to_only ? from_h : to->h[i];
+        to->s[i]   = to_only ? from_s : to->s[i];
+    }
 #else
-    return led_matrix_check_finished_leds(led_max);
+    (void)from;
+    (void)to;
 #endif
 }
 
 /**
- * @brief Convenience function to generate perlin noise at a specific x, y coordinate at time t
+ * @brief Clears hue and saturation of every color that is off. Nothing to do with only a value plane
  *
- * @param x The x coordinate to get perlin noise for
- * @param y The y coordinate to get perlin noise for
- * @param t The time modifier
- * @return uint8_t Value of the perlin noise
+ * @param planes The colors to clear
  */
-static inline uint8_t get_perlin(uint8_t x, uint8_t y, uint32_t t) {
-    /* Scaling time by 1.1, 1.25 and 1.5 times, respectively */
-    uint32_t slow   = ((t * 282) >> 8);
-    uint32_t medium = ((t * 320) >> 8);
-    uint32_t fast   = ((t * 384) >> 8);
-
+static inline void planes_clear_off(color_planes_t *planes) {
 #if USING_RGB
+    for (uint8_t i = 0; i < PLANE_SIZE; ++i) {
+        uint8_t keep = planes->v[i] ? 0xFF : 0x00;
 
-    /* 0x666 is ~0.025 in u32q16 */
-    uint16_t perlin_1 = perlin2d_fixed(x + slow, y + fast, 0x666);
-    uint16_t perlin_2 = perlin2d_fixed((224 - x) + medium, y + slow, 0x666);
-    uint16_t perlin_3 = perlin2d_fixed(x + fast, (64 - y) + medium, 0x666);
-
-    return (perlin_1 + perlin_2 + perlin_3) & 0xFF;
+        planes->h[i] &= keep;
+        planes->s[i] &= keep;
+    }
 #else
-    /* 0x1666 is ~0.0875 in u32q16 */
-    uint16_t perlin_1 = perlin2d_fixed(x + slow, y + fast, 0x1666);
-    uint16_t perlin_2 = perlin2d_fixed((224 - x) + medium, y + slow, 0x1666);
-    uint16_t perlin_3 = perlin2d_fixed(x + fast, (64 - y) + medium, 0x1666);
-
-    uint32_t perlin = perlin_1 + perlin_2 + perlin_3;
+    (void)planes;
+#endif
+}
 
-    perlin *= 0xE0; // This is 0xE0 / 0x100 in u16q8
-    perlin /= 0x0300;
+/**
+ * @brief Convenience function to map8 when the start can be larger than the end
+ *
+ * @param in Value to map
+ * @param a One end of the range
+ * @param b Other end of the range
+ * @return uint8_t Mapped value
+ */
+static inline uint8_t clean_map8(uint8_t in, uint8_t a, uint8_t b) {
+    if (a < b) {
+        return map8(in, a, b);
+    } else if (b < a) {
+        return map8(255 - in, b, a);
+    } else {
+        return a;
+    }
+}
+
+/**
+ * @brief Fades between two colors. Fading from or to off only fades the value
+ *
+ * @param amount How far along the fade is
+ * @param from Color at the start of the fade
+ * @param target Color at the end of the fade
+ * @return COLOR Faded color
+ */
+static inline COLOR color_mix8(uint8_t amount, COLOR from, COLOR target) {
+#if USING_RGB
+    if (from.v == 0 && target.v != 0) {
+        from   = target;
+        from.v = 0;
+    } else if (from.v != 0 && target.v == 0) {
+        target   = from;
+        target.v = 0;
+    }
+
+    COLOR mixed = MAKE_COLOR(.h = clean_map8(amount, from.h, target.h), .s = clean_map8(amount, from.s, target.s),
+                             .v = clean_map8(amount, from.v, target.v));
+    if (mixed.v == 0) {
+        mixed.h = mixed.s = 0;
+    }
+
+    return mixed;
+#else
+    return clean_map8(amount, from, target);
+#endif
+}
+
+/**
+ * @brief Reference for `planes_match_off`, `planes_map8` and `planes_clear_off` in a row, one LED at a time
+ *
+ * @param planes Colors at the start of the fade. Receives the result
+ * @param vals How far along the fade each LED is
+ * @param to Colors at the end of the fade
+ */
+static inline void planes_blend_reference(color_planes_t *planes, const uint8_t *vals, const color_planes_t *to) {
+    for (uint8_t i = 0; i < LED_COUNT; ++i) {
+        planes_set(planes, i, color_mix8(vals[i], planes_get(planes, i), planes_get(to, i)));
+    }
+}
+
+/* Functions to bridge LED AND RGB */
+static inline COLOR get_matrix_default_color(void) {
+#if USING_RGB
+    return rgb_matrix_get_hsv();
+#else
+    return MAKE_COLOR(led_matrix_get_val());
+#endif
+}
+
+static inline uint8_t get_matrix_speed(void) {
+#if USING_RGB
+    return rgb_matrix_get_speed();
+#else
+    return led_matrix_get_speed();
+#endif
+}
+
+static inline uint8_t get_matrix_val(void) {
+#if USING_RGB
+    return rgb_matrix_get_val();
+#else
+    return led_matrix_get_val();
+#endif
+}
+
+/**
+ * @brief Reads the time from the clock frames are timed with
+ */
+static inline uint32_t frame_clock_read(void) {
+    return frame_clock_source ? frame_clock_source() : timer_read32();
+}
+
+/**
+ * @brief Samples the time for a new frame, and scales it by the matrix speed for the animations that need it
+ *
+ * @param clock Clock to sample into
+ */
+static inline void frame_clock_sample(frame_clock_t *clock) {
+    clock->now   = frame_clock_read();
+    clock->speed = get_matrix_speed();
+
+    clock->shimmer = ((clock->now >> 5) * (1 + (uint64_t)clock->speed)) >> 8;
+}
+
+/**
+ * @brief Samples the frame clock of a context, and moves its time base up to it if it fell too far behind
+ *
+ * @param ctx Context to sample the clock of
+ */
+static void sample_clock(sgv_animation_ctx_t *ctx) {
+    frame_clock_sample(&ctx->frame_clock);
+    ctx->shimmer_ready = false;
+
+    int32_t behind = (int32_t)(ctx->frame_clock.now - ctx->time_base);
+    if (behind < TIME_REBASE_MS && behind > -TIME_REBASE_MS) {
+        return;
+    }
+
+    ctx->time_base = ctx->frame_clock.now;
+
+    for (uint8_t i = 0; i < length(ctx); ++i) {
+        packed_animation_t *animation = &ctx->pool[*slot_at(ctx, i)];
+
+        bool long_ago;
+        animation->start = relative_start(ctx, ctx->time_base - behind + animation->start, &long_ago);
+        animation->done |= long_ago;
+    }
+
+    /* Fades are never longer than the start times reach back, so overlays set that long ago have faded out */
+    for (uint8_t k = 0; k < ctx->led_count; ++k) {
+        uint8_t led = ctx->leds[k];
+
+        bool long_ago;
+        ctx->overlay_start[led] = relative_start(ctx, ctx->time_base - behind + ctx->overlay_start[led], &long_ago);
+        if (long_ago && ctx->overlay_fade_ms[led]) {
+            ctx->overlay_leds[led >> 3] &= ~(1 << (led & 7));
+        }
+    }
+}
+
+static inline bool get_matrix_enabled(void) {
+#if USING_RGB
+    return rgb_matrix_is_enabled();
+#else
+    return led_matrix_is_enabled();
+#endif
+}
+
+static inline int matrix_check_finished_leds(uint8_t led_max) {
+#if USING_RGB
+    return rgb_matrix_check_finished_leds(led_max);
+#else
+    return led_matrix_check_finished_leds(led_max);
+#endif
+}
+
+/**
+ * @brief Convenience function to generate perlin noise at a specific x, y coordinate at time t
+ *
+ * @param x The x coordinate to get perlin noise for
+ * @param y The y coordinate to get perlin noise for
+ * @param t The time modifier
+ * @return uint8_t Value of the perlin noise
+ */
+static inline uint8_t get_perlin_unmeasured(uint8_t x, uint8_t y, uint32_t t) {
+    /* Scaling time by 1.1, 1.25 and 1.5 times, respectively */
+    uint32_t slow   = ((t * 282) >> 8);
+    uint32_t medium = ((t * 320) >> 8);
+    uint32_t fast   = ((t * 384) >> 8);
+
+#if USING_RGB
+
+    /* 0x666 is ~0.025 in u32q16 */
+    uint16_t perlin_1 = noise2d_fixed(x + slow, y + fast, 0x666);
+    uint16_t perlin_2 = noise2d_fixed((224 - x) + medium, y + slow, 0x666);
+    uint16_t perlin_3 = noise2d_fixed(x + fast, (64 - y) + medium, 0x666);
+
+    return (perlin_1 + perlin_2 + perlin_3) & 0xFF;
+#else
+    /* 0x1666 is ~0.0875 in u32q16 */
+    uint16_t perlin_1 = noise2d_fixed(x + slow, y + fast, 0x1666);
+    uint16_t perlin_2 = noise2d_fixed((224 - x) + medium, y + slow, 0x1666);
+    uint16_t perlin_3 = noise2d_fixed(x + fast, (64 - y) + medium, 0x1666);
+
+    uint32_t perlin = perlin_1 + perlin_2 + perlin_3;
+
+    perlin *= 0xE0; // This is 0xE0 / 0x100 in u16q8
+    perlin /= 0x0300;
+
+    return perlin & 0xFF;
+#endif
+}
+
+/**
+ * @brief Same as get_perlin_unmeasured, counted by the profiling counters
+ */
+static inline uint8_t get_perlin(uint8_t x, uint8_t y, uint32_t t) {
+    PERF_BEGIN(start);
+    uint8_t perlin = get_perlin_unmeasured(x, y, t);
+    PERF_END(PERF_PERLIN, start);
+
+    return perlin;
+}
+
+/**
+ * @brief Convenience function to find out if an led index is in the animation's keymap
+ *
+ * @param ctx Context the animation runs in
+ * @param animation Animation to check in
+ * @param led LED index
+ * @return false The animation has a keymap, and the LED index is NOT part of it
+ * @return true Otherwise
+ */
+static inline bool animation_led_in_keymap(sgv_animation_ctx_t *ctx, packed_animation_t *animation, uint8_t led) {
+    if (animation->mask != NO_MASK) {
+        return ctx->mask_leds[animation->mask][led >> 3] & (1 << (led & 7));
+    }
+    return true;
+}
+
+/**
+ * @brief Fills the shimmer field of a context for the current frame, if it isn't filled yet
+ *
+ * @param ctx Context to fill the shimmer field of
+ */
+static void shimmer_field_fill(sgv_animation_ctx_t *ctx) {
+    if (ctx->shimmer_ready) {
+        return;
+    }
+
+    uint32_t t = ctx->frame_clock.shimmer;
+    for (uint8_t k = 0; k < ctx->led_count; ++k) {
+        uint8_t i = ctx->leds[k];
+
+        ctx->shimmer_field[i] = get_perlin(g_led_config.point[i].x, g_led_config.point[i].y, t);
+    }
+
+    ctx->shimmer_ready = true;
+}
+
+/**
+ * @brief Random hue of one LED. The same seed and LED always give the same hue
+ *
+ * @param seed Seed of the animation. See `sgv_animation_ctx_t.random_seeds`
+ * @param led LED to get the hue of
+ * @return uint8_t Hue of the LED
+ */
+static inline uint8_t random_hue(uint32_t seed, uint8_t led) {
+    uint32_t x = seed ^ (led * 0x9E3779B9u);
+    x ^= x >> 16;
+    x *= 0x7FEB352Du;
+    x ^= x >> 15;
+    x *= 0x846CA68Bu;
+    x ^= x >> 16;
+    return x >> 24;
+}
+
+/**
+ * @brief Fills the random field of a context for an animation, unless it was already filled for it. The seed of an
+ *        animation never changes while it's queued, so its field is only worked out once for every LED of the zone
+ *
+ * @param ctx Context the animation runs in
+ * @param animation Animation to fill the field for, in the pool of `ctx`
+ */
+static void random_field_fill(sgv_animation_ctx_t *ctx, const packed_animation_t *animation) {
+    uint8_t slot = animation - ctx->pool;
+    if (ctx->random_slot == slot) {
+        return;
+    }
+
+    uint16_t seed = ctx->random_seeds[slot];
+    for (uint8_t k = 0; k < ctx->led_count; ++k) {
+        uint8_t i = ctx->leds[k];
+
+        ctx->random_field[i] = random_hue(seed, i);
+    }
+
+    ctx->random_slot = slot;
+}
+
+/**
+ * @brief Resolves the color slots of an animation for the current frame. Fields are only filled for the LEDs the
+ *        animation is going to look at
+ *
+ * @param ctx Context the animation runs in
+ * @param animation Animation to resolve
+ * @param leds LEDs the animation will get colors for
+ * @param led_count Amount of LEDs in `leds`
+ * @param sources Receives one source per color slot
+ */
+static void animation_resolve_sources(sgv_animation_ctx_t *ctx, packed_animation_t *animation, const uint8_t *leds,
+                                      uint8_t led_count, color_source_t sources[ANIMATION_HSV_COLOR_COUNT]) {
+    bool noise_ready = false;
+
+    for (uint8_t index = 0; index < ANIMATION_HSV_COLOR_COUNT; ++index) {
+        animation_color_t color  = packed_color(ctx, animation, index);
+        color_source_t   *source = &sources[index];
+
+        switch (color.special) {
+            case ANIMATION_COLOR_NONE:
+                *source = (color_source_t){.kind = SOURCE_CONSTANT, .color = color.color};
+                break;
+            case ANIMATION_COLOR_DEFAULT:
+                *source = (color_source_t){.kind = SOURCE_CONSTANT, .color = get_matrix_default_color()};
+                break;
+            case ANIMATION_COLOR_TRANS:
+                *source = (color_source_t){.kind = SOURCE_PASS};
+                break;
+            case ANIMATION_COLOR_RANDOM:
+                random_field_fill(ctx, animation);
+                *source = (color_source_t){.kind = SOURCE_FIELD, .field = ctx->random_field};
+                break;
+            case ANIMATION_COLOR_NOISE:
+                /* The noise of an animation is frozen at its start time, so every slot shares one field */
+                if (!noise_ready) {
+                    uint32_t t = packed_ticks(ctx, animation) << 16;
+                    for (uint8_t k = 0; k < led_count; ++k) {
+                        uint8_t i = leds[k];
+
+                        noise_field[i] = get_perlin(g_led_config.point[i].x, g_led_config.point[i].y, t);
+                    }
+                    noise_ready = true;
+                }
+                *source = (color_source_t){.kind = SOURCE_FIELD, .field = noise_field};
+                break;
+            case ANIMATION_COLOR_SHIMMER:
+                shimmer_field_fill(ctx);
+                *source = (color_source_t){.kind = SOURCE_FIELD, .field = ctx->shimmer_field};
+                break;
+            default:
+                /* Cannot be reached, but will signify something went wrong */
+                *source = (color_source_t){.kind = SOURCE_CONSTANT, .color = MAKE_COLOR(0x55, 0x55, 0x55)};
+                break;
+        }
+    }
+}
+
+/**
+ * @brief Convenience function to get the correct color from an animation
+ *
+ * @param ctx Context the animation runs in
+ * @param animation Animation to get color from
+ * @param sources Color sources of the animation for this frame. See `animation_resolve_sources`
+ * @param led LED index to get the color of
+ * @param index Which color to get, i.e. BASE or RESULT. See `animation_hsv_color_layer`
+ * @return HSV The HSV value for this animation at this time for this LED
+ */
+static inline COLOR animation_get_color_indexed(sgv_animation_ctx_t *ctx, packed_animation_t *animation,
+                                                const color_source_t *sources, uint8_t led, uint8_t index) {
+    if (!animation_led_in_keymap(ctx, animation, led)) {
+        index += ANIMATION_HSV_COLOR_BASE_N;
+    }
+
+    const color_source_t *source = &sources[index];
+
+    switch (source->kind) {
+        case SOURCE_CONSTANT:
+            return source->color;
+        case SOURCE_PASS:
+            return planes_get(&ctx->calc_state, led);
+        case SOURCE_FIELD:
+            return MAKE_COLOR(source->field[led], 0xFF, 0xFF);
+    }
+
+    return MAKE_COLOR(0x55, 0x55, 0x55); // Cannot be reached, but will signify something went wrong
+}
+
+/**
+ * @brief Convenience function equivalent to
+ *        `animation_get_color_indexed(ctx, animation, sources, led, ANIMATION_HSV_COLOR_BASE)`
+ */
+static inline COLOR animation_get_color(sgv_animation_ctx_t *ctx, packed_animation_t *animation,
+                                        const color_source_t *sources, uint8_t led) {
+    return animation_get_color_indexed(ctx, animation, sources, led, ANIMATION_HSV_COLOR_BASE);
+}
+
+/*
+ *            A diagram of the wave
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *                     WAVE
+ *          /----------------------\
+ *     OUTSIDE WAVE        INSIDE/PAST WAVE
+ * /-------------------\ /-----------------\
+ * 0        |0       255|0       255|       255          : VALUE
+ * LED      |           |           |       WAVE ORIGIN
+ * v        |           v           |       v
+ * ----------------------------------------------------
+ * l        (           (           (       o
+ * ----------------------------------------------------
+ *          ^           ^           ^
+ *  WAVE OUTER EDGE     |           WAVE INNER EDGE
+ *                   WAVE CENTER
+ *                   WAVE RADIUS
+ */
+
+/**
+ * @brief Struct with information about an LED in a wave animation
+ */
+typedef struct wave_info {
+    /* Value for the LED. Goes from 0 (start of animation til entering wave) to 255 (at the wave radius),
+       then again from 0 (right after the wave) to 255 (past the wave til end of animation) */
+    uint8_t val;
+    bool    in_wave;       /* If the LED is currently in the wave itself */
+    bool    inside_radius; /* If the LED is inside the wave radius or outside */
+} wave_info_t;
+
+/**
+ * @brief Convenience function to get wave information for an LED in an animation
+ *
+ * @param origin The LED the wave starts at
+ * @param led The LED to query information for
+ * @param wave_radius The current wave radius
+ * @return wave_info_t Information about the LED regarding the wave animation
+ */
+static inline wave_info_t animation_wave_get_key_value(uint8_t origin, uint8_t led, int64_t wave_radius) {
+    /* Wave origin */
+    uint8_t orig_x = g_led_config.point[origin].x;
+    uint8_t orig_y = g_led_config.point[origin].y;
+
+    uint8_t val = 0;
+    int16_t dx  = g_led_config.point[led].x - orig_x;
+    int16_t dy  = g_led_config.point[led].y - orig_y;
+    /* Distance to origin. Never changes per LED */
+    int16_t dist = sqrt16(dx * dx + dy * dy);
+    /* Distance to wave. Decreases, then increases */
+    uint8_t diff = llabs(dist - wave_radius);
+
+    bool in_wave       = diff < WAVE_THICKNESS;
+    bool inside_radius = wave_radius > dist;
+
+    if (in_wave) {
+        if (!inside_radius) {
+            /* When approaching the wave center from outside, go from 0 to 255 */
+            val = ease8InOutQuad(0xFF - qmul8(diff, WAVE_THICKNESS_FACTOR));
+        } else {
+            /* When approaching the wave edge from inside, go to 0 from 255 */
+            val = ease8InOutQuad(qmul8(diff, WAVE_THICKNESS_FACTOR));
+        }
+    } else {
+        if (!inside_radius) {
+            val = 0;
+        } else {
+            val = 255;
+        }
+    }
+
+    return (wave_info_t){
+        .val           = val,
+        .in_wave       = in_wave,
+        .inside_radius = inside_radius,
+    };
+}
+
+/**
+ * @brief How far along a wave is, as the time it would have been going for at full speed
+ *
+ * @param clock Time of the current frame
+ * @param ticks When the wave started
+ * @param finish If the wave must be at its end
+ * @return uint32_t Time in u32q16 milliseconds, up to WAVE_TIME_Q16 once the wave is over
+ */
+static inline uint32_t wave_active_for(const frame_clock_t *clock, uint32_t ticks, bool finish) {
+    /* Same as scale16by8, without cutting the time to 16 bits first. Waves at speed 0 take longer than that */
+    uint64_t active_ms = ((uint64_t)(clock->now - ticks) * (1 + clock->speed)) >> 8;
+
+    // Guarantees safe passage + stoppage
+    if (active_ms >= WAVE_TIME_MS || finish) {
+        return WAVE_TIME_Q16;
+    }
+    return active_ms << 16;
+}
+
+/**
+ * @brief Radius of a wave
+ *
+ * @param active_for How far along the wave is. See `wave_active_for`
+ * @return uint32_t Radius in the units of the LED positions
+ */
+static inline uint32_t wave_radius(uint32_t active_for) {
+    const uint32_t u32q16_255_400 = 0xa333; // 255 / 400 in u32q16
+
+    // Result of multiplication is u64q32
+    // but we bring it back to u32q16
+    // Cutting off 4 bytes at the top is ok since (400 << 16) * 0xA333 is only
+    // 0xfeffb00000
+    return ((uint64_t)active_for * u32q16_255_400) >> 32;
+}
+
+/**
+ * @brief Moves every LED of the zone from its calculated color towards `wave_target`, by `wave_val`
+ *
+ * @param ctx Context the wave runs in
+ */
+static void wave_blend(sgv_animation_ctx_t *ctx) {
+    /* Blend the whole frame at once */
+    if (REFERENCE_KERNELS()) {
+        planes_blend_reference(&ctx->calc_state, wave_val, &wave_target);
+    } else {
+        planes_match_off(&ctx->calc_state, &wave_target);
+        planes_map8(&ctx->calc_state, wave_val, &wave_target);
+        planes_clear_off(&ctx->calc_state);
+    }
+}
+
+/* Animation types. Each type has its own kernels, and the engine only ever goes through `type_def` */
+
+static inline bool color_opaque(const packed_animation_t *animation, uint8_t index) {
+    return packed_special(animation, index) != ANIMATION_COLOR_TRANS;
+}
+
+/* Types with one color are opaque if their base colors are */
+static bool one_color_is_opaque(const packed_animation_t *animation) {
+    bool base = color_opaque(animation, ANIMATION_HSV_COLOR_BASE);
+
+    if (animation->mask == NO_MASK) {
+        // No holes
+        return base;
+    }
+    return base && color_opaque(animation, ANIMATION_HSV_COLOR_BASE_N);
+}
+
+/* Types with two colors are opaque if their base and result colors are */
+static bool two_color_is_opaque(const packed_animation_t *animation) {
+    bool result = color_opaque(animation, ANIMATION_HSV_COLOR_RESULT);
+
+    if (animation->mask == NO_MASK) {
+        // No holes
+        return one_color_is_opaque(animation) && result;
+    }
+    return one_color_is_opaque(animation) && result && color_opaque(animation, ANIMATION_HSV_COLOR_RESULT_N);
+}
+
+/* Resolves the colors of the LED the animation is on */
+static void resolve_key(sgv_animation_ctx_t *ctx, packed_animation_t *animation,
+                        color_source_t sources[ANIMATION_HSV_COLOR_COUNT]) {
+    animation_resolve_sources(ctx, animation, &animation->led_index, 1, sources);
+}
+
+/* Resolves the colors of every LED of the zone */
+static void resolve_zone(sgv_animation_ctx_t *ctx, packed_animation_t *animation,
+                         color_source_t sources[ANIMATION_HSV_COLOR_COUNT]) {
+    animation_resolve_sources(ctx, animation, ctx->leds, ctx->led_count, sources);
+}
+
+static apply_res_e solid_key_apply(sgv_animation_ctx_t *ctx, packed_animation_t *animation,
+                                   const color_source_t *sources, bool first, bool new_base, bool finish) {
+    uint8_t led = animation->led_index;
+
+    planes_set(&ctx->calc_state, led, animation_get_color(ctx, animation, sources, led));
+    if (new_base) {
+        planes_set(&ctx->base_state, led, animation_get_color(ctx, animation, sources, led));
+    }
+    return APPLY_CLEAR_THIS;
+}
+
+static apply_res_e solid_all_apply(sgv_animation_ctx_t *ctx, packed_animation_t *animation,
+                                   const color_source_t *sources, bool first, bool new_base, bool finish) {
+    /* The usual case, one color everywhere, is a plain fill */
+    if (animation->mask == NO_MASK && sources[ANIMATION_HSV_COLOR_BASE].kind == SOURCE_CONSTANT) {
+        COLOR color = sources[ANIMATION_HSV_COLOR_BASE].color;
+
+        for (uint8_t k = 0; k < ctx->led_count; ++k) {
+            planes_set(&ctx->calc_state, ctx->leds[k], color);
+        }
+        if (new_base) {
+            for (uint8_t k = 0; k < ctx->led_count; ++k) {
+                planes_set(&ctx->base_state, ctx->leds[k], color);
+            }
+        }
+        return new_base ? APPLY_NEW_BASE : APPLY_OK;
+    }
+
+    for (uint8_t k = 0; k < ctx->led_count; ++k) {
+        uint8_t i     = ctx->leds[k];
+        COLOR   new_c = animation_get_color(ctx, animation, sources, i);
+        planes_set(&ctx->calc_state, i, new_c);
+        if (new_base) {
+            planes_set(&ctx->base_state, i, new_c);
+        }
+    }
+    return new_base ? APPLY_NEW_BASE : APPLY_OK;
+}
+
+static apply_res_e shimmer_apply(sgv_animation_ctx_t *ctx, packed_animation_t *animation,
+                                 const color_source_t *sources, bool first, bool new_base, bool finish) {
+    shimmer_field_fill(ctx);
+
+    for (uint8_t k = 0; k < ctx->led_count; ++k) {
+        uint8_t i = ctx->leds[k];
+        if (animation_led_in_keymap(ctx, animation, i)) {
+            planes_set(&ctx->calc_state, i, MAKE_COLOR(ctx->shimmer_field[i], 0xFF, 0xFF));
+        } else {
+            planes_set(&ctx->calc_state, i, packed_color(ctx, animation, ANIMATION_HSV_COLOR_BASE_N).color);
+        }
+    }
+    return (new_base && !first) ? BECOME_FIRST : APPLY_OK;
+}
+
+/**
+ * @brief Finishes a wave that went over every LED, leaving its result colors behind
+ *
+ * @param ctx Context the wave runs in
+ * @param animation The wave
+ * @param sources Color sources of the wave for this frame
+ * @param new_base If the wave can become the new base state
+ * @return apply_res_e The result of the last frame of the wave
+ */
+static apply_res_e wave_end(sgv_animation_ctx_t *ctx, packed_animation_t *animation, const color_source_t *sources,
+                            bool new_base) {
+    animation->done = true;
+    // Intended color
+    if (packed_special(animation, ANIMATION_HSV_COLOR_RESULT) == ANIMATION_COLOR_SHIMMER) {
+        return BECOME_NEXT;
+    }
+
+    for (uint8_t k = 0; k < ctx->led_count; ++k) {
+        uint8_t i     = ctx->leds[k];
+        COLOR   new_c = animation_get_color_indexed(ctx, animation, sources, i, ANIMATION_HSV_COLOR_RESULT);
+        planes_set(&ctx->calc_state, i, new_c);
+        if (new_base) {
+            planes_set(&ctx->base_state, i, new_c);
+        }
+    }
+    return new_base ? APPLY_NEW_BASE : APPLY_OK;
+}
+
+static apply_res_e wave_apply(sgv_animation_ctx_t *ctx, packed_animation_t *animation, const color_source_t *sources,
+                              bool first, bool new_base, bool finish) {
+    uint32_t active_for = wave_active_for(&ctx->frame_clock, packed_ticks(ctx, animation), finish);
+    uint32_t radius     = wave_radius(active_for);
+
+    bool any_left = false;
+
+    for (uint8_t k = 0; k < ctx->led_count; ++k) {
+        uint8_t     i    = ctx->leds[k];
+        wave_info_t info = animation_wave_get_key_value(animation->led_index, i, radius);
+        COLOR       current_col;
+        COLOR       target_col;
+
+        if (info.in_wave || !info.inside_radius) {
+            any_left = true;
+        }
+
+        if (!info.inside_radius) {
+            current_col = planes_get(&ctx->calc_state, i);
+            target_col  = animation_get_color_indexed(ctx, animation, sources, i, ANIMATION_HSV_COLOR_BASE);
+        } else {
+            current_col = animation_get_color_indexed(ctx, animation, sources, i, ANIMATION_HSV_COLOR_BASE);
+            target_col  = animation_get_color_indexed(ctx, animation, sources, i, ANIMATION_HSV_COLOR_RESULT);
+        }
+
+        planes_set(&ctx->calc_state, i, current_col);
+        planes_set(&wave_target, i, target_col);
+        wave_val[i] = info.val;
+    }
+
+    wave_blend(ctx);
+
+    if (!any_left || active_for == WAVE_TIME_Q16) {
+        return wave_end(ctx, animation, sources, new_base);
+    }
+
+    return APPLY_OK;
+}
+
+/**
+ * @brief Same as `animation_wave_get_key_value`. Most LEDs are far from the edge of most waves of a ripple, so those
+ *        are told apart without working out the distance
+ */
+static inline wave_info_t ripple_wave_get_key_value(uint8_t origin, uint8_t led, uint32_t wave_radius) {
+    uint16_t dx = abs(g_led_config.point[led].x - g_led_config.point[origin].x);
+    uint16_t dy = abs(g_led_config.point[led].y - g_led_config.point[origin].y);
+
+    /* The distance is at least the longer side, and at most both sides together */
+    if ((dx > dy ? dx : dy) >= wave_radius + WAVE_THICKNESS) {
+        return (wave_info_t){.val = 0, .in_wave = false, .inside_radius = false};
+    }
+    if (dx + dy + WAVE_THICKNESS <= wave_radius) {
+        return (wave_info_t){.val = 255, .in_wave = false, .inside_radius = true};
+    }
+
+    return animation_wave_get_key_value(origin, led, wave_radius);
+}
+
+/* Base color of one wave of a ripple. Waves after the first have their own, unless the base color is special */
+static inline COLOR ripple_base_color(sgv_animation_ctx_t *ctx, packed_animation_t *animation,
+                                      const color_source_t *sources, uint8_t origin, uint8_t led) {
+    if (origin != 0 && packed_special(animation, ANIMATION_HSV_COLOR_BASE) == ANIMATION_COLOR_NONE &&
+        animation_led_in_keymap(ctx, animation, led)) {
+        return ctx->color_table[ctx->ripples[animation->led_index].colors[origin]];
+    }
+    return animation_get_color_indexed(ctx, animation, sources, led, ANIMATION_HSV_COLOR_BASE);
+}
+
+static apply_res_e ripple_apply(sgv_animation_ctx_t *ctx, packed_animation_t *animation,
+                                const color_source_t *sources, bool first, bool new_base, bool finish) {
+    ripple_origins_t *ripple = &ctx->ripples[animation->led_index];
+    uint32_t          ticks  = packed_ticks(ctx, animation);
+
+    /* Waves that already started, and how big they are. The first one always did, or this wouldn't be applied */
+    uint8_t  started[ANIMATION_RIPPLE_ORIGINS];
+    uint32_t radius[ANIMATION_RIPPLE_ORIGINS];
+    uint8_t  count    = 0;
+    bool     all_over = true;
+
+    for (uint8_t o = 0; o < ripple->count; ++o) {
+        uint32_t start = ticks + ripple->delays[o];
+        if (!finish && !timer_expired32(ctx->frame_clock.now, start)) {
+            all_over = false;
+            continue;
+        }
+
+        uint32_t active_for = wave_active_for(&ctx->frame_clock, start, finish);
+        all_over            = all_over && active_for == WAVE_TIME_Q16;
+        started[count]      = o;
+        radius[count++]     = wave_radius(active_for);
+    }
+
+    /* Waves that didn't start yet still have every LED left */
+    bool any_left = count != ripple->count;
+
+    /* Every LED is looked at once. Outside of every wave it goes towards the base color of the strongest wave coming
+       its way, like with a single wave. Inside of any wave it follows the wave that's closest to still covering it,
+       and a wave coming its way counts as one that's about to. Waves that are far away change nothing either way */
+    for (uint8_t k = 0; k < ctx->led_count; ++k) {
+        uint8_t i = ctx->leds[k];
+
+        bool    inside      = false;
+        bool    in_wave     = false;
+        uint8_t outside_val = 0x00;
+        uint8_t outside_o   = 0;
+        uint8_t inside_val  = 0xFF;
+        uint8_t inside_o    = 0;
+
+        for (uint8_t w = 0; w < count; ++w) {
+            wave_info_t info = ripple_wave_get_key_value(ripple->leds[started[w]], i, radius[w]);
+            uint8_t     val  = info.inside_radius ? info.val : 0xFF - info.val;
+
+            inside  = inside || info.inside_radius;
+            in_wave = in_wave || info.in_wave;
+
+            if (!info.inside_radius && info.val > outside_val) {
+                outside_val = info.val;
+                outside_o   = started[w];
+            }
+            if (val < inside_val) {
+                inside_val = val;
+                inside_o   = started[w];
+            }
+        }
+
+        if (in_wave || !inside) {
+            any_left = true;
+        }
+
+        COLOR current_col;
+        COLOR target_col;
+
+        if (!inside) {
+            current_col = planes_get(&ctx->calc_state, i);
+            target_col  = ripple_base_color(ctx, animation, sources, outside_o, i);
+            wave_val[i] = outside_val;
+        } else {
+            current_col = ripple_base_color(ctx, animation, sources, inside_o, i);
+            target_col  = animation_get_color_indexed(ctx, animation, sources, i, ANIMATION_HSV_COLOR_RESULT);
+            wave_val[i] = inside_val;
+        }
+
+        planes_set(&ctx->calc_state, i, current_col);
+        planes_set(&wave_target, i, target_col);
+    }
+
+    wave_blend(ctx);
+
+    if (!any_left || all_over) {
+        return wave_end(ctx, animation, sources, new_base);
+    }
 
-    return perlin & 0xFF;
-#endif
+    return APPLY_OK;
 }
 
-/**
- * @brief Convenience function to find out if an led index is in the animation's keymap
- *
- * @param animation Animation to check in
- * @param led LED index
- * @return false The animation has a keymap, and the LED index is NOT part of it
- * @return true Otherwise
- */
-static inline bool animation_led_in_keymap(animation_t *animation, uint8_t led) {
-    if (animation->keymap != NULL) {
-        keymap_point_t key = reverse_led_map[led];
-        if ((*animation->keymap)[key.r][key.c] <= KC_TRANSPARENT) {
-            return false;
-        }
+/* Waves that end in a shimmer turn into one */
+static void wave_finish(sgv_animation_ctx_t *ctx, packed_animation_t *animation) {
+    /* Turned into a shimmer in place, so its handle keeps working. The result colors move to the base colors along
+       with their table entries, and the new result colors are off */
+    animation->done = false;
+    animation->type = SHIMMER;
+
+    /* The shimmer it left behind is as important as one added on its own, keypress waves must not push it out */
+    uint8_t slot = animation - ctx->pool;
+    if (ctx->priority[slot] < ANIMATION_PRIORITY_AMBIENT) {
+        ctx->priority[slot] = ANIMATION_PRIORITY_AMBIENT;
     }
-    return true;
+
+    color_release(ctx, animation->colors[ANIMATION_HSV_COLOR_BASE]);
+    color_release(ctx, animation->colors[ANIMATION_HSV_COLOR_BASE_N]);
+    animation->colors[ANIMATION_HSV_COLOR_BASE]     = animation->colors[ANIMATION_HSV_COLOR_RESULT];
+    animation->colors[ANIMATION_HSV_COLOR_BASE_N]   = animation->colors[ANIMATION_HSV_COLOR_RESULT_N];
+    animation->colors[ANIMATION_HSV_COLOR_RESULT]   = COLOR_TABLE_OFF;
+    animation->colors[ANIMATION_HSV_COLOR_RESULT_N] = COLOR_TABLE_OFF;
+
+    packed_set_special(animation, ANIMATION_HSV_COLOR_BASE, packed_special(animation, ANIMATION_HSV_COLOR_RESULT));
+    packed_set_special(animation, ANIMATION_HSV_COLOR_BASE_N, packed_special(animation, ANIMATION_HSV_COLOR_RESULT_N));
+    packed_set_special(animation, ANIMATION_HSV_COLOR_RESULT, ANIMATION_COLOR_NONE);
+    packed_set_special(animation, ANIMATION_HSV_COLOR_RESULT_N, ANIMATION_COLOR_NONE);
 }
 
-/**
- * @brief Convenience function to get the correct color from an animation
- *
- * @param animation Animation to get color from
- * @param led LED index to get the color of
- * @param index Which color to get, i.e. BASE or RESULT. See `animation_hsv_color_layer`
- * @return HSV The HSV value for this animation at this time for this LED
- */
-static COLOR animation_get_color_indexed(animation_t *animation, uint8_t led, uint8_t index) {
-    if (!animation_led_in_keymap(animation, led)) {
-        index += ANIMATION_HSV_COLOR_BASE_N;
-    }
+/* Ripples that end in a shimmer give their origins back, then turn into one like waves do */
+static void ripple_finish(sgv_animation_ctx_t *ctx, packed_animation_t *animation) {
+    ripple_release(ctx, animation->led_index);
+    animation->led_index = 0;
 
-    if (index >= ANIMATION_HSV_COLOR_COUNT) {
-        index = ANIMATION_HSV_COLOR_BASE;
-    }
+    wave_finish(ctx, animation);
+}
 
-    animation_color_t color = animation->hsv_colors[index];
+/* Built in animation types. Other modules add theirs with `sgv_animation_register_type` */
+static const animation_type_def_t animation_types[ANIMATION_TYPE_COUNT] = {
+    [SOLID_KEY] = {resolve_key, solid_key_apply, NULL, one_color_is_opaque},
+    [SOLID_ALL] = {resolve_zone, solid_all_apply, NULL, one_color_is_opaque},
+    [SHIMMER]   = {resolve_zone, shimmer_apply, NULL, one_color_is_opaque},
+    [WAVE]      = {resolve_zone, wave_apply, wave_finish, two_color_is_opaque},
+    [RIPPLE]    = {resolve_zone, ripple_apply, ripple_finish, two_color_is_opaque},
+};
 
-    switch (color.special) {
-        case ANIMATION_COLOR_NONE:
-            return color.color;
-        case ANIMATION_COLOR_DEFAULT:
-            return get_matrix_default_color();
-        case ANIMATION_COLOR_TRANS:
-            return calc_state[led];
-        case ANIMATION_COLOR_RANDOM:
-            return MAKE_COLOR(random8(), 0xFF, 0xFF);
-        case ANIMATION_COLOR_NOISE: {
-            uint8_t x = g_led_config.point[led].x;
-            uint8_t y = g_led_config.point[led].y;
+/* Registered animation types, after the built in ones. Shared by every context and thread, like the built in ones */
+static animation_type_def_t registered_types[ANIMATION_TYPE_CAPACITY - ANIMATION_TYPE_COUNT] = {0};
+static uint8_t              type_count                                                     = ANIMATION_TYPE_COUNT;
 
-            uint8_t hue = get_perlin(x, y, animation->ticks << 16);
+static inline const animation_type_def_t *type_def(uint8_t type) {
+    return type < ANIMATION_TYPE_COUNT ? &animation_types[type] : &registered_types[type - ANIMATION_TYPE_COUNT];
+}
 
-            return MAKE_COLOR(hue, 0xFF, 0xFF);
-        }
-        case ANIMATION_COLOR_SHIMMER: {
-            uint8_t x = g_led_config.point[led].x;
-            uint8_t y = g_led_config.point[led].y;
+animation_type_e sgv_animation_register_type(const animation_type_def_t *def) {
+    if (def == NULL || def->resolve == NULL || def->apply == NULL || def->is_opaque == NULL ||
+        type_count == ANIMATION_TYPE_CAPACITY) {
+        return ANIMATION_TYPE_CAPACITY;
+    }
 
-            uint32_t t = timer_read32() >> 5;
+    registered_types[type_count - ANIMATION_TYPE_COUNT] = *def;
+    return type_count++;
+}
 
-            t = (t * (1 + ((uint64_t)get_matrix_speed()))) >> 8;
+void sgv_animation_kernel_resolve_key(sgv_animation_ctx_t *ctx, packed_animation_t *animation,
+                                      color_source_t sources[ANIMATION_HSV_COLOR_COUNT]) {
+    resolve_key(ctx, animation, sources);
+}
 
-            uint8_t color = get_perlin(x, y, t);
+void sgv_animation_kernel_resolve_zone(sgv_animation_ctx_t *ctx, packed_animation_t *animation,
+                                       color_source_t sources[ANIMATION_HSV_COLOR_COUNT]) {
+    resolve_zone(ctx, animation, sources);
+}
 
-            return MAKE_COLOR(.h = color, .s = 0xFF, .v = 0xFF);
-        }
-    }
+bool sgv_animation_kernel_one_color_is_opaque(const packed_animation_t *animation) {
+    return one_color_is_opaque(animation);
+}
 
-    return MAKE_COLOR(0x55, 0x55, 0x55); // Cannot be reached, but will signify something went wrong
+bool sgv_animation_kernel_two_color_is_opaque(const packed_animation_t *animation) {
+    return two_color_is_opaque(animation);
 }
 
-/**
- * @brief Convenience function equivalent to `animation_get_color_indexed(animation, led, ANIMATION_HSV_COLOR_BASE)`
- */
-static inline COLOR animation_get_color(animation_t *animation, uint8_t led) {
-    return animation_get_color_indexed(animation, led, ANIMATION_HSV_COLOR_BASE);
+const uint8_t *sgv_animation_kernel_leds(const sgv_animation_ctx_t *ctx, uint8_t *led_count) {
+    *led_count = ctx->led_count;
+    return ctx->leds;
 }
 
-/*
- *            A diagram of the wave
- * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
- *                     WAVE
- *          /----------------------\
- *     OUTSIDE WAVE        INSIDE/PAST WAVE
- * /-------------------\ /-----------------\
- * 0        |0       255|0       255|       255          : VALUE
- * LED      |           |           |       WAVE ORIGIN
- * v        |           v           |       v
- * ----------------------------------------------------
- * l        (           (           (       o
- * ----------------------------------------------------
- *          ^           ^           ^
- *  WAVE OUTER EDGE     |           WAVE INNER EDGE
- *                   WAVE CENTER
- *                   WAVE RADIUS
- */
+uint32_t sgv_animation_kernel_elapsed(const sgv_animation_ctx_t *ctx, const packed_animation_t *animation) {
+    return ctx->frame_clock.now - (ctx->time_base + animation->start);
+}
 
-/**
- * @brief Struct with information about an LED in a wave animation
- */
-typedef struct wave_info {
-    /* Value for the LED. Goes from 0 (start of animation til entering wave) to 255 (at the wave radius),
-       then again from 0 (right after the wave) to 255 (past the wave til end of animation) */
-    uint8_t val;
-    bool    in_wave;       /* If the LED is currently in the wave itself */
-    bool    inside_radius; /* If the LED is inside the wave radius or outside */
-} wave_info_t;
+COLOR sgv_animation_kernel_color(sgv_animation_ctx_t *ctx, packed_animation_t *animation,
+                                 const color_source_t *sources, uint8_t led, uint8_t index) {
+    return animation_get_color_indexed(ctx, animation, sources, led, index);
+}
 
-/**
- * @brief Convenience function to get wave information for an LED in an animation
- *
- * @param animation The animation to get information for
- * @param led The LED to query information for
- * @param wave_radius The current wave radius
- * @return wave_info_t Information about the LED regarding the wave animation
- */
-static inline wave_info_t animation_wave_get_key_value(animation_t *animation, uint8_t led, int64_t wave_radius) {
-    /* Wave origin */
-    uint8_t orig_x = g_led_config.point[animation->led_index].x;
-    uint8_t orig_y = g_led_config.point[animation->led_index].y;
+void sgv_animation_kernel_draw(sgv_animation_ctx_t *ctx, uint8_t led, COLOR color, bool new_base) {
+    planes_set(&ctx->calc_state, led, color);
+    if (new_base) {
+        planes_set(&ctx->base_state, led, color);
+    }
+}
 
-    uint8_t val = 0;
-    int16_t dx  = g_led_config.point[led].x - orig_x;
-    int16_t dy  = g_led_config.point[led].y - orig_y;
-    /* Distance to origin. Never changes per LED */
-    int16_t dist = sqrt16(dx * dx + dy * dy);
-    /* Distance to wave. Decreases, then increases */
-    uint8_t diff = llabs(dist - wave_radius);
+/* Blend modes. Blended animations draw a layer over the neutral color of their mode, which the compositor then
+   combines with what was below in one pass */
 
-    bool in_wave       = diff < WAVE_THICKNESS;
-    bool inside_radius = wave_radius > dist;
+static inline COLOR color_with_val(COLOR color, uint8_t val) {
+#if USING_RGB
+    color.v = val;
+    return color;
+#else
+    return val;
+#endif
+}
 
-    if (in_wave) {
-        if (!inside_radius) {
-            /* When approaching the wave center from outside, go from 0 to 255 */
-            val = ease8InOutQuad(0xFF - qmul8(diff, WAVE_THICKNESS_FACTOR));
-        } else {
-            /* When approaching the wave edge from inside, go to 0 from 255 */
-            val = ease8InOutQuad(qmul8(diff, WAVE_THICKNESS_FACTOR));
-        }
-    } else {
-        if (!inside_radius) {
-            val = 0;
-        } else {
-            val = 255;
-        }
+/**
+ * @brief Adds two colors. The values add up, saturating, and the hue and saturation lean towards whichever color
+ *        brings more light, so a color added over a full one still shows
+ *
+ * @param below Color below
+ * @param layer Color added over it
+ * @return COLOR The sum of both
+ */
+static inline COLOR color_add(COLOR below, COLOR layer) {
+#if USING_RGB
+    uint16_t total = below.v + layer.v;
+    if (total == 0) {
+        return below;
     }
 
-    return (wave_info_t){
-        .val           = val,
-        .in_wave       = in_wave,
-        .inside_radius = inside_radius,
-    };
+    uint8_t amount = (uint16_t)(layer.v * 0xFF) / total;
+    return color_with_val(color_mix8(amount, below, layer), qadd8(below.v, layer.v));
+#else
+    return qadd8(below, layer);
+#endif
 }
 
 /**
- * @brief Convenience function for checking if an animation can have "holes"
+ * @brief Saves what's below a blended animation, and fills its zone with the color that leaves it unchanged
  *
- * @param animation The animation to check
- * @return true If this animation could possibly show the animations before it
- * @return false If this animation covers all keys
+ * @param ctx Context the animation runs in
+ * @param animation Animation about to be applied
+ * @param first If this animation is the first in the queue
  */
-static inline bool can_apply_new_base(animation_t *animation) {
-    animation_color_t(*colors)[4] = &animation->hsv_colors;
+static void layer_begin(sgv_animation_ctx_t *ctx, const packed_animation_t *animation, bool first) {
+    /* The first animation is always over the base state. Evicted animations are first too, but the calculated state
+       still has the previous frame in it */
+    if (first) {
+        memcpy(&ctx->calc_state, &ctx->base_state, sizeof ctx->calc_state);
+    }
+    memcpy(&blend_below, &ctx->calc_state, sizeof blend_below);
+
+    COLOR neutral;
+    switch (animation->blend) {
+        case ANIMATION_BLEND_ADD:
+        case ANIMATION_BLEND_MAX:
+            neutral = MAKE_COLOR(COLOR_OFF);
+            break;
+        case ANIMATION_BLEND_MULTIPLY:
+#if USING_RGB
+            neutral = MAKE_COLOR(.h = 0, .s = 0, .v = 0xFF);
+#else
+            neutral = MAKE_COLOR(0xFF);
+#endif
+            break;
+        default:
+            /* Alpha fades from what's below, so transparent colors are what's below already */
+            return;
+    }
 
-    if (animation->type >= WAVE) {
-        // Uses colors 1 and 2
-        if (animation->keymap == NULL) {
-            // No holes
-            return (*colors)[ANIMATION_HSV_COLOR_BASE].special != ANIMATION_COLOR_TRANS &&
-                   (*colors)[ANIMATION_HSV_COLOR_RESULT].special != ANIMATION_COLOR_TRANS;
-        } else {
-            return (*colors)[ANIMATION_HSV_COLOR_BASE].special != ANIMATION_COLOR_TRANS &&
-                   (*colors)[ANIMATION_HSV_COLOR_RESULT].special != ANIMATION_COLOR_TRANS &&
-                   (*colors)[ANIMATION_HSV_COLOR_BASE_N].special != ANIMATION_COLOR_TRANS &&
-                   (*colors)[ANIMATION_HSV_COLOR_RESULT_N].special != ANIMATION_COLOR_TRANS;
-        }
-    } else {
-        if (animation->keymap == NULL) {
-            // No holes
-            return (*colors)[ANIMATION_HSV_COLOR_BASE].special != ANIMATION_COLOR_TRANS;
-        } else {
-            return (*colors)[ANIMATION_HSV_COLOR_BASE].special != ANIMATION_COLOR_TRANS &&
-                   (*colors)[ANIMATION_HSV_COLOR_BASE_N].special != ANIMATION_COLOR_TRANS;
-        }
+    for (uint8_t k = 0; k < ctx->led_count; ++k) {
+        planes_set(&ctx->calc_state, ctx->leds[k], neutral);
     }
 }
 
 /**
- * @brief Convenience function to map8 when the start can be larger than the end
+ * @brief Combines the layer a blended animation drew with what was below it
  *
- * @param in Value to map
- * @param a One end of the range
- * @param b Other end of the range
- * @return uint8_t Mapped value
+ * @param ctx Context the animation runs in
+ * @param animation Animation that was applied
  */
-static inline uint8_t clean_map8(uint8_t in, uint8_t a, uint8_t b) {
-    if (a < b) {
-        return map8(in, a, b);
-    } else if (b < a) {
-        return map8(255 - in, b, a);
-    } else {
-        return a;
+static void layer_end(sgv_animation_ctx_t *ctx, const packed_animation_t *animation) {
+    color_planes_t *calc = &ctx->calc_state;
+
+    switch (animation->blend) {
+        case ANIMATION_BLEND_ADD:
+            for (uint8_t k = 0; k < ctx->led_count; ++k) {
+                uint8_t i = ctx->leds[k];
+                planes_set(calc, i, color_add(planes_get(&blend_below, i), planes_get(calc, i)));
+            }
+            break;
+        case ANIMATION_BLEND_MAX:
+            for (uint8_t k = 0; k < ctx->led_count; ++k) {
+                uint8_t i     = ctx->leds[k];
+                COLOR   below = planes_get(&blend_below, i);
+                COLOR   layer = planes_get(calc, i);
+                planes_set(calc, i, COLOR_VAL(layer) > COLOR_VAL(below) ? layer : below);
+            }
+            break;
+        case ANIMATION_BLEND_MULTIPLY:
+            for (uint8_t k = 0; k < ctx->led_count; ++k) {
+                uint8_t i     = ctx->leds[k];
+                COLOR   below = planes_get(&blend_below, i);
+                COLOR   layer = planes_get(calc, i);
+                planes_set(calc, i, color_with_val(below, scale8(COLOR_VAL(below), COLOR_VAL(layer))));
+            }
+            break;
+        case ANIMATION_BLEND_ALPHA:
+            for (uint8_t k = 0; k < ctx->led_count; ++k) {
+                uint8_t i = ctx->leds[k];
+                planes_set(calc, i, color_mix8(animation->alpha, planes_get(&blend_below, i), planes_get(calc, i)));
+            }
+            break;
+        default:
+            break;
     }
 }
 
-// TODO Make time pass through to all animations
-// TODO Make time speed-dependent in some way, so I don't need to worry about it
-// inside each animation
 // TODO Make algorithm faster by doing only the current batch of LEDs. Note that animations could
 // be added in the middle of a "frame", so that needs to be taken into account
 // TODO Remove SHIMMER and add CONTINUOUS type
@@ -410,14 +1712,16 @@ static inline uint8_t clean_map8(uint8_t in, uint8_t a, uint8_t b) {
 /**
  * @brief Calculates one frame for one animation
  *
+ * @param ctx Context the animation runs in
  * @param animation Animation to calculate for
  * @param first If this animation is the first in the queue
  * @param finish If this animation must reach its finished state
  * @return apply_res_e The result of running this frame of this animation
  */
-static apply_res_e apply_animation(animation_t *animation, bool first, bool finish) {
+static apply_res_e apply_animation(sgv_animation_ctx_t *ctx, packed_animation_t *animation, bool first,
+                                   bool finish) {
     /* Skip animations that start in the future */
-    if (!timer_expired32(timer_read32(), animation->ticks)) {
+    if (!timer_expired32(ctx->frame_clock.now, packed_ticks(ctx, animation))) {
         return APPLY_OK;
     }
 
@@ -425,150 +1729,151 @@ static apply_res_e apply_animation(animation_t *animation, bool first, bool fini
         finish = true;
     }
 
-    bool new_base = first || can_apply_new_base(animation);
-
-    switch (animation->type) {
-        case SOLID_KEY:
-            calc_state[animation->led_index] = animation_get_color(animation, animation->led_index);
-            if (new_base) {
-                base_state[animation->led_index] = animation_get_color(animation, animation->led_index);
-            }
-            return APPLY_CLEAR_THIS;
-        case SOLID_ALL:
-            for (uint8_t i = 0; i < LED_COUNT; ++i) {
-                COLOR new_c   = animation_get_color(animation, i);
-                calc_state[i] = new_c;
-                if (new_base) {
-                    base_state[i] = new_c;
-                }
-            }
-            return new_base ? APPLY_NEW_BASE : APPLY_OK;
-        case WAVE: {
-            // u32q16
-            const uint32_t wave_time_ms   = 400 << 16; // It takes 400 MS at most
-            const uint32_t u32q16_255_400 = 0xa333;    // 255 / 400 in u32q16
-
-            uint32_t active_for = timer_elapsed32(animation->ticks);
-            active_for          = scale16by8((uint16_t)active_for, get_matrix_speed()) << 16;
-
-            bool any_left = false;
-
-            // Guarantees safe passage + stoppage
-            if (active_for >= wave_time_ms || finish) {
-                active_for = wave_time_ms;
-            }
+    const animation_type_def_t *def = type_def(animation->type);
 
-            // u32q16
-            uint32_t radius = wave_time_ms - (wave_time_ms - active_for);
+    bool blended  = animation->blend != ANIMATION_BLEND_REPLACE;
+    bool new_base = first || (!blended && def->is_opaque(animation));
 
-            // Result of multiplication is u64q32
-            // but we bring it back to u32q16
-            // Cutting off 4 bytes at the top is ok since (400 << 16) * 0xA333 is only
-            // 0xfeffb00000
-            radius = ((uint64_t)radius * u32q16_255_400) >> 32;
+    color_source_t sources[ANIMATION_HSV_COLOR_COUNT];
+    def->resolve(ctx, animation, sources);
 
-            for (uint8_t i = 0; i < LED_COUNT; ++i) {
-                wave_info_t info = animation_wave_get_key_value(animation, i, radius);
-                COLOR       current_col;
-                COLOR       target_col;
+    if (!blended) {
+        return def->apply(ctx, animation, sources, first, new_base, finish);
+    }
 
-                if (info.in_wave || !info.inside_radius) {
-                    any_left = true;
-                }
+    layer_begin(ctx, animation, first);
+    apply_res_e res = def->apply(ctx, animation, sources, first, new_base, finish);
+    layer_end(ctx, animation);
 
-                if (!info.inside_radius) {
-                    current_col = calc_state[i];
-                    target_col  = animation_get_color_indexed(animation, i, ANIMATION_HSV_COLOR_BASE);
-                } else {
-                    current_col = animation_get_color_indexed(animation, i, ANIMATION_HSV_COLOR_BASE);
-                    target_col  = animation_get_color_indexed(animation, i, ANIMATION_HSV_COLOR_RESULT);
-                }
+    /* Blended animations that leave the queue leave their blended colors behind, not the layer they drew */
+    if (first && (res == APPLY_NEW_BASE || res == APPLY_CLEAR_THIS)) {
+        for (uint8_t k = 0; k < ctx->led_count; ++k) {
+            uint8_t i = ctx->leds[k];
+            planes_set(&ctx->base_state, i, planes_get(&ctx->calc_state, i));
+        }
+    }
 
-                bool current_off = hsv_is_off(current_col);
-                bool target_off  = hsv_is_off(target_col);
+    return res;
+}
 
-                if (current_off && !target_off) {
-                    current_col   = target_col;
-                    current_col.v = 0;
-                } else if (!current_off && target_off) {
-                    target_col   = current_col;
-                    target_col.v = 0;
-                }
+/**
+ * @brief Draws the overlays over everything the animations calculated, and forgets the ones that faded out. Only
+ *        looks at the LEDs that have one
+ *
+ * @param ctx Context to draw the overlays of
+ */
+static void overlay_apply(sgv_animation_ctx_t *ctx) {
+    uint32_t now = ctx->frame_clock.now;
 
-                calc_state[i].h = clean_map8(info.val, current_col.h, target_col.h);
-                calc_state[i].s = clean_map8(info.val, current_col.s, target_col.s);
-                calc_state[i].v = clean_map8(info.val, current_col.v, target_col.v);
+    for (uint8_t byte = 0; byte < MASK_BYTES; ++byte) {
+        for (uint8_t bits = ctx->overlay_leds[byte]; bits; bits &= bits - 1) {
+            uint8_t  led  = (byte << 3) | __builtin_ctz(bits);
+            COLOR    top  = ctx->overlay_colors[led];
+            uint16_t fade = ctx->overlay_fade_ms[led];
 
-                if (calc_state[i].v == 0) {
-                    calc_state[i].h = calc_state[i].s = 0;
-                }
+            if (fade == 0) {
+                planes_set(&ctx->calc_state, led, top);
+                continue;
             }
 
-            if (!any_left || active_for == wave_time_ms) {
-                animation->done          = true;
-                animation_color_t target = animation->hsv_colors[ANIMATION_HSV_COLOR_RESULT]; // Intended color
-                if (target.special == ANIMATION_COLOR_SHIMMER) {
-                    return BECOME_SHIMMER;
-                } else {
-                    for (uint8_t i = 0; i < LED_COUNT; ++i) {
-                        COLOR new_c   = animation_get_color_indexed(animation, i, ANIMATION_HSV_COLOR_RESULT);
-                        calc_state[i] = new_c;
-                        if (new_base) {
-                            base_state[i] = new_c;
-                        }
-                    }
-                    return new_base ? APPLY_NEW_BASE : APPLY_OK;
-                }
+            uint32_t start   = ctx->time_base + ctx->overlay_start[led];
+            uint32_t elapsed = timer_expired32(now, start) ? now - start : 0;
+            if (elapsed >= fade) {
+                ctx->overlay_leds[byte] &= ~(1 << (led & 7));
+                continue;
             }
 
-            return APPLY_OK;
+            uint8_t amount = (elapsed << 8) / fade;
+            planes_set(&ctx->calc_state, led, color_mix8(amount, top, planes_get(&ctx->calc_state, led)));
         }
-        case SHIMMER: {
-            uint32_t t = timer_read32() >> 5;
+    }
+}
+
+#if USING_RGB
+/**
+ * @brief Rebuilds the hue table if the matrix brightness changed since it was last built
+ *
+ * @param val Current matrix brightness
+ */
+static inline void hue_lut_update(uint8_t val) {
+    if (hue_lut_ready && hue_lut_val == val) {
+        return;
+    }
 
-            t = (t * (1 + ((uint64_t)get_matrix_speed()))) >> 8;
+    uint8_t v = scale8(0xFF, val);
+    for (uint16_t h = 0; h < 256; ++h) {
+        hue_lut[h] = hsv_to_rgb(MAKE_COLOR(h, 0xFF, v));
+    }
 
-            for (uint8_t i = 0; i < LED_COUNT; ++i) {
-                if (animation_led_in_keymap(animation, i)) {
-                    uint8_t x = g_led_config.point[i].x;
-                    uint8_t y = g_led_config.point[i].y;
+    hue_lut_val   = val;
+    hue_lut_ready = true;
+}
 
-                    uint8_t hue = get_perlin(x, y, t);
+/**
+ * @brief Converts a range of the calculated state to RGB at the given brightness, into `rgb_frame`. Colors
+ *        with full saturation and value are looked up in the hue table, everything else is converted normally
+ *
+ * @param calc_state Calculated state to convert
+ * @param from First LED to convert
+ * @param to One past the last LED to convert
+ * @param val Matrix brightness. `hue_lut_update` must have been called with the same brightness
+ */
+static inline void calc_state_to_rgb(const color_planes_t *calc_state, uint8_t from, uint8_t to, uint8_t val) {
+    uint8_t v[PLANE_SIZE];
+    plane_scale8(&v[from], &calc_state->v[from], val, to - from);
 
-                    calc_state[i] = MAKE_COLOR(.h = hue, .s = 0xFF, .v = 0xFF);
-                } else {
-                    calc_state[i] = animation->hsv_colors[ANIMATION_HSV_COLOR_BASE_N].color;
-                }
-            }
-            return (new_base && !first) ? BECOME_FIRST : APPLY_OK;
+    for (uint8_t i = from; i < to; ++i) {
+        if (!REFERENCE_KERNELS() && (calc_state->s[i] & calc_state->v[i]) == 0xFF) {
+            rgb_frame[i] = hue_lut[calc_state->h[i]];
+        } else {
+            rgb_frame[i] = hsv_to_rgb(MAKE_COLOR(calc_state->h[i], calc_state->s[i], v[i]));
         }
-        default:
-            return APPLY_OK;
     }
 }
+#endif
 
 /**
- * @brief Convenience function to actually turn the calculated state into LEDs
+ * @brief Convenience function to actually turn the calculated state into LEDs. Only the LEDs in the zone of the
+ *        context are written
  *
+ * @param ctx Context to draw
  * @param params Effect parameters
  * @return true If the last of the LEDs has been run through
  * @return false Otherwise
  */
-static inline bool apply_calc_state(effect_params_t *params) {
+static inline bool apply_calc_state(sgv_animation_ctx_t *ctx, effect_params_t *params) {
+    PERF_BEGIN(start);
     MATRIX_USE_LIMITS(led_min, led_max);
 
-    for (uint8_t i = led_min; i < led_max; ++i) {
-        MATRIX_TEST_LED_FLAGS();
+    uint8_t val = get_matrix_val();
 
-        COLOR color = calc_state[i];
-        color.v     = scale8(color.v, get_matrix_val());
 #if USING_RGB
-        RGB color_rgb = hsv_to_rgb(color);
-        rgb_matrix_set_color(i, color_rgb.r, color_rgb.g, color_rgb.b);
+    /* Convert the whole batch first, then write it out in one go */
+    hue_lut_update(val);
+    calc_state_to_rgb(&ctx->calc_state, led_min, led_max, val);
+
+    for (uint8_t i = led_min; i < led_max; ++i) {
+        MATRIX_TEST_LED_FLAGS();
+        if (!ctx->in_zone[i]) {
+            continue;
+        }
+        rgb_matrix_set_color(i, rgb_frame[i].r, rgb_frame[i].g, rgb_frame[i].b);
+    }
 #else
-        led_matrix_set_value(i, color.v);
-#endif
+    /* Brightness for the whole batch at once */
+    uint8_t v[PLANE_SIZE];
+    plane_scale8(&v[led_min], &ctx->calc_state.v[led_min], val, led_max - led_min);
+
+    for (uint8_t i = led_min; i < led_max; ++i) {
+        MATRIX_TEST_LED_FLAGS();
+        if (!ctx->in_zone[i]) {
+            continue;
+        }
+        led_matrix_set_value(i, v[i]);
     }
+#endif
+
+    PERF_END(PERF_CALC_STATE, start);
 
     return matrix_check_finished_leds(led_max);
 }
@@ -577,7 +1882,7 @@ static inline animation_color_t animation_color_internal(COLOR c) {
 #if USING_RGB
     return animation_color_hsv(c.h, c.s, c.v);
 #else
-    return animation_color_val(c.v);
+    return animation_color_val(c);
 #endif
 }
 
@@ -592,7 +1897,7 @@ animation_color_t animation_color_val(uint8_t val) {
 
 animation_color_t animation_color_hsv(uint8_t h, uint8_t s, uint8_t v) {
     return (animation_color_t){
-        .color   = MAKE_COLOR(.h = h, .s = s, .v = v),
+        .color   = MAKE_COLOR(h, s, v),
         .special = ANIMATION_COLOR_NONE,
     };
 }
@@ -621,6 +1926,11 @@ animation_t animation_clear(void) {
                 animation_color_special(ANIMATION_COLOR_TRANS),
                 animation_color_special(ANIMATION_COLOR_TRANS),
             },
+
+        .blend = ANIMATION_BLEND_REPLACE,
+        .alpha = 0xFF,
+
+        .priority = ANIMATION_PRIORITY_COSMETIC,
     };
 }
 
@@ -641,6 +1951,11 @@ animation_t animation_clear_key(uint8_t led_index) {
                 animation_color_special(ANIMATION_COLOR_TRANS),
                 animation_color_special(ANIMATION_COLOR_TRANS),
             },
+
+        .blend = ANIMATION_BLEND_REPLACE,
+        .alpha = 0xFF,
+
+        .priority = ANIMATION_PRIORITY_COSMETIC,
     };
 }
 
@@ -661,6 +1976,11 @@ animation_t animation_solid(uint8_t h, uint8_t s, uint8_t v) {
                 animation_color_special(ANIMATION_COLOR_TRANS),
                 animation_color_special(ANIMATION_COLOR_TRANS),
             },
+
+        .blend = ANIMATION_BLEND_REPLACE,
+        .alpha = 0xFF,
+
+        .priority = ANIMATION_PRIORITY_COSMETIC,
     };
 }
 
@@ -681,6 +2001,11 @@ animation_t animation_solid_key(uint8_t led_index, uint8_t h, uint8_t s, uint8_t
                 animation_color_special(ANIMATION_COLOR_TRANS),
                 animation_color_special(ANIMATION_COLOR_TRANS),
             },
+
+        .blend = ANIMATION_BLEND_REPLACE,
+        .alpha = 0xFF,
+
+        .priority = ANIMATION_PRIORITY_COSMETIC,
     };
 }
 
@@ -701,6 +2026,11 @@ animation_t animation_wave(uint8_t start_led_index, animation_color_t wave_color
                 animation_color_special(ANIMATION_COLOR_TRANS),
                 animation_color_special(ANIMATION_COLOR_TRANS),
             },
+
+        .blend = ANIMATION_BLEND_REPLACE,
+        .alpha = 0xFF,
+
+        .priority = ANIMATION_PRIORITY_COSMETIC,
     };
 }
 
@@ -721,6 +2051,11 @@ animation_t animation_wave_solid(uint8_t start_led_index, animation_color_t wave
                 animation_color_special(ANIMATION_COLOR_TRANS),
                 animation_color_special(ANIMATION_COLOR_TRANS),
             },
+
+        .blend = ANIMATION_BLEND_REPLACE,
+        .alpha = 0xFF,
+
+        .priority = ANIMATION_PRIORITY_COSMETIC,
     };
 }
 
@@ -742,34 +2077,104 @@ animation_t animation_wave_solid_2(uint8_t start_led_index, animation_color_t wa
                 animation_color_special(ANIMATION_COLOR_TRANS),
                 animation_color_special(ANIMATION_COLOR_TRANS),
             },
+
+        .blend = ANIMATION_BLEND_REPLACE,
+        .alpha = 0xFF,
+
+        .priority = ANIMATION_PRIORITY_COSMETIC,
+    };
+}
+
+animation_t animation_ripple(uint8_t start_led_index, animation_color_t wave_color) {
+    animation_t animation = animation_wave(start_led_index, wave_color);
+    animation.type        = RIPPLE;
+    return animation;
+}
+
+animation_t animation_shimmer(void) {
+    return (animation_t){
+        .type = SHIMMER,
+
+        .led_index = 0,
+        .done      = false,
+        .ticks     = timer_read32(),
+
+        .keymap = NULL,
+
+        .hsv_colors =
+            {
+                animation_color_special(ANIMATION_COLOR_SHIMMER),
+                animation_color_special(ANIMATION_COLOR_TRANS),
+                animation_color_special(ANIMATION_COLOR_TRANS),
+                animation_color_special(ANIMATION_COLOR_TRANS),
+            },
+
+        .blend = ANIMATION_BLEND_REPLACE,
+        .alpha = 0xFF,
+
+        .priority = ANIMATION_PRIORITY_AMBIENT,
     };
 }
 
-animation_t animation_shimmer(void) {
-    return (animation_t){
-        .type = SHIMMER,
+bool sgv_animation_ctx_new(void *location, size_t location_size, const uint8_t *leds, uint8_t led_count) {
+    if (location == NULL || location_size != sizeof(sgv_animation_ctx_t)) {
+        return false;
+    }
+
+    if (leds != NULL && (led_count == 0 || led_count > LED_COUNT)) {
+        return false;
+    }
+
+    for (uint8_t k = 0; leds != NULL && k < led_count; ++k) {
+        if (leds[k] >= LED_COUNT) {
+            return false;
+        }
+    }
+
+    sgv_animation_ctx_t *ctx = location;
+    memset(ctx, 0, sizeof *ctx);
+
+    for (uint8_t slot = 0; slot < CIRCULAR_BUFFER_ELEMS; ++slot) {
+        ctx->generation[slot]              = 1;
+        ctx->free_slots[ctx->free_count++] = CIRCULAR_BUFFER_ELEMS - 1 - slot;
+    }
+    ctx->random_slot = CIRCULAR_BUFFER_ELEMS;
+
+    ctx->animations = (circular_buffer_t *)&ctx->queue_handle;
+    if (!circular_buffer_new(ctx->animations, circular_buffer_type_size, &ctx->queue_mem, CIRCULAR_BUFFER_BYTE_SIZE,
+                             CIRCULAR_BUFFER_ELEMS, CIRCULAR_BUFFER_ELEM_SIZE)) {
+        return false;
+    }
+
+    for (uint8_t k = 0; k < (leds != NULL ? led_count : LED_COUNT); ++k) {
+        uint8_t led = leds != NULL ? leds[k] : k;
+        if (ctx->in_zone[led]) {
+            continue;
+        }
+
+        ctx->in_zone[led]           = true;
+        ctx->leds[ctx->led_count++] = led;
+    }
 
-        .led_index = 0,
-        .done      = false,
-        .ticks     = timer_read32(),
+    frame_clock_sample(&ctx->frame_clock);
+    ctx->time_base = ctx->frame_clock.now;
 
-        .keymap = NULL,
+    return true;
+}
 
-        .hsv_colors =
-            {
-                animation_color_special(ANIMATION_COLOR_SHIMMER),
-                animation_color_special(ANIMATION_COLOR_TRANS),
-                animation_color_special(ANIMATION_COLOR_TRANS),
-                animation_color_special(ANIMATION_COLOR_TRANS),
-            },
-    };
+sgv_animation_ctx_t *sgv_animation_default_ctx(void) {
+    return &default_ctx;
 }
 
 void sgv_animation_preinit(void) {
-    // Free not needed
-    animations = malloc(circular_buffer_type_size);
-    circular_buffer_new(animations, circular_buffer_type_size, &circular_buffer_mem, CIRCULAR_BUFFER_BYTE_SIZE,
-                        CIRCULAR_BUFFER_ELEMS, CIRCULAR_BUFFER_ELEM_SIZE);
+    sgv_animation_ctx_new(&default_ctx, sizeof default_ctx, NULL, 0);
+
+#if SGV_TRACE
+    trace_init();
+#endif
+#if SGV_PERF
+    perf_init();
+#endif
 
     for (uint8_t r = 0; r < MATRIX_ROWS; ++r) {
         for (uint8_t c = 0; c < MATRIX_COLS; ++c) {
@@ -782,38 +2187,72 @@ void sgv_animation_preinit(void) {
     }
 }
 
-void sgv_animation_init(void) {
-    animation_t scrap;
-    while (!empty()) {
-        pop(&scrap);
-    }
+void sgv_animation_ctx_init(sgv_animation_ctx_t *ctx) {
+    sgv_animation_ctx_reset(ctx);
+    sample_clock(ctx);
+}
 
-    clear_all_state();
+void sgv_animation_init(void) {
+    sgv_animation_ctx_init(&default_ctx);
 
     // L, L, L
     sgv_animation_add_startup_animation(70, 70, 70);
 }
 
-bool sgv_animation_update(effect_params_t *params) {
-    animation_t  scrap;
-    animation_t *current;
+bool sgv_animation_ctx_update(sgv_animation_ctx_t *ctx, effect_params_t *params) {
+    packed_animation_t *current;
+    uint8_t            *slot;
 
     uint8_t it    = 0;
-    uint8_t limit = length();
+    uint8_t limit = length(ctx);
+
+    /* All the batches of a frame share the time of the first one */
+    if (params->iter == 0) {
+        sample_clock(ctx);
+    }
 
     if (!get_matrix_enabled()) {
         MATRIX_USE_LIMITS(led_min, led_max);
         return matrix_check_finished_leds(led_max);
     }
 
-    clear_calc_state();
+    PERF_BEGIN(update_start);
+    PERF_QUEUE(limit);
+    TRACE(TRACE_FRAME_BEGIN, params->iter, limit);
+
+    clear_calc_state(ctx);
 
     while (it < limit) {
-        if ((current = at(it)) == NULL) {
+        if ((slot = slot_at(ctx, it)) == NULL) {
+            goto next;
+        }
+
+        /* Cancelled animations are only removed once they reach the front */
+        if (ctx->cancelled[*slot]) {
+            if (it == 0) {
+                drop_first(ctx);
+                --it;
+                --limit;
+            }
             goto next;
         }
 
-        apply_res_e res = apply_animation(current, it == 0, false);
+        current = &ctx->pool[*slot];
+
+        animation_type_e type = current->type;
+
+        TRACE_TIME(apply_start);
+        PERF_BEGIN(apply_perf_start);
+        HOOK_BEGIN(type);
+        apply_res_e res = apply_animation(ctx, current, it == 0, false);
+        HOOK_END(type);
+        PERF_END(type < ANIMATION_TYPE_COUNT ? PERF_APPLY_FIRST + type : PERF_APPLY_REGISTERED, apply_perf_start);
+        TRACE_SINCE(apply_start, TRACE_APPLY, type);
+
+        if (res != APPLY_OK && res != APPLY_CLEAR_THIS) {
+            /* Everything before this animation is dropped, and with APPLY_NEW_BASE this animation too */
+            TRACE(TRACE_PRUNE, res, it + (res == APPLY_NEW_BASE));
+        }
 
         switch (res) {
             case APPLY_OK:
@@ -822,7 +2261,7 @@ bool sgv_animation_update(effect_params_t *params) {
                 [[fallthrough]];
             case APPLY_NEW_BASE:
                 while (it != 0) {
-                    shift(&scrap);
+                    drop_first(ctx);
                     --it;
                     --limit;
                 }
@@ -833,25 +2272,18 @@ bool sgv_animation_update(effect_params_t *params) {
                 [[fallthrough]];
             case APPLY_CLEAR_THIS:
                 if (it == 0) {
-                    shift(&scrap);
+                    drop_first(ctx);
                     --it; // This _could_ underflow but it'll be fixed before next loop
                     --limit;
                 }
                 break;
-            case BECOME_SHIMMER:
+            case BECOME_NEXT:
                 while (it != 0) {
-                    shift(&scrap);
+                    drop_first(ctx);
                     --it;
                     --limit;
                 }
-                shift(&scrap);
-                scrap.done                                   = false;
-                scrap.type                                   = SHIMMER;
-                scrap.hsv_colors[ANIMATION_HSV_COLOR_BASE]   = scrap.hsv_colors[ANIMATION_HSV_COLOR_RESULT];
-                scrap.hsv_colors[ANIMATION_HSV_COLOR_BASE_N] = scrap.hsv_colors[ANIMATION_HSV_COLOR_RESULT_N];
-                scrap.hsv_colors[ANIMATION_HSV_COLOR_RESULT] = scrap.hsv_colors[ANIMATION_HSV_COLOR_RESULT_N] =
-                    animation_color_internal(MAKE_COLOR(COLOR_OFF));
-                unshift(scrap);
+                type_def(type)->finish(ctx, current);
                 break;
         }
         /* `it` could be in an undefined bad state here */
@@ -861,19 +2293,322 @@ bool sgv_animation_update(effect_params_t *params) {
         ++it;
     }
 
-    return apply_calc_state(params);
+    overlay_apply(ctx);
+
+    bool more = apply_calc_state(ctx, params);
+
+    TRACE(TRACE_FRAME_END, params->iter, length(ctx));
+    PERF_END(PERF_UPDATE, update_start);
+
+    return more;
+}
+
+bool sgv_animation_update(effect_params_t *params) {
+    return sgv_animation_ctx_update(&default_ctx, params);
+}
+
+bool sgv_animation_ctx_redraw(sgv_animation_ctx_t *ctx, effect_params_t *params) {
+    if (!get_matrix_enabled()) {
+        MATRIX_USE_LIMITS(led_min, led_max);
+        return matrix_check_finished_leds(led_max);
+    }
+
+    return apply_calc_state(ctx, params);
+}
+
+/**
+ * @brief Drops the oldest animation to make room for a new one. It reaches its finished state first
+ *
+ * @param ctx Context to drop from
+ */
+static void evict(sgv_animation_ctx_t *ctx) {
+    uint8_t slot = *slot_at(ctx, 0);
+    if (!ctx->cancelled[slot]) {
+        TRACE(TRACE_EVICT, ctx->pool[slot].type, ctx->priority[slot]);
+        PERF_PRESSURE(PERF_EVICTED, ctx->priority[slot]);
+        apply_animation(ctx, &ctx->pool[slot], true, true);
+    }
+
+    drop_first(ctx);
 }
 
-void sgv_animation_add_animation(animation_t animation) {
-    if (full()) {
-        animation_t scrap;
-        if (shift(&scrap)) {
-            apply_animation(&scrap, true, true);
+/**
+ * @brief Removes one animation to make room for a new one. Cancelled animations go first, then the oldest of the
+ *        least important ones. The first animation of the queue is finished before it goes, so what it leaves behind
+ *        stays. Any other one is dropped as is, which is cheaper
+ *
+ * @param ctx Context to make room in
+ * @param priority Priority of the new animation
+ * @return true If an animation was removed
+ * @return false If every queued animation is more important than the new one
+ */
+static bool make_room(sgv_animation_ctx_t *ctx, animation_priority_e priority) {
+    uint8_t victim = 0;
+    for (uint8_t i = 0; i < length(ctx); ++i) {
+        uint8_t slot = *slot_at(ctx, i);
+        if (ctx->cancelled[slot]) {
+            drop_at(ctx, i);
+            return true;
+        }
+
+        if (ctx->priority[slot] < ctx->priority[*slot_at(ctx, victim)]) {
+            victim = i;
         }
     }
 
-    push(animation);
-};
+    uint8_t slot = *slot_at(ctx, victim);
+    if (ctx->priority[slot] > priority) {
+        return false;
+    }
+
+    if (victim == 0) {
+        evict(ctx);
+    } else {
+        TRACE(TRACE_DROP, ctx->pool[slot].type, ctx->priority[slot]);
+        PERF_PRESSURE(PERF_DROPPED, ctx->priority[slot]);
+        drop_at(ctx, victim);
+    }
+
+    return true;
+}
+
+/**
+ * @brief Drops every cancelled animation still in the queue. They are never applied again, but keep their color,
+ *        keymap and ripple table entries until they reach the front
+ *
+ * @param ctx Context to drop from
+ * @return true If any animation was dropped
+ * @return false Otherwise
+ */
+static bool drop_cancelled(sgv_animation_ctx_t *ctx) {
+    bool dropped = false;
+
+    /* Dropping keeps the animations in front of `i` where they are, and moves the ones behind it forward one place.
+       The next animation to look at is then at `i` already */
+    for (uint8_t i = 0; i < length(ctx);) {
+        if (ctx->cancelled[*slot_at(ctx, i)]) {
+            drop_at(ctx, i);
+            dropped = true;
+        } else {
+            ++i;
+        }
+    }
+
+    return dropped;
+}
+
+/**
+ * @brief Adds a ripple to the newest animation of the queue as one more origin, if that is a ripple it can join.
+ *        Older ripples are left alone, or the new wave would end up under the animations added after them
+ *
+ * @param ctx Context to add to
+ * @param animation Ripple to add
+ * @return animation_handle_t Handle to the ripple that took the origin, or ANIMATION_HANDLE_NONE if the new ripple
+ *         needs a place in the queue of its own
+ */
+static animation_handle_t ripple_absorb(sgv_animation_ctx_t *ctx, const animation_t *animation) {
+    uint8_t i = length(ctx);
+    while (i > 0 && ctx->cancelled[*slot_at(ctx, i - 1)]) {
+        --i;
+    }
+    if (i == 0 || animation->done) {
+        return ANIMATION_HANDLE_NONE;
+    }
+
+    uint8_t             slot   = *slot_at(ctx, i - 1);
+    packed_animation_t *packed = &ctx->pool[slot];
+    if (packed->type != RIPPLE || packed->done || packed->blend != animation->blend ||
+        packed->alpha != animation->alpha || ctx->priority[slot] != animation->priority) {
+        return ANIMATION_HANDLE_NONE;
+    }
+
+    if ((packed->mask == NO_MASK ? NULL : ctx->mask_table[packed->mask]) != animation->keymap) {
+        return ANIMATION_HANDLE_NONE;
+    }
+
+    /* Every wave has its own base color, the rest are shared */
+    for (uint8_t c = 0; c < ANIMATION_HSV_COLOR_COUNT; ++c) {
+        animation_color_t color = animation->hsv_colors[c];
+        if (color.special != packed_special(packed, c)) {
+            return ANIMATION_HANDLE_NONE;
+        }
+        if (c != ANIMATION_HSV_COLOR_BASE && color.special == ANIMATION_COLOR_NONE &&
+            memcmp(&color.color, &ctx->color_table[packed->colors[c]], sizeof color.color) != 0) {
+            return ANIMATION_HANDLE_NONE;
+        }
+    }
+
+    ripple_origins_t *ripple = &ctx->ripples[packed->led_index];
+    uint32_t          delay  = animation->ticks - packed_ticks(ctx, packed);
+    if (ripple->count == ANIMATION_RIPPLE_ORIGINS || (int32_t)delay < 0 || delay > UINT16_MAX) {
+        return ANIMATION_HANDLE_NONE;
+    }
+
+    animation_color_t base  = animation->hsv_colors[ANIMATION_HSV_COLOR_BASE];
+    uint8_t           entry = base.special == ANIMATION_COLOR_NONE ? color_acquire(ctx, base.color) : COLOR_TABLE_OFF;
+    if (entry == COLOR_TABLE_SIZE) {
+        return ANIMATION_HANDLE_NONE;
+    }
+
+    ripple->delays[ripple->count] = delay;
+    ripple->leds[ripple->count]   = animation->led_index;
+    ripple->colors[ripple->count] = entry;
+    ripple->count++;
+
+    TRACE(TRACE_ABSORB, RIPPLE, ripple->count);
+
+    return MAKE_HANDLE(slot, ctx->generation[slot]);
+}
+
+animation_handle_t sgv_animation_ctx_add_animation(sgv_animation_ctx_t *ctx, animation_t animation) {
+    packed_animation_t packed;
+
+    if (animation.type == RIPPLE) {
+        animation_handle_t handle = ripple_absorb(ctx, &animation);
+        if (handle != ANIMATION_HANDLE_NONE) {
+            return handle;
+        }
+    }
+
+    if (animation.type >= type_count || starts_too_late(ctx, animation.ticks)) {
+        TRACE(TRACE_REJECT, animation.type, animation.priority);
+        PERF_PRESSURE(PERF_REJECTED, animation.priority);
+        return ANIMATION_HANDLE_NONE;
+    }
+
+    /* Make room in the queue */
+    while (full(ctx)) {
+        if (!make_room(ctx, animation.priority)) {
+            TRACE(TRACE_REJECT, animation.type, animation.priority);
+            PERF_PRESSURE(PERF_REJECTED, animation.priority);
+            return ANIMATION_HANDLE_NONE;
+        }
+    }
+
+    /* A full color, keymap or ripple table isn't a full queue. Only cancelled animations give their entries back
+       for free, evicting live ones could go through the whole queue before one frees the entry that's needed */
+    if (!pack(ctx, &packed, &animation) && !(drop_cancelled(ctx) && pack(ctx, &packed, &animation))) {
+        TRACE(TRACE_REJECT, animation.type, animation.priority);
+        PERF_PRESSURE(PERF_REJECTED, animation.priority);
+        return ANIMATION_HANDLE_NONE;
+    }
+
+    animation_handle_t handle = push(ctx, &packed, animation.priority);
+
+    TRACE(TRACE_PUSH, animation.type, length(ctx));
+
+    return handle;
+}
+
+animation_handle_t sgv_animation_add_animation(animation_t animation) {
+    return sgv_animation_ctx_add_animation(&default_ctx, animation);
+}
+
+bool sgv_animation_ctx_cancel(sgv_animation_ctx_t *ctx, animation_handle_t handle) {
+    packed_animation_t *animation = handle_get(ctx, handle);
+    if (animation == NULL) {
+        return false;
+    }
+
+    /* The slot stays queued until it reaches the front, but the handle stops working right away */
+    uint8_t slot         = HANDLE_SLOT(handle);
+    ctx->cancelled[slot] = true;
+    next_generation(ctx, slot);
+
+    TRACE(TRACE_CANCEL, animation->type, length(ctx));
+
+    return true;
+}
+
+bool sgv_animation_cancel(animation_handle_t handle) {
+    return sgv_animation_ctx_cancel(&default_ctx, handle);
+}
+
+bool sgv_animation_ctx_retime(sgv_animation_ctx_t *ctx, animation_handle_t handle, uint32_t ticks) {
+    packed_animation_t *animation = handle_get(ctx, handle);
+    if (animation == NULL || starts_too_late(ctx, ticks)) {
+        return false;
+    }
+
+    bool long_ago;
+    animation->start = relative_start(ctx, ticks, &long_ago);
+    animation->done  = long_ago;
+
+    return true;
+}
+
+bool sgv_animation_retime(animation_handle_t handle, uint32_t ticks) {
+    return sgv_animation_ctx_retime(&default_ctx, handle, ticks);
+}
+
+bool sgv_animation_ctx_recolor(sgv_animation_ctx_t *ctx, animation_handle_t handle, uint8_t index,
+                               animation_color_t color) {
+    packed_animation_t *animation = handle_get(ctx, handle);
+    if (animation == NULL || index >= ANIMATION_HSV_COLOR_COUNT) {
+        return false;
+    }
+
+    uint8_t entry = color.special == ANIMATION_COLOR_NONE ? color_acquire(ctx, color.color) : COLOR_TABLE_OFF;
+    if (entry == COLOR_TABLE_SIZE) {
+        return false;
+    }
+
+    /* Animations that already had random colors keep them */
+    if (color.special == ANIMATION_COLOR_RANDOM && !packed_has_random(animation)) {
+        uint8_t slot            = HANDLE_SLOT(handle);
+        ctx->random_seeds[slot] = random16();
+        ctx->random_slot        = ctx->random_slot == slot ? CIRCULAR_BUFFER_ELEMS : ctx->random_slot;
+    }
+
+    color_release(ctx, animation->colors[index]);
+    animation->colors[index] = entry;
+    packed_set_special(animation, index, color.special);
+
+    return true;
+}
+
+bool sgv_animation_recolor(animation_handle_t handle, uint8_t index, animation_color_t color) {
+    return sgv_animation_ctx_recolor(&default_ctx, handle, index, color);
+}
+
+bool sgv_animation_ctx_overlay_set(sgv_animation_ctx_t *ctx, uint8_t led, animation_color_t color, uint16_t fade_ms) {
+    if (led >= LED_COUNT || !ctx->in_zone[led] || color.special != ANIMATION_COLOR_NONE || fade_ms > INT16_MAX) {
+        return false;
+    }
+
+    bool long_ago;
+    ctx->overlay_colors[led]  = color.color;
+    ctx->overlay_start[led]   = relative_start(ctx, frame_clock_read(), &long_ago);
+    ctx->overlay_fade_ms[led] = fade_ms;
+    ctx->overlay_leds[led >> 3] |= 1 << (led & 7);
+
+    return true;
+}
+
+bool sgv_animation_overlay_set(uint8_t led, animation_color_t color, uint16_t fade_ms) {
+    return sgv_animation_ctx_overlay_set(&default_ctx, led, color, fade_ms);
+}
+
+bool sgv_animation_ctx_overlay_clear(sgv_animation_ctx_t *ctx, uint8_t led) {
+    if (led >= LED_COUNT || !(ctx->overlay_leds[led >> 3] & (1 << (led & 7)))) {
+        return false;
+    }
+
+    ctx->overlay_leds[led >> 3] &= ~(1 << (led & 7));
+    return true;
+}
+
+bool sgv_animation_overlay_clear(uint8_t led) {
+    return sgv_animation_ctx_overlay_clear(&default_ctx, led);
+}
+
+void sgv_animation_ctx_overlay_clear_all(sgv_animation_ctx_t *ctx) {
+    memset(ctx->overlay_leds, 0, sizeof ctx->overlay_leds);
+}
+
+void sgv_animation_overlay_clear_all(void) {
+    sgv_animation_ctx_overlay_clear_all(&default_ctx);
+}
 
 static const uint16_t startup_animation_keys[][MATRIX_ROWS][MATRIX_COLS] = {
 #if USING_RGB // TODO This is incorrect, and should instead use keyboard layout
@@ -949,11 +2684,220 @@ void sgv_animation_add_startup_animation(uint8_t first_wave_start_led, uint8_t s
     sgv_animation_add_animation(anim);
 }
 
+void sgv_animation_ctx_reset(sgv_animation_ctx_t *ctx) {
+    while (!empty(ctx)) {
+        drop_first(ctx);
+    }
+
+    sgv_animation_ctx_overlay_clear_all(ctx);
+    clear_all_state(ctx);
+
+    /* Start times are checked against the time base, which would otherwise stay wherever the old animations left it */
+    frame_clock_sample(&ctx->frame_clock);
+    ctx->time_base = ctx->frame_clock.now;
+}
+
 void sgv_animation_reset(void) {
-    animation_t scrap;
-    while (!empty()) {
-        pop(&scrap);
+    sgv_animation_ctx_reset(&default_ctx);
+}
+
+void sgv_animation_set_clock(animation_clock_fn clock) {
+    frame_clock_source = clock;
+    sample_clock(&default_ctx);
+}
+
+#if ANIMATION_HOOKS
+void sgv_animation_set_reference_kernels(bool reference) {
+    reference_kernels = reference;
+}
+
+const char *sgv_animation_ctx_check(sgv_animation_ctx_t *ctx) {
+    if (ctx->animations == NULL) {
+        return "queue was never created";
+    }
+
+    uint8_t count = length(ctx);
+    if (count > CIRCULAR_BUFFER_ELEMS) {
+        return "queue is longer than its capacity";
+    }
+
+    if (count + ctx->free_count != CIRCULAR_BUFFER_ELEMS) {
+        return "pool slots leaked";
+    }
+
+    /* Free slots get another seed when they are used again, so the random field cannot be theirs */
+    for (uint8_t i = 0; i < ctx->free_count; ++i) {
+        if (ctx->free_slots[i] == ctx->random_slot) {
+            return "random field belongs to a free slot";
+        }
+    }
+
+    bool    queued[CIRCULAR_BUFFER_ELEMS]  = {0};
+    uint8_t color_refs[COLOR_TABLE_SIZE]   = {0};
+    uint8_t mask_refs[MASK_TABLE_SIZE]     = {0};
+    uint8_t ripple_refs[RIPPLE_TABLE_SIZE] = {0};
+    for (uint8_t i = 0; i < count; ++i) {
+        uint8_t *slot = slot_at(ctx, i);
+        if (slot == NULL) {
+            return "queue entry is missing";
+        }
+
+        if (*slot >= CIRCULAR_BUFFER_ELEMS || queued[*slot]) {
+            return "queue entry is not a pool slot of its own";
+        }
+        queued[*slot] = true;
+
+        packed_animation_t *animation = &ctx->pool[*slot];
+
+        /* Cancelled animations keep their table entries until they leave the queue */
+        for (uint8_t c = 0; c < ANIMATION_HSV_COLOR_COUNT; ++c) {
+            if (animation->colors[c] >= COLOR_TABLE_SIZE) {
+                return "queued animation has a color that is not in the table";
+            }
+            color_refs[animation->colors[c]]++;
+        }
+
+        if (animation->mask != NO_MASK) {
+            if (animation->mask >= MASK_TABLE_SIZE) {
+                return "queued animation has a mask that is not in the table";
+            }
+            mask_refs[animation->mask]++;
+        }
+
+        if (animation->type == RIPPLE) {
+            if (animation->led_index >= RIPPLE_TABLE_SIZE) {
+                return "queued ripple has origins that are not in the table";
+            }
+            ripple_refs[animation->led_index]++;
+
+            ripple_origins_t *ripple = &ctx->ripples[animation->led_index];
+            for (uint8_t o = 1; o < ripple->count && o < ANIMATION_RIPPLE_ORIGINS; ++o) {
+                if (ripple->colors[o] >= COLOR_TABLE_SIZE) {
+                    return "ripple origin has a color that is not in the table";
+                }
+                color_refs[ripple->colors[o]]++;
+            }
+        }
+
+        /* Cancelled animations are never applied again, anything else goes */
+        if (ctx->cancelled[*slot]) {
+            continue;
+        }
+
+        if (animation->type >= type_count) {
+            return "queued animation has an unknown type";
+        }
+
+        if (animation->blend >= ANIMATION_BLEND_COUNT) {
+            return "queued animation has an unknown blend mode";
+        }
+
+        if (ctx->priority[*slot] >= ANIMATION_PRIORITY_COUNT) {
+            return "queued animation has an unknown priority";
+        }
+
+        if (animation->type != RIPPLE && animation->led_index >= LED_COUNT) {
+            return "queued animation is on an LED that does not exist";
+        }
+
+        if (animation->type == RIPPLE) {
+            ripple_origins_t *ripple = &ctx->ripples[animation->led_index];
+            if (ripple->count == 0 || ripple->count > ANIMATION_RIPPLE_ORIGINS) {
+                return "queued ripple has a wrong amount of origins";
+            }
+
+            for (uint8_t o = 0; o < ripple->count; ++o) {
+                if (ripple->leds[o] >= LED_COUNT) {
+                    return "ripple origin is on an LED that does not exist";
+                }
+            }
+
+            if (ripple->delays[0] != 0) {
+                return "first ripple origin does not start with the ripple";
+            }
+        }
+
+        for (uint8_t c = 0; c < ANIMATION_HSV_COLOR_COUNT; ++c) {
+            if (packed_special(animation, c) > ANIMATION_COLOR_SHIMMER) {
+                return "queued animation has an unknown special color";
+            }
+        }
+
+        /* Every frame applies every wave, so one that has been active for its whole length must be done by now */
+        frame_clock_t *clock = &ctx->frame_clock;
+        uint32_t       ticks = packed_ticks(ctx, animation);
+        if (animation->type == WAVE && !animation->done && timer_expired32(clock->now, ticks)) {
+            uint64_t active_ms = ((uint64_t)(clock->now - ticks) * (1 + clock->speed)) >> 8;
+            if (active_ms >= WAVE_TIME_MS) {
+                return "wave did not finish";
+            }
+        }
+
+        /* Same for ripples, once their last wave has been active for its whole length */
+        if (animation->type == RIPPLE && !animation->done) {
+            ripple_origins_t *ripple = &ctx->ripples[animation->led_index];
+            bool              over   = true;
+            for (uint8_t o = 0; o < ripple->count; ++o) {
+                uint32_t start = ticks + ripple->delays[o];
+                over = over && timer_expired32(clock->now, start) &&
+                       (((uint64_t)(clock->now - start) * (1 + clock->speed)) >> 8) >= WAVE_TIME_MS;
+            }
+            if (over) {
+                return "ripple did not finish";
+            }
+        }
+    }
+
+    for (uint8_t slot = 0; slot < CIRCULAR_BUFFER_ELEMS; ++slot) {
+        if (ctx->cancelled[slot] && !queued[slot]) {
+            return "free pool slot is marked as cancelled";
+        }
+    }
+
+    for (uint8_t entry = COLOR_TABLE_OFF + 1; entry < COLOR_TABLE_SIZE; ++entry) {
+        if (color_refs[entry] != ctx->color_refs[entry]) {
+            return "color table reference count is wrong";
+        }
+    }
+
+    for (uint8_t entry = 0; entry < MASK_TABLE_SIZE; ++entry) {
+        if (mask_refs[entry] != ctx->mask_refs[entry]) {
+            return "mask table reference count is wrong";
+        }
     }
 
-    clear_all_state();
+    for (uint8_t entry = 0; entry < RIPPLE_TABLE_SIZE; ++entry) {
+        if (ripple_refs[entry] != (ctx->ripples[entry].count != 0)) {
+            return "ripple table entry is not used by exactly one queued ripple";
+        }
+    }
+
+    for (uint8_t led = 0; led < LED_COUNT; ++led) {
+        if (!(ctx->overlay_leds[led >> 3] & (1 << (led & 7)))) {
+            continue;
+        }
+
+        if (!ctx->in_zone[led]) {
+            return "overlay is on an LED outside the zone";
+        }
+
+        if (ctx->overlay_fade_ms[led] > INT16_MAX) {
+            return "overlay fades for longer than its start time can reach back";
+        }
+    }
+
+#    if USING_RGB
+    for (uint8_t i = 0; i < PLANE_SIZE; ++i) {
+        if (ctx->calc_state.v[i] == 0 && (ctx->calc_state.h[i] | ctx->calc_state.s[i])) {
+            return "LED that is off kept its hue or saturation";
+        }
+    }
+#    endif
+
+    return NULL;
+}
+
+const char *sgv_animation_check(void) {
+    return sgv_animation_ctx_check(&default_ctx);
 }
+#endif
@@ -6,7 +6,8 @@
 #endif
 
 /**
- * @brief Animation type, outlining the general animation behaviour
+ * @brief Animation type, outlining the general animation behaviour. These are the built in ones, other modules can
+ *        add their own with `sgv_animation_register_type`. See animation_kernel.h
  */
 typedef enum animation_type : uint8_t {
     /* Animation types that use 1 color only */
@@ -15,9 +16,33 @@ typedef enum animation_type : uint8_t {
     SHIMMER,   /* Randomly changing colors */
 
     /* Animation types that use 2 colors */
-    WAVE, /* Wave that changes to another color */
+    WAVE,   /* Wave that changes to another color */
+    RIPPLE, /* Waves from several keys at once. Later ripples join the newest queued one */
+
+    ANIMATION_TYPE_COUNT, /* Animation type count enum value for convenience */
 } animation_type_e;
 
+/* Hosts can time every animation the engine applies by enabling ANIMATION_HOOKS and implementing the hooks */
+#ifndef ANIMATION_HOOKS
+#    define ANIMATION_HOOKS false
+#endif
+
+#if ANIMATION_HOOKS
+/**
+ * @brief Called right before an animation is applied to the current frame
+ *
+ * @param type Type of the animation
+ */
+void animation_hook_begin(animation_type_e type);
+
+/**
+ * @brief Called right after an animation was applied to the current frame
+ *
+ * @param type Type of the animation
+ */
+void animation_hook_end(animation_type_e type);
+#endif
+
 /**
  * @brief Special color type inside an animation
  */
@@ -25,7 +50,7 @@ typedef enum animation_color_special : uint8_t {
     ANIMATION_COLOR_NONE,    /* Nothing special */
     ANIMATION_COLOR_DEFAULT, /* Default keyboard color */
     ANIMATION_COLOR_TRANS,   /* Transparent color */
-    ANIMATION_COLOR_RANDOM,  /* Random color yet consistent color */
+    ANIMATION_COLOR_RANDOM,  /* Random color per LED, which stays the same for the whole animation */
     ANIMATION_COLOR_NOISE,   /* Color noise pattern */
     ANIMATION_COLOR_SHIMMER, /* Shimmer color */
 } animation_color_special_e;
@@ -52,13 +77,39 @@ enum animation_hsv_color_layer : uint8_t {
     ANIMATION_HSV_COLOR_COUNT, /* Animation color layer count enum value for convenience */
 };
 
+/**
+ * @brief How an animation combines with the animations before it. Transparent colors leave what's below as is in
+ *        every mode
+ */
+typedef enum animation_blend : uint8_t {
+    ANIMATION_BLEND_REPLACE,  /* Cover what's below */
+    ANIMATION_BLEND_ADD,      /* Add the value to what's below, saturating. The hue leans towards the brighter color */
+    ANIMATION_BLEND_MAX,      /* Keep the brighter of the two colors */
+    ANIMATION_BLEND_MULTIPLY, /* Scale the value of what's below by the value of the animation */
+    ANIMATION_BLEND_ALPHA,    /* Fade from what's below to the animation by `animation_t.alpha` */
+
+    ANIMATION_BLEND_COUNT, /* Blend mode count enum value for convenience */
+} animation_blend_e;
+
+/**
+ * @brief How much an animation matters when the queue runs out of room. Less important animations make room first
+ */
+typedef enum animation_priority : uint8_t {
+    ANIMATION_PRIORITY_COSMETIC,  /* Keypress effects. What the constructors use */
+    ANIMATION_PRIORITY_AMBIENT,   /* Background effects, which keypress effects shouldn't push out */
+    ANIMATION_PRIORITY_FEEDBACK,  /* Confirms something that was typed, like a combo */
+    ANIMATION_PRIORITY_INDICATOR, /* Shows keyboard state, like the active layer */
+
+    ANIMATION_PRIORITY_COUNT, /* Priority count enum value for convenience */
+} animation_priority_e;
+
 /**
  * @brief Animation type that holds all* data necessary for playing an animation
  */
 typedef struct animation {
-    animation_type_e type; /* Animation type */
+    animation_type_e type; /* Animation type, built in or registered */
 
-    uint8_t  led_index; /* LED data for animationn. Used by SOLID_KEY and WAVE */
+    uint8_t  led_index; /* LED data for animationn. Used by SOLID_KEY, WAVE and RIPPLE */
     bool     done;      /* If this animation has finished already */
     uint32_t ticks;     /* When this animation starts */
 
@@ -67,8 +118,25 @@ typedef struct animation {
 
     /* Array of colors to be used by animation. See `animation_hsv_color_layer` */
     animation_color_t hsv_colors[ANIMATION_HSV_COLOR_COUNT];
+
+    animation_blend_e blend; /* How the animation combines with the ones before it */
+    uint8_t           alpha; /* Opacity of the animation. Used by ANIMATION_BLEND_ALPHA */
+
+    animation_priority_e priority; /* What makes room for what once the queue is full */
 } animation_t;
 
+/* Most keys a ripple can start from. Ripples that don't fit any more start a ripple of their own */
+#define ANIMATION_RIPPLE_ORIGINS 8
+
+/**
+ * @brief Refers to an animation for as long as it's queued. Stops working once the animation finishes, is dropped or
+ *        is cancelled, even if its place in the queue is reused
+ */
+typedef uint16_t animation_handle_t;
+
+/* Handle that never refers to an animation */
+#define ANIMATION_HANDLE_NONE 0
+
 animation_color_t animation_color_val(uint8_t val);
 
 /**
@@ -157,9 +225,20 @@ animation_t animation_wave_solid(uint8_t start_led_index, animation_color_t wave
 animation_t animation_wave_solid_2(uint8_t start_led_index, animation_color_t wave_color,
                                    animation_color_t solid_color);
 
+/**
+ * @brief Creates an animation object that creates a wave of one color like `animation_wave`, which can share its
+ * animation with other ripples. Added right after another ripple with the same colors, except for the wave color, it
+ * becomes one more origin of that ripple and gets its handle
+ *
+ * @param start_led_index The LED the wave starts at
+ * @param wave_color The color of the wave
+ * @return animation_t The animation object
+ */
+animation_t animation_ripple(uint8_t start_led_index, animation_color_t wave_color);
+
 /**
  * @brief Creates an animation object that turns the entire keyboard into a shimmering
- * RGB slop
+ * RGB slop. It's ambient, so keypress effects never push it out of a full queue
  *
  * @return animation_t The animation object
  */
@@ -185,11 +264,77 @@ void sgv_animation_init(void);
 bool sgv_animation_update(effect_params_t* params);
 
 /**
- * @brief Adds an animation to the back of the queue to be played on top of the others
+ * @brief Adds an animation to the back of the queue to be played on top of the others. If the queue is full, a
+ *        cancelled animation or the oldest of the least important ones makes room. The first animation in the queue
+ *        is finished right away, any other one is dropped. Ripples can join the newest ripple instead, see
+ *        `animation_ripple`. If the colors, keymap or ripple tables are full, only cancelled animations are
+ *        dropped to make room in them
  *
  * @param animation The animation to add to the queue
+ * @return animation_handle_t Handle to the queued animation, or ANIMATION_HANDLE_NONE if everything queued is more
+ *         important than it, or there was no room for its colors, keymap or ripple, and it was dropped instead. So
+ *         are animations that start too far ahead, anything within 24 seconds of the last frame is kept
  */
-void sgv_animation_add_animation(animation_t animation);
+animation_handle_t sgv_animation_add_animation(animation_t animation);
+
+/**
+ * @brief Stops a queued animation. It won't be applied again, but whatever it already became the base of the frame
+ *        stays
+ *
+ * @param handle Handle of the animation
+ * @return true If the animation was cancelled
+ * @return false If the handle doesn't refer to an animation anymore
+ */
+bool sgv_animation_cancel(animation_handle_t handle);
+
+/**
+ * @brief Restarts a queued animation at another time
+ *
+ * @param handle Handle of the animation
+ * @param ticks When the animation starts again
+ * @return true If the animation was retimed
+ * @return false If the handle doesn't refer to an animation anymore, or `ticks` is too far ahead. Anything
+ *         within 24 seconds of the last frame is kept
+ */
+bool sgv_animation_retime(animation_handle_t handle, uint32_t ticks);
+
+/**
+ * @brief Changes one of the colors of a queued animation
+ *
+ * @param handle Handle of the animation
+ * @param index Which color to change. See `animation_hsv_color_layer`
+ * @param color The new color
+ * @return true If the color was changed
+ * @return false If the handle doesn't refer to an animation anymore, the index is invalid or there's no room for
+ *               another color
+ */
+bool sgv_animation_recolor(animation_handle_t handle, uint8_t index, animation_color_t color);
+
+/**
+ * @brief Lights a single LED with a color over every animation, without taking up room in the queue. Replaces any
+ *        overlay the LED already had
+ *
+ * @param led LED to light
+ * @param color Color of the LED. Special colors aren't supported
+ * @param fade_ms How long the color takes to fade back into whatever is below it, or 0 to keep it until cleared
+ * @return true If the overlay was set
+ * @return false If the LED isn't lit by the engine, the color is special or the fade is too long
+ */
+bool sgv_animation_overlay_set(uint8_t led, animation_color_t color, uint16_t fade_ms);
+
+/**
+ * @brief Removes the overlay of an LED, if it has one
+ *
+ * @param led LED to remove the overlay of
+ * @return true If the LED had an overlay
+ * @return false Otherwise
+ */
+bool sgv_animation_overlay_clear(uint8_t led);
+
+/**
+ * @brief Removes every overlay
+ */
+void sgv_animation_overlay_clear_all(void);
 
 /**
  * @brief Adds several animations which together create the startup animation
@@ -205,3 +350,146 @@ void sgv_animation_add_startup_animation(uint8_t first_wave_start_led, uint8_t s
  * @brief Resets the state and clears the queue of the animations
  */
 void sgv_animation_reset(void);
+
+/**
+ * @brief Clock the engine reads the time from once per frame, in milliseconds
+ */
+typedef uint32_t (*animation_clock_fn)(void);
+
+/**
+ * @brief Replaces the clock the engine samples at the start of each frame. Every animation in a frame sees the same
+ *        time
+ *
+ * @param clock Clock to use, or NULL to go back to `timer_read32`
+ */
+void sgv_animation_set_clock(animation_clock_fn clock);
+
+/**
+ * @brief An animation engine drawing one zone of the keyboard, with its own queue, frame buffers and clock. The
+ *        sgv_animation_ functions without a context work on a default context that covers every LED
+ */
+typedef struct sgv_animation_ctx sgv_animation_ctx_t;
+
+/* Bytes needed to hold a context */
+extern const size_t sgv_animation_ctx_type_size;
+
+/**
+ * @brief Creates a context that draws a zone of the keyboard. Call `sgv_animation_preinit` first. Contexts live
+ *        entirely in `location` and own no other memory, so they can be created again in place or dropped with
+ *        `location`. They must not be moved once created
+ *
+ * @param location Memory for the context
+ * @param location_size Size of `location`. Must be `sgv_animation_ctx_type_size`
+ * @param leds LEDs in the zone, or NULL for every LED. Other LEDs are never written by this context
+ * @param led_count Amount of LEDs in `leds`
+ * @return true If the context was created
+ * @return false If any of the parameters is invalid
+ */
+bool sgv_animation_ctx_new(void* location, size_t location_size, const uint8_t* leds, uint8_t led_count);
+
+/**
+ * @brief Gets the context the sgv_animation_ functions without a context work on
+ *
+ * @return sgv_animation_ctx_t* The default context
+ */
+sgv_animation_ctx_t* sgv_animation_default_ctx(void);
+
+/**
+ * @brief Initializes the state of a context. Unlike `sgv_animation_init`, doesn't play the startup animation
+ *
+ * @param ctx Context to initialize
+ */
+void sgv_animation_ctx_init(sgv_animation_ctx_t* ctx);
+
+/**
+ * @brief Runs one frame of animation of a context, and draws the LEDs of its zone
+ *
+ * @param ctx Context to run
+ * @param params Animation parameters given by effect handler
+ * @return true If the last LED in the batch is indeed the last one to use as well
+ * @return false Otherwise
+ */
+bool sgv_animation_ctx_update(sgv_animation_ctx_t* ctx, effect_params_t* params);
+
+/**
+ * @brief Draws the last frame of a context again without running its animations. Lets zones render at a lower rate
+ *        than the effect runs at
+ *
+ * @param ctx Context to draw
+ * @param params Animation parameters given by effect handler
+ * @return true If the last LED in the batch is indeed the last one to use as well
+ * @return false Otherwise
+ */
+bool sgv_animation_ctx_redraw(sgv_animation_ctx_t* ctx, effect_params_t* params);
+
+/**
+ * @brief Adds an animation to the back of the queue of a context
+ *
+ * @param ctx Context to add to
+ * @param animation The animation to add to the queue
+ * @return animation_handle_t Handle to the queued animation, only valid with this context
+ */
+animation_handle_t sgv_animation_ctx_add_animation(sgv_animation_ctx_t* ctx, animation_t animation);
+
+/**
+ * @brief Same as `sgv_animation_cancel`, for any context
+ */
+bool sgv_animation_ctx_cancel(sgv_animation_ctx_t* ctx, animation_handle_t handle);
+
+/**
+ * @brief Same as `sgv_animation_retime`, for any context
+ */
+bool sgv_animation_ctx_retime(sgv_animation_ctx_t* ctx, animation_handle_t handle, uint32_t ticks);
+
+/**
+ * @brief Same as `sgv_animation_recolor`, for any context
+ */
+bool sgv_animation_ctx_recolor(sgv_animation_ctx_t* ctx, animation_handle_t handle, uint8_t index,
+                               animation_color_t color);
+
+/**
+ * @brief Same as `sgv_animation_overlay_set`, for any context. Only LEDs in the zone of the context can be lit
+ */
+bool sgv_animation_ctx_overlay_set(sgv_animation_ctx_t* ctx, uint8_t led, animation_color_t color, uint16_t fade_ms);
+
+/**
+ * @brief Same as `sgv_animation_overlay_clear`, for any context
+ */
+bool sgv_animation_ctx_overlay_clear(sgv_animation_ctx_t* ctx, uint8_t led);
+
+/**
+ * @brief Same as `sgv_animation_overlay_clear_all`, for any context
+ */
+void sgv_animation_ctx_overlay_clear_all(sgv_animation_ctx_t* ctx);
+
+/**
+ * @brief Resets the state and clears the queue and the overlays of a context
+ *
+ * @param ctx Context to reset
+ */
+void sgv_animation_ctx_reset(sgv_animation_ctx_t* ctx);
+
+#if ANIMATION_HOOKS
+/**
+ * @brief Makes the engine use plain per LED code instead of the plane kernels and the hue table, on this thread.
+ *        Frames must come out the same either way
+ *
+ * @param reference If the reference code should be used
+ */
+void sgv_animation_set_reference_kernels(bool reference);
+
+/**
+ * @brief Checks the invariants of the engine state on this thread. Meant to be called between frames
+ *
+ * @return const char* Description of the first broken invariant, or NULL if all of them hold
+ */
+const char* sgv_animation_check(void);
+
+/**
+ * @brief Same as `sgv_animation_check`, for any context
+ *
+ * @param ctx Context to check
+ * @return const char* Description of the first broken invariant, or NULL if all of them hold
+ */
+const char* sgv_animation_ctx_check(sgv_animation_ctx_t* ctx);
+#endif
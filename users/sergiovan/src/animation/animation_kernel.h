@@ -0,0 +1,185 @@
+#pragma once
+#include "animation.h"
+
+/**
+ * @brief Kernel interface of the animation engine. Every animation type, built in or not, is a set of kernels the
+ *        engine calls through an `animation_type_def_t`. Other modules can add their own types with
+ *        `sgv_animation_register_type`, and queue them by setting `animation_t.type` to what it returns
+ */
+
+/* Animation types there can be, built in and registered. Queued animations keep their type in 4 bits */
+#ifndef ANIMATION_TYPE_CAPACITY
+#    define ANIMATION_TYPE_CAPACITY 8
+#endif
+
+/**
+ * @brief Where the colors of one color slot of an animation come from during one frame
+ */
+typedef enum color_source_kind : uint8_t {
+    SOURCE_CONSTANT, /* The same color for every LED */
+    SOURCE_PASS,     /* The color the LED has so far this frame */
+    SOURCE_FIELD,    /* A full color hue per LED, computed once for the frame */
+} color_source_kind_e;
+
+/**
+ * @brief A color slot of an animation, resolved for one frame so per LED lookups don't need to know about special
+ *        colors
+ */
+typedef struct color_source {
+    color_source_kind_e kind;
+    COLOR               color; /* Used by SOURCE_CONSTANT */
+    const uint8_t*      field; /* Used by SOURCE_FIELD */
+} color_source_t;
+
+/**
+ * @brief An animation as it sits in the queue. Same as `animation_t`, with the keymap as an entry of the mask table,
+ *        the start time relative to the time base and the colors as entries of the color table of the context
+ */
+typedef struct packed_animation {
+    int16_t  start;                             /* When this animation starts, relative to the time base */
+    uint8_t  led_index;                         /* LED data for animation. Ripple table entry for RIPPLE */
+    uint8_t  mask;                              /* Mask table entry of the keymap, or NO_MASK */
+    uint8_t  type : 4;                          /* Animation type. See `animation_type_e` */
+    uint8_t  done : 1;                          /* If this animation has finished already */
+    uint8_t  blend : 3;                         /* Blend mode. See `animation_blend_e` */
+    uint8_t  alpha;                             /* Opacity. Used by ANIMATION_BLEND_ALPHA */
+    uint16_t specials;                          /* Special color of each color, SPECIAL_BITS each */
+    uint8_t  colors[ANIMATION_HSV_COLOR_COUNT]; /* Color table entry of each color. Specials use COLOR_TABLE_OFF */
+} packed_animation_t;
+
+/**
+ * @brief Enum holding the action that must be taken after each animation is processed
+ */
+typedef enum apply_res : uint8_t {
+    APPLY_OK,         /* No action needed */
+    APPLY_CLEAR_THIS, /* Remove this element from the buffer if it's the first one */
+    APPLY_NEW_BASE,   /* Remove all elements before and including this one from the buffer */
+    BECOME_FIRST,     /* Remove all elements before this one from the buffer */
+    BECOME_NEXT,      /* Remove all elements before this one from the buffer, and turn this one into the animation
+                         that comes after it. See `animation_finish_fn` */
+} apply_res_e;
+
+/**
+ * @brief Resolves the color sources of an animation for the LEDs it looks at
+ *
+ * @param ctx Context the animation runs in
+ * @param animation Animation to resolve
+ * @param sources Receives one source per color slot
+ */
+typedef void (*animation_resolve_fn)(sgv_animation_ctx_t* ctx, packed_animation_t* animation,
+                                     color_source_t sources[ANIMATION_HSV_COLOR_COUNT]);
+
+/**
+ * @brief Calculates one frame for one animation that has already started
+ *
+ * @param ctx Context the animation runs in
+ * @param animation Animation to calculate for
+ * @param sources Color sources of the animation for this frame
+ * @param first If this animation is the first in the queue
+ * @param new_base If this animation can become the new base state
+ * @param finish If this animation must reach its finished state
+ * @return apply_res_e The result of running this frame of this animation
+ */
+typedef apply_res_e (*animation_apply_fn)(sgv_animation_ctx_t* ctx, packed_animation_t* animation,
+                                          const color_source_t* sources, bool first, bool new_base, bool finish);
+
+/**
+ * @brief Turns an animation that returned BECOME_NEXT into the animation that plays after it, in place
+ *
+ * @param ctx Context the animation runs in
+ * @param animation Animation to turn into the next one
+ */
+typedef void (*animation_finish_fn)(sgv_animation_ctx_t* ctx, packed_animation_t* animation);
+
+/**
+ * @brief Checks if an animation covers every LED it runs on, so nothing before it can show through
+ *
+ * @param animation The animation to check
+ * @return true If this animation covers all keys
+ * @return false If this animation could possibly show the animations before it
+ */
+typedef bool (*animation_is_opaque_fn)(const packed_animation_t* animation);
+
+/**
+ * @brief Everything the engine needs to play one animation type
+ */
+typedef struct animation_type_def {
+    animation_resolve_fn   resolve;   /* Resolves the color sources before each frame */
+    animation_apply_fn     apply;     /* Calculates each frame */
+    animation_finish_fn    finish;    /* Turns the animation into the next one. NULL if it never returns BECOME_NEXT */
+    animation_is_opaque_fn is_opaque; /* Decides if the animation can become the new base state */
+} animation_type_def_t;
+
+/**
+ * @brief Adds an animation type. Types are shared by every context, so register them before queueing any animation
+ *        that uses them
+ *
+ * @param def Kernels of the type. Only `finish` can be NULL. Copied, it doesn't need to outlive the call
+ * @return animation_type_e The new type, or ANIMATION_TYPE_CAPACITY if there's no room for it or `def` is missing
+ *         kernels
+ */
+animation_type_e sgv_animation_register_type(const animation_type_def_t* def);
+
+/**
+ * @brief Resolves the color sources of an animation on one LED, `animation_t.led_index`. The `resolve` of SOLID_KEY
+ */
+void sgv_animation_kernel_resolve_key(sgv_animation_ctx_t* ctx, packed_animation_t* animation,
+                                      color_source_t sources[ANIMATION_HSV_COLOR_COUNT]);
+
+/**
+ * @brief Resolves the color sources of an animation on every LED of the zone. The `resolve` of SOLID_ALL
+ */
+void sgv_animation_kernel_resolve_zone(sgv_animation_ctx_t* ctx, packed_animation_t* animation,
+                                       color_source_t sources[ANIMATION_HSV_COLOR_COUNT]);
+
+/**
+ * @brief Checks if the base colors of an animation are opaque. The `is_opaque` of the types with one color
+ */
+bool sgv_animation_kernel_one_color_is_opaque(const packed_animation_t* animation);
+
+/**
+ * @brief Checks if the base and result colors of an animation are opaque. The `is_opaque` of the types with two
+ *        colors
+ */
+bool sgv_animation_kernel_two_color_is_opaque(const packed_animation_t* animation);
+
+/**
+ * @brief Gets the LEDs a context draws, in the order they are drawn
+ *
+ * @param ctx Context to get the LEDs of
+ * @param led_count Receives the amount of LEDs
+ * @return const uint8_t* LEDs of the zone of the context
+ */
+const uint8_t* sgv_animation_kernel_leds(const sgv_animation_ctx_t* ctx, uint8_t* led_count);
+
+/**
+ * @brief Gets how long an animation has been playing in the current frame
+ *
+ * @param ctx Context the animation runs in
+ * @param animation Animation to check
+ * @return uint32_t Milliseconds since the animation started. Kernels only run once it has
+ */
+uint32_t sgv_animation_kernel_elapsed(const sgv_animation_ctx_t* ctx, const packed_animation_t* animation);
+
+/**
+ * @brief Gets one color of an animation on one LED for the current frame. LEDs outside its keymap get the `_N` color
+ *
+ * @param ctx Context the animation runs in
+ * @param animation Animation to get the color of
+ * @param sources Color sources of the animation for this frame
+ * @param led LED to get the color of
+ * @param index Which color to get, i.e. BASE or RESULT. See `animation_hsv_color_layer`
+ * @return COLOR The color of the LED
+ */
+COLOR sgv_animation_kernel_color(sgv_animation_ctx_t* ctx, packed_animation_t* animation,
+                                 const color_source_t* sources, uint8_t led, uint8_t index);
+
+/**
+ * @brief Draws one LED of the current frame
+ *
+ * @param ctx Context to draw in
+ * @param led LED to draw
+ * @param color Color of the LED
+ * @param new_base If the LED becomes part of the base state too, as `apply` is told with `new_base`
+ */
+void sgv_animation_kernel_draw(sgv_animation_ctx_t* ctx, uint8_t led, COLOR color, bool new_base);
@@ -0,0 +1,941 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include "animation/animation.h"
+#include "animation/animation_kernel.h"
+#include "frame_dump.h"
+#include "scenarios.h"
+#include "sim.h"
+}
+
+/* Milliseconds between recorded frames. Coarser than the keyboard to keep golden files small */
+constexpr uint32_t GOLDEN_STEP = 64;
+
+/**
+ * @brief Frame by frame golden file comparison of the animation engine, one test per simulator scenario
+ *
+ * GOLDEN_UPDATE=1 rewrites the golden files from the current engine instead of comparing.
+ * GOLDEN_TOLERANCE=n accepts channels up to n away from the golden value, for approved approximate kernels.
+ */
+class AnimationGoldenTest : public ::testing::TestWithParam<const char*> {
+   protected:
+    static std::string golden_path(const char* scenario) {
+        return std::string{GOLDEN_DIR} + "/" + GOLDEN_BOARD + "_" + scenario + ".txt";
+    }
+
+    static int env_int(const char* name) {
+        const char* value = std::getenv(name);
+        return value ? std::atoi(value) : 0;
+    }
+
+    static std::vector<sim_frame_t> record(const sim_scenario_t* scenario) {
+        std::vector<sim_frame_t> frames;
+
+        sim_scenario_run(
+            scenario, GOLDEN_STEP,
+            [](void* arg, const sim_frame_t* frame) {
+                reinterpret_cast<std::vector<sim_frame_t>*>(arg)->push_back(*frame);
+            },
+            &frames);
+
+        return frames;
+    }
+};
+
+TEST_P(AnimationGoldenTest, matches_golden) {
+    const sim_scenario_t* scenario = sim_scenario_find(GetParam());
+    ASSERT_NE(scenario, nullptr) << "No scenario called " << GetParam();
+
+    std::vector<sim_frame_t> frames = record(scenario);
+    std::string              path   = golden_path(GetParam());
+
+    if (env_int("GOLDEN_UPDATE")) {
+        FILE* file = std::fopen(path.c_str(), "w");
+        ASSERT_NE(file, nullptr) << "Cannot write " << path;
+        for (const sim_frame_t& frame : frames) {
+            ASSERT_TRUE(frame_dump_text(file, &frame));
+        }
+        std::fclose(file);
+        GTEST_SKIP() << "Updated " << path;
+    }
+
+    std::vector<sim_frame_t> golden;
+    FILE*                    file = std::fopen(path.c_str(), "r");
+    ASSERT_NE(file, nullptr) << "Missing golden file " << path << ", run with GOLDEN_UPDATE=1 to create it";
+    for (sim_frame_t frame{}; frame_load_text(file, &frame);) {
+        golden.push_back(frame);
+    }
+    std::fclose(file);
+
+    ASSERT_EQ(frames.size(), golden.size()) << "Scenario length changed";
+
+    const int tolerance = env_int("GOLDEN_TOLERANCE");
+    int       max_diff  = 0;
+
+    for (size_t f = 0; f < frames.size(); ++f) {
+        ASSERT_EQ(frames[f].time, golden[f].time) << "Frame " << f << " was rendered at a different time";
+
+        for (uint8_t led = 0; led < SIM_FRAME_LEDS; ++led) {
+            const sim_pixel_t& actual   = frames[f].leds[led];
+            const sim_pixel_t& expected = golden[f].leds[led];
+
+            int diff = std::max({std::abs(actual.r - expected.r), std::abs(actual.g - expected.g),
+                                 std::abs(actual.b - expected.b)});
+            max_diff = std::max(max_diff, diff);
+
+            ASSERT_LE(diff, tolerance) << "Frame " << f << " at " << frames[f].time << "ms, LED " << +led
+                                       << " is (" << +actual.r << ", " << +actual.g << ", " << +actual.b
+                                       << "), expected (" << +expected.r << ", " << +expected.g << ", "
+                                       << +expected.b << ")";
+        }
+    }
+
+    if (max_diff) {
+        std::printf("%s: largest difference %d, within tolerance\n", GetParam(), max_diff);
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(Scenarios, AnimationGoldenTest,
+                         ::testing::Values("startup", "typing", "storm", "layers", "shimmer", "ripples"),
+                         [](const auto& info) { return std::string{info.param}; });
+
+/**
+ * @brief The engine reads the time once per frame from its frame clock, so a frozen clock freezes every animation
+ *        no matter how much time passes
+ */
+TEST(AnimationFrameClockTest, frozen_clock_freezes_frames) {
+    auto render_shimmer = [](uint32_t advance) {
+        sim_reset();
+        sim_set_time(1000);
+        sim_render_frame(true);
+        sgv_animation_add_animation(animation_shimmer());
+
+        sim_advance_time(advance);
+        return *sim_render_frame(false);
+    };
+
+    auto same_leds = [](const sim_frame_t& a, const sim_frame_t& b) {
+        return std::memcmp(a.leds, b.leds, sizeof a.leds) == 0;
+    };
+
+    sgv_animation_set_clock([]() -> uint32_t { return 5000; });
+    sim_frame_t early = render_shimmer(16);
+    sim_frame_t late  = render_shimmer(3000);
+    EXPECT_TRUE(same_leds(early, late));
+
+    sgv_animation_set_clock(nullptr);
+    early = render_shimmer(16);
+    late  = render_shimmer(3000);
+    EXPECT_FALSE(same_leds(early, late));
+}
+
+/**
+ * @brief Contexts that each draw one zone of the keyboard, next to the default context
+ */
+class AnimationZoneTest : public ::testing::Test {
+   protected:
+    static constexpr uint8_t SPLIT = SIM_FRAME_LEDS / 2;
+
+    void SetUp() override {
+        sim_reset();
+        sim_set_time(SIM_START_TIME);
+    }
+
+    void TearDown() override {
+        for (void* memory : contexts) {
+            std::free(memory);
+        }
+        sim_reset();
+    }
+
+    /* Context drawing the LEDs in [first, last) */
+    sgv_animation_ctx_t* zone(uint8_t first, uint8_t last) {
+        std::vector<uint8_t> leds;
+        for (uint8_t led = first; led < last; ++led) {
+            leds.push_back(led);
+        }
+
+        void* memory = std::malloc(sgv_animation_ctx_type_size);
+        contexts.push_back(memory);
+
+        EXPECT_TRUE(sgv_animation_ctx_new(memory, sgv_animation_ctx_type_size, leds.data(), leds.size()));
+        return static_cast<sgv_animation_ctx_t*>(memory);
+    }
+
+    /* Runs all the batches of one frame of a context, or only draws its last frame again */
+    static const sim_frame_t& draw(sgv_animation_ctx_t* ctx, bool update = true) {
+        effect_params_t params = {.iter = 0, .flags = LED_FLAG_ALL, .init = false};
+        while (update ? sgv_animation_ctx_update(ctx, &params) : sgv_animation_ctx_redraw(ctx, &params)) {
+            params.iter++;
+        }
+        return *sim_current_frame();
+    }
+
+    static bool same_leds(const sim_frame_t& a, const sim_frame_t& b, uint8_t first, uint8_t last) {
+        return std::memcmp(&a.leds[first], &b.leds[first], (last - first) * sizeof(sim_pixel_t)) == 0;
+    }
+
+    std::vector<void*> contexts;
+};
+
+TEST_F(AnimationZoneTest, rejects_bad_zones) {
+    void*   memory = std::malloc(sgv_animation_ctx_type_size);
+    uint8_t leds[] = {0, SIM_FRAME_LEDS};
+
+    EXPECT_FALSE(sgv_animation_ctx_new(memory, sgv_animation_ctx_type_size - 1, nullptr, 0));
+    EXPECT_FALSE(sgv_animation_ctx_new(memory, sgv_animation_ctx_type_size, leds, 2));
+    EXPECT_FALSE(sgv_animation_ctx_new(memory, sgv_animation_ctx_type_size, leds, 0));
+    EXPECT_TRUE(sgv_animation_ctx_new(memory, sgv_animation_ctx_type_size, leds, 1));
+
+    std::free(memory);
+}
+
+TEST_F(AnimationZoneTest, zones_only_draw_their_leds) {
+    sgv_animation_add_animation(animation_solid(0x00, 0xFF, 0x40));
+    sim_frame_t dim = draw(sgv_animation_default_ctx());
+    sgv_animation_add_animation(animation_solid(0xA0, 0xFF, 0xFF));
+    sim_frame_t bright = draw(sgv_animation_default_ctx());
+    ASSERT_FALSE(same_leds(dim, bright, 0, SIM_FRAME_LEDS));
+
+    sim_reset();
+    sim_set_time(SIM_START_TIME);
+
+    sgv_animation_ctx_t* left  = zone(0, SPLIT);
+    sgv_animation_ctx_t* right = zone(SPLIT, SIM_FRAME_LEDS);
+    sgv_animation_ctx_add_animation(left, animation_solid(0x00, 0xFF, 0x40));
+    sgv_animation_ctx_add_animation(right, animation_solid(0xA0, 0xFF, 0xFF));
+
+    const sim_frame_t& frame = draw(left);
+    EXPECT_TRUE(same_leds(frame, dim, 0, SPLIT));
+    for (uint8_t led = SPLIT; led < SIM_FRAME_LEDS; ++led) {
+        ASSERT_EQ(frame.leds[led].r | frame.leds[led].g | frame.leds[led].b, 0) << "LED " << +led;
+    }
+
+    draw(right);
+    EXPECT_TRUE(same_leds(frame, dim, 0, SPLIT));
+    EXPECT_TRUE(same_leds(frame, bright, SPLIT, SIM_FRAME_LEDS));
+}
+
+TEST_F(AnimationZoneTest, zones_render_at_different_rates) {
+    sgv_animation_ctx_t* still  = zone(0, SPLIT);
+    sgv_animation_ctx_t* moving = zone(SPLIT, SIM_FRAME_LEDS);
+    sgv_animation_ctx_add_animation(still, animation_shimmer());
+    sgv_animation_ctx_add_animation(moving, animation_shimmer());
+
+    draw(still);
+    sim_frame_t first = draw(moving);
+
+    sim_advance_time(3000);
+    draw(still, false);
+    sim_frame_t later = draw(moving);
+
+    EXPECT_TRUE(same_leds(first, later, 0, SPLIT));
+    EXPECT_FALSE(same_leds(first, later, SPLIT, SIM_FRAME_LEDS));
+
+    later = draw(still);
+    EXPECT_FALSE(same_leds(first, later, 0, SPLIT));
+}
+
+/**
+ * @brief Handles to queued animations of the default context
+ */
+class AnimationHandleTest : public ::testing::Test {
+   protected:
+    static constexpr uint8_t LED = 10;
+
+    void SetUp() override {
+        sim_reset();
+        sim_set_time(SIM_START_TIME);
+    }
+
+    void TearDown() override {
+        sim_reset();
+    }
+
+    /* Color of a key at value v. LED_MATRIX boards take the value from the first channel */
+    static animation_color_t key_color(uint8_t v) {
+        return animation_solid_key(LED, v, 0xFF, v).hsv_colors[ANIMATION_HSV_COLOR_BASE];
+    }
+
+    /* Key that lights up half a second from now */
+    static animation_t later_key(uint8_t v) {
+        animation_t anim = animation_solid_key(LED, v, 0xFF, v);
+        anim.ticks += 500;
+        return anim;
+    }
+
+    static sim_pixel_t led_after(uint32_t ms) {
+        sim_advance_time(ms);
+        return sim_render_frame(false)->leds[LED];
+    }
+
+    static bool lit(sim_pixel_t pixel) {
+        return pixel.r || pixel.g || pixel.b;
+    }
+};
+
+TEST_F(AnimationHandleTest, cancelled_animations_never_play) {
+    animation_handle_t handle = sgv_animation_add_animation(later_key(0xFF));
+    ASSERT_NE(handle, ANIMATION_HANDLE_NONE);
+
+    EXPECT_FALSE(lit(led_after(0)));
+    EXPECT_TRUE(sgv_animation_cancel(handle));
+    EXPECT_FALSE(sgv_animation_cancel(handle));
+    EXPECT_FALSE(lit(led_after(1000)));
+}
+
+TEST_F(AnimationHandleTest, handles_go_stale) {
+    animation_handle_t handle = sgv_animation_add_animation(animation_solid_key(LED, 0xFF, 0xFF, 0xFF));
+    EXPECT_TRUE(lit(led_after(0)));
+
+    /* The key was applied and left the queue, so its slot is free for the next animation */
+    animation_handle_t next = sgv_animation_add_animation(later_key(0xFF));
+    EXPECT_NE(next, handle);
+    EXPECT_FALSE(sgv_animation_cancel(handle));
+    EXPECT_FALSE(sgv_animation_retime(handle, SIM_START_TIME));
+    EXPECT_FALSE(sgv_animation_recolor(handle, ANIMATION_HSV_COLOR_BASE, key_color(0x00)));
+    EXPECT_TRUE(sgv_animation_cancel(next));
+}
+
+TEST_F(AnimationHandleTest, retimed_animations_start_at_the_new_time) {
+    sgv_animation_add_animation(animation_solid(0x00, 0x00, 0x00));
+    animation_handle_t handle = sgv_animation_add_animation(later_key(0xFF));
+
+    EXPECT_TRUE(sgv_animation_retime(handle, SIM_START_TIME));
+    EXPECT_TRUE(lit(led_after(0)));
+}
+
+TEST_F(AnimationHandleTest, recolored_animations_play_the_new_color) {
+    sgv_animation_add_animation(later_key(0x40));
+    sim_pixel_t expected = led_after(600);
+
+    sim_reset();
+    sim_set_time(SIM_START_TIME);
+
+    animation_handle_t handle = sgv_animation_add_animation(later_key(0xFF));
+    EXPECT_TRUE(sgv_animation_recolor(handle, ANIMATION_HSV_COLOR_BASE, key_color(0x40)));
+    EXPECT_FALSE(sgv_animation_recolor(handle, ANIMATION_HSV_COLOR_COUNT, key_color(0x00)));
+
+    sim_pixel_t actual = led_after(600);
+    EXPECT_TRUE(lit(actual));
+    EXPECT_EQ(std::memcmp(&actual, &expected, sizeof actual), 0);
+}
+
+/**
+ * @brief Queued animations are stored packed, with their start relative to a moving time base and their colors in a
+ *        shared table. None of that must be visible from the outside
+ */
+class AnimationPackedTest : public AnimationHandleTest {};
+
+TEST_F(AnimationPackedTest, far_future_animations_wait_across_rebases) {
+    animation_t anim = animation_solid_key(LED, 0xFF, 0xFF, 0xFF);
+    anim.ticks += 20000;
+    ASSERT_NE(sgv_animation_add_animation(anim), ANIMATION_HANDLE_NONE);
+
+    for (uint32_t elapsed = 0; elapsed < 20000; elapsed += 1000) {
+        SCOPED_TRACE(elapsed);
+        EXPECT_FALSE(lit(led_after(elapsed ? 1000 : 0)));
+        EXPECT_EQ(sgv_animation_check(), nullptr);
+    }
+
+    EXPECT_TRUE(lit(led_after(1000)));
+}
+
+TEST_F(AnimationPackedTest, animations_out_of_reach_are_rejected) {
+    animation_t anim = animation_solid_key(LED, 0xFF, 0xFF, 0xFF);
+    anim.ticks += 40000;
+    EXPECT_EQ(sgv_animation_add_animation(anim), ANIMATION_HANDLE_NONE);
+
+    animation_handle_t handle = sgv_animation_add_animation(later_key(0xFF));
+    ASSERT_NE(handle, ANIMATION_HANDLE_NONE);
+    EXPECT_FALSE(sgv_animation_retime(handle, SIM_START_TIME + 40000));
+
+    /* Neither starts early, the retimed one keeps its old start */
+    EXPECT_FALSE(lit(led_after(0)));
+    EXPECT_TRUE(lit(led_after(500)));
+    EXPECT_EQ(sgv_animation_check(), nullptr);
+}
+
+TEST_F(AnimationPackedTest, long_ago_animations_still_play) {
+    led_after(60000);
+
+    animation_t anim = animation_solid_key(LED, 0xFF, 0xFF, 0xFF);
+    anim.ticks -= 50000;
+    ASSERT_NE(sgv_animation_add_animation(anim), ANIMATION_HANDLE_NONE);
+
+    EXPECT_TRUE(lit(led_after(0)));
+    EXPECT_EQ(sgv_animation_check(), nullptr);
+}
+
+TEST_F(AnimationPackedTest, many_colors_keep_the_newest) {
+    sgv_animation_add_animation(later_key(0x80));
+    sim_pixel_t expected = led_after(600);
+
+    sim_reset();
+    sim_set_time(SIM_START_TIME);
+
+    /* More animations and distinct colors than fit, so older ones are applied early to make room */
+    for (uint8_t i = 0; i < 40; ++i) {
+        sgv_animation_add_animation(animation_wave_solid_2(LED, key_color(0x10 + i), key_color(0x90 - i)));
+        ASSERT_EQ(sgv_animation_check(), nullptr);
+    }
+    ASSERT_NE(sgv_animation_add_animation(later_key(0x80)), ANIMATION_HANDLE_NONE);
+    EXPECT_EQ(sgv_animation_check(), nullptr);
+
+    sim_pixel_t actual = led_after(600);
+    EXPECT_EQ(std::memcmp(&actual, &expected, sizeof actual), 0);
+}
+
+/**
+ * @brief Animations blended with what's below them instead of covering it. Colors are grey, so both kinds of boards
+ *        see the same values
+ */
+class AnimationBlendTest : public AnimationHandleTest {
+   protected:
+    static animation_t grey(uint8_t v, animation_blend_e blend = ANIMATION_BLEND_REPLACE, uint8_t alpha = 0xFF) {
+        animation_t anim = animation_solid(v, 0x00, v);
+        anim.blend       = blend;
+        anim.alpha       = alpha;
+        return anim;
+    }
+
+    /* What the LED looks like with only a solid grey of value v */
+    static sim_pixel_t only(uint8_t v) {
+        sim_reset();
+        sim_set_time(SIM_START_TIME);
+        sgv_animation_add_animation(grey(v));
+        return led_after(0);
+    }
+
+    static void expect_blend(uint8_t below, uint8_t above, animation_blend_e blend, uint8_t expected,
+                             uint8_t alpha = 0xFF) {
+        SCOPED_TRACE(blend);
+        sim_pixel_t want = only(expected);
+
+        sim_reset();
+        sim_set_time(SIM_START_TIME);
+        sgv_animation_add_animation(grey(below));
+        sgv_animation_add_animation(grey(above, blend, alpha));
+
+        sim_pixel_t got = led_after(0);
+        EXPECT_EQ(std::memcmp(&got, &want, sizeof got), 0);
+        EXPECT_EQ(sgv_animation_check(), nullptr);
+
+        /* The blended colors stay once the animations are gone */
+        got = led_after(100);
+        EXPECT_EQ(std::memcmp(&got, &want, sizeof got), 0);
+    }
+};
+
+TEST_F(AnimationBlendTest, modes_combine_with_what_is_below) {
+    expect_blend(0x40, 0x40, ANIMATION_BLEND_ADD, 0x80);
+    expect_blend(0xC0, 0x80, ANIMATION_BLEND_ADD, 0xFF);
+    expect_blend(0x40, 0x20, ANIMATION_BLEND_MAX, 0x40);
+    expect_blend(0x40, 0x60, ANIMATION_BLEND_MAX, 0x60);
+    expect_blend(0x80, 0x80, ANIMATION_BLEND_MULTIPLY, 0x40);
+    expect_blend(0x00, 0xFF, ANIMATION_BLEND_ALPHA, 0x80, 0x80);
+}
+
+TEST_F(AnimationBlendTest, transparent_colors_leave_what_is_below) {
+    sim_pixel_t want = only(0x40);
+
+    for (uint8_t blend = ANIMATION_BLEND_ADD; blend < ANIMATION_BLEND_COUNT; ++blend) {
+        SCOPED_TRACE(blend);
+
+        sim_reset();
+        sim_set_time(SIM_START_TIME);
+        sgv_animation_add_animation(grey(0x40));
+
+        /* A key somewhere else, which leaves every other LED transparent */
+        animation_t key = animation_solid_key(LED + 1, 0xFF, 0x00, 0xFF);
+        key.blend       = static_cast<animation_blend_e>(blend);
+        sgv_animation_add_animation(key);
+
+        sim_pixel_t got = led_after(0);
+        EXPECT_EQ(std::memcmp(&got, &want, sizeof got), 0);
+    }
+}
+
+/**
+ * @brief A full queue makes room by pushing out its least important animations, and turns away animations less
+ *        important than everything queued
+ */
+class AnimationPriorityTest : public AnimationHandleTest {
+   protected:
+    /* More than fit in the queue */
+    static constexpr uint8_t FLOOD = 40;
+
+    static animation_t later_key(uint8_t led, animation_priority_e priority) {
+        animation_t anim = animation_solid_key(led, 0xFF, 0xFF, 0xFF);
+        anim.ticks += 500;
+        anim.priority = priority;
+        return anim;
+    }
+
+    /* Four colors of their own each, the color table runs out long before the queue does */
+    static animation_t colorful(uint8_t n) {
+        animation_t anim = later_key(LED, ANIMATION_PRIORITY_COSMETIC);
+        for (uint8_t i = 0; i < ANIMATION_HSV_COLOR_COUNT; ++i) {
+            anim.hsv_colors[i] = key_color(1 + n * ANIMATION_HSV_COLOR_COUNT + i);
+        }
+        return anim;
+    }
+};
+
+TEST_F(AnimationPriorityTest, indicators_survive_a_cosmetic_flood) {
+    animation_handle_t indicator = sgv_animation_add_animation(later_key(LED, ANIMATION_PRIORITY_INDICATOR));
+    ASSERT_NE(indicator, ANIMATION_HANDLE_NONE);
+
+    for (uint8_t i = 0; i < FLOOD; ++i) {
+        EXPECT_NE(sgv_animation_add_animation(later_key(LED + 1, ANIMATION_PRIORITY_COSMETIC)), ANIMATION_HANDLE_NONE);
+    }
+
+    EXPECT_TRUE(sgv_animation_retime(indicator, SIM_START_TIME + 500));
+    EXPECT_EQ(sgv_animation_check(), nullptr);
+    EXPECT_TRUE(lit(led_after(600)));
+}
+
+TEST_F(AnimationPriorityTest, less_important_animations_are_rejected) {
+    for (uint8_t i = 0; i < FLOOD; ++i) {
+        EXPECT_NE(sgv_animation_add_animation(later_key(LED + 1, ANIMATION_PRIORITY_INDICATOR)),
+                  ANIMATION_HANDLE_NONE);
+    }
+
+    EXPECT_EQ(sgv_animation_add_animation(later_key(LED, ANIMATION_PRIORITY_FEEDBACK)), ANIMATION_HANDLE_NONE);
+    EXPECT_EQ(sgv_animation_add_animation(later_key(LED, ANIMATION_PRIORITY_AMBIENT)), ANIMATION_HANDLE_NONE);
+    EXPECT_EQ(sgv_animation_check(), nullptr);
+    EXPECT_FALSE(lit(led_after(600)));
+}
+
+TEST_F(AnimationPriorityTest, cancelled_animations_make_room_first) {
+    std::vector<animation_handle_t> queued;
+    for (uint8_t i = 0; i < FLOOD; ++i) {
+        animation_handle_t handle = sgv_animation_add_animation(later_key(LED, ANIMATION_PRIORITY_AMBIENT));
+        ASSERT_NE(handle, ANIMATION_HANDLE_NONE);
+        queued.push_back(handle);
+    }
+
+    /* The oldest were pushed out to make room for the rest. Recoloring to the same color changes nothing */
+    std::erase_if(queued, [&](animation_handle_t handle) {
+        return !sgv_animation_recolor(handle, ANIMATION_HSV_COLOR_BASE, key_color(0xFF));
+    });
+    ASSERT_LT(queued.size(), FLOOD);
+
+    animation_handle_t cancelled = queued[queued.size() / 2];
+    ASSERT_TRUE(sgv_animation_cancel(cancelled));
+    ASSERT_NE(sgv_animation_add_animation(later_key(LED, ANIMATION_PRIORITY_AMBIENT)), ANIMATION_HANDLE_NONE);
+
+    /* Without the cancelled animation the oldest one would have gone */
+    for (animation_handle_t handle : queued) {
+        EXPECT_EQ(sgv_animation_recolor(handle, ANIMATION_HSV_COLOR_BASE, key_color(0xFF)), handle != cancelled);
+    }
+    EXPECT_EQ(sgv_animation_check(), nullptr);
+}
+
+TEST_F(AnimationPriorityTest, shimmer_survives_a_flood_of_waves) {
+    animation_handle_t shimmer = sgv_animation_add_animation(animation_shimmer());
+    ASSERT_NE(shimmer, ANIMATION_HANDLE_NONE);
+
+    for (uint8_t i = 0; i < FLOOD; ++i) {
+        animation_t wave = animation_wave_solid(LED, key_color(0xFF));
+        wave.ticks += 500;
+        EXPECT_NE(sgv_animation_add_animation(wave), ANIMATION_HANDLE_NONE);
+    }
+
+    EXPECT_TRUE(sgv_animation_retime(shimmer, SIM_START_TIME));
+    EXPECT_EQ(sgv_animation_check(), nullptr);
+}
+
+TEST_F(AnimationPriorityTest, shimmers_left_by_waves_survive_a_flood_of_waves) {
+    animation_handle_t shimmer = sgv_animation_add_animation(
+        animation_wave_solid_2(LED, key_color(0xFF), animation_color_special(ANIMATION_COLOR_SHIMMER)));
+    ASSERT_NE(shimmer, ANIMATION_HANDLE_NONE);
+
+    /* Long enough for the wave to cross the board and turn into a shimmer */
+    for (uint32_t ms = 0; ms < 3000; ms += 16) {
+        led_after(16);
+    }
+
+    for (uint8_t i = 0; i < FLOOD; ++i) {
+        animation_t wave = animation_wave_solid(LED, key_color(0xFF));
+        wave.ticks += 500;
+        EXPECT_NE(sgv_animation_add_animation(wave), ANIMATION_HANDLE_NONE);
+    }
+
+    EXPECT_TRUE(sgv_animation_retime(shimmer, SIM_START_TIME));
+    EXPECT_EQ(sgv_animation_check(), nullptr);
+}
+
+TEST_F(AnimationPriorityTest, full_color_tables_reject_instead_of_evicting) {
+    std::vector<animation_handle_t> queued;
+    for (uint8_t n = 0;; ++n) {
+        animation_handle_t handle = sgv_animation_add_animation(colorful(n));
+        if (handle == ANIMATION_HANDLE_NONE) {
+            break;
+        }
+        queued.push_back(handle);
+    }
+    ASSERT_GT(queued.size(), 1u);
+    ASSERT_LT(queued.size(), FLOOD / 2);
+
+    for (animation_handle_t handle : queued) {
+        EXPECT_TRUE(sgv_animation_retime(handle, SIM_START_TIME + 500));
+    }
+
+    /* Cancelled animations give their colors back right away */
+    ASSERT_TRUE(sgv_animation_cancel(queued.back()));
+    EXPECT_NE(sgv_animation_add_animation(colorful(FLOOD)), ANIMATION_HANDLE_NONE);
+    EXPECT_EQ(sgv_animation_check(), nullptr);
+}
+
+TEST_F(AnimationPriorityTest, adjacent_cancelled_animations_all_make_room) {
+    /* Two animations next to each other that share their colors, which only go back once both are dropped */
+    animation_handle_t first  = sgv_animation_add_animation(colorful(0));
+    animation_handle_t second = sgv_animation_add_animation(colorful(0));
+    ASSERT_NE(first, ANIMATION_HANDLE_NONE);
+    ASSERT_NE(second, ANIMATION_HANDLE_NONE);
+
+    for (uint8_t n = 1; sgv_animation_add_animation(colorful(n)) != ANIMATION_HANDLE_NONE; ++n) {
+        ASSERT_LT(n, FLOOD);
+    }
+
+    ASSERT_TRUE(sgv_animation_cancel(first));
+    ASSERT_TRUE(sgv_animation_cancel(second));
+    EXPECT_NE(sgv_animation_add_animation(colorful(FLOOD)), ANIMATION_HANDLE_NONE);
+    EXPECT_EQ(sgv_animation_check(), nullptr);
+}
+
+/**
+ * @brief Ripples added right after each other share one animation, which draws every wave in one pass
+ */
+class AnimationRippleTest : public AnimationHandleTest {
+   protected:
+    /* LEDs far enough apart that their waves don't meet for a while */
+    static constexpr uint8_t NEAR = 0;
+    static constexpr uint8_t FAR  = SIM_FRAME_LEDS - 1;
+
+    static animation_t ripple(uint8_t led, uint8_t v) {
+        return animation_ripple(led, key_color(v));
+    }
+};
+
+TEST_F(AnimationRippleTest, ripples_share_an_animation) {
+    animation_handle_t handle = sgv_animation_add_animation(ripple(NEAR, 0xFF));
+    ASSERT_NE(handle, ANIMATION_HANDLE_NONE);
+
+    for (uint8_t i = 1; i < ANIMATION_RIPPLE_ORIGINS; ++i) {
+        sim_advance_time(10);
+        EXPECT_EQ(sgv_animation_add_animation(ripple(i, 0x80 + i)), handle);
+        EXPECT_EQ(sgv_animation_check(), nullptr);
+    }
+
+    /* No room for more origins */
+    animation_handle_t next = sgv_animation_add_animation(ripple(FAR, 0xFF));
+    EXPECT_NE(next, ANIMATION_HANDLE_NONE);
+    EXPECT_NE(next, handle);
+
+    /* Anything else in between starts a new ripple too */
+    sgv_animation_add_animation(animation_solid_key(LED, 0xFF, 0xFF, 0xFF));
+    EXPECT_NE(sgv_animation_add_animation(ripple(FAR, 0xFF)), next);
+
+    /* Cancelling one cancels all of its waves */
+    EXPECT_TRUE(sgv_animation_cancel(handle));
+    EXPECT_FALSE(sgv_animation_cancel(handle));
+    EXPECT_EQ(sgv_animation_check(), nullptr);
+}
+
+TEST_F(AnimationRippleTest, one_origin_plays_like_a_wave) {
+    std::vector<sim_frame_t> expected;
+    sgv_animation_add_animation(animation_wave(NEAR, key_color(0xFF)));
+    for (uint32_t ms = 0; ms < 600; ms += 16) {
+        sim_advance_time(ms ? 16 : 0);
+        expected.push_back(*sim_render_frame(false));
+    }
+
+    sim_reset();
+    sim_set_time(SIM_START_TIME);
+    sgv_animation_add_animation(ripple(NEAR, 0xFF));
+    for (uint32_t ms = 0; ms < 600; ms += 16) {
+        SCOPED_TRACE(ms);
+        sim_advance_time(ms ? 16 : 0);
+        const sim_frame_t* frame = sim_render_frame(false);
+        EXPECT_EQ(std::memcmp(frame, &expected[ms / 16], sizeof *frame), 0);
+        EXPECT_EQ(sgv_animation_check(), nullptr);
+    }
+}
+
+TEST_F(AnimationRippleTest, every_wave_keeps_its_color) {
+    /* What the far key looks like with only its own wave, started 50ms after the near one */
+    sim_set_time(SIM_START_TIME + 50);
+    sgv_animation_add_animation(animation_wave(FAR, key_color(0x40)));
+    sim_advance_time(10);
+    sim_pixel_t want = sim_render_frame(false)->leds[FAR];
+    ASSERT_TRUE(lit(want));
+
+    sim_reset();
+    sim_set_time(SIM_START_TIME);
+    animation_handle_t handle = sgv_animation_add_animation(ripple(NEAR, 0xFF));
+    sim_advance_time(50);
+    ASSERT_EQ(sgv_animation_add_animation(ripple(FAR, 0x40)), handle);
+
+    sim_advance_time(10);
+    sim_pixel_t got = sim_render_frame(false)->leds[FAR];
+    EXPECT_EQ(std::memcmp(&got, &want, sizeof got), 0);
+    EXPECT_EQ(sgv_animation_check(), nullptr);
+}
+
+TEST_F(AnimationRippleTest, added_ripples_show_over_a_shimmer) {
+    /* The shimmer alone, once it has faded in */
+    std::vector<sim_frame_t> expected;
+    sgv_animation_add_animation(animation_shimmer());
+    sim_advance_time(1000);
+    for (uint32_t ms = 0; ms < 600; ms += 16) {
+        sim_advance_time(16);
+        expected.push_back(*sim_render_frame(false));
+    }
+
+    sim_reset();
+    sim_set_time(SIM_START_TIME);
+    sgv_animation_add_animation(animation_shimmer());
+    sim_advance_time(1000);
+    sim_render_frame(false);
+
+    animation_t anim = animation_ripple(NEAR, animation_color_hsv(0x55, 0xFF, 0xFF));
+    anim.blend       = ANIMATION_BLEND_ADD;
+    ASSERT_NE(sgv_animation_add_animation(anim), ANIMATION_HANDLE_NONE);
+
+    uint32_t changed = 0;
+    for (uint32_t ms = 0; ms < 600; ms += 16) {
+        sim_advance_time(16);
+        const sim_frame_t* frame = sim_render_frame(false);
+        for (uint8_t i = 0; i < SIM_FRAME_LEDS; ++i) {
+            changed += std::memcmp(&frame->leds[i], &expected[ms / 16].leds[i], sizeof frame->leds[i]) != 0;
+        }
+        EXPECT_EQ(sgv_animation_check(), nullptr);
+    }
+    EXPECT_GT(changed, SIM_FRAME_LEDS);
+}
+
+/**
+ * @brief Overlays light single keys over every animation, without going through the queue
+ */
+class AnimationOverlayTest : public AnimationPriorityTest {};
+
+TEST_F(AnimationOverlayTest, overlays_take_no_room_in_the_queue) {
+    for (uint8_t i = 0; i < FLOOD; ++i) {
+        EXPECT_NE(sgv_animation_add_animation(later_key(LED + 1, ANIMATION_PRIORITY_INDICATOR)),
+                  ANIMATION_HANDLE_NONE);
+    }
+
+    EXPECT_TRUE(sgv_animation_overlay_set(LED, key_color(0xFF), 0));
+    EXPECT_TRUE(lit(led_after(0)));
+    EXPECT_EQ(sgv_animation_check(), nullptr);
+}
+
+TEST_F(AnimationOverlayTest, overlays_cover_animations_until_cleared) {
+    sgv_animation_add_animation(animation_solid_key(LED, 0xFF, 0xFF, 0xFF));
+    ASSERT_TRUE(lit(led_after(0)));
+
+    EXPECT_TRUE(sgv_animation_overlay_set(LED, key_color(0x00), 0));
+    EXPECT_FALSE(lit(led_after(16)));
+    EXPECT_FALSE(lit(led_after(5000)));
+
+    EXPECT_TRUE(sgv_animation_overlay_clear(LED));
+    EXPECT_FALSE(sgv_animation_overlay_clear(LED));
+    EXPECT_TRUE(lit(led_after(16)));
+    EXPECT_EQ(sgv_animation_check(), nullptr);
+}
+
+TEST_F(AnimationOverlayTest, overlays_fade_into_what_is_below) {
+    sgv_animation_add_animation(animation_solid_key(LED, 0x40, 0xFF, 0x40));
+    sim_pixel_t below = led_after(0);
+    ASSERT_TRUE(lit(below));
+
+    ASSERT_TRUE(sgv_animation_overlay_set(LED, key_color(0xFF), 1000));
+    sim_pixel_t start = led_after(0);
+    sim_pixel_t half  = led_after(500);
+    EXPECT_NE(std::memcmp(&start, &below, sizeof start), 0);
+    EXPECT_NE(std::memcmp(&half, &start, sizeof half), 0);
+    EXPECT_NE(std::memcmp(&half, &below, sizeof half), 0);
+
+    /* Faded out overlays are gone, not just invisible */
+    sim_pixel_t end = led_after(500);
+    EXPECT_EQ(std::memcmp(&end, &below, sizeof end), 0);
+    EXPECT_FALSE(sgv_animation_overlay_clear(LED));
+    EXPECT_EQ(sgv_animation_check(), nullptr);
+}
+
+TEST_F(AnimationOverlayTest, overlays_fade_on_the_engine_clock) {
+    sgv_animation_add_animation(animation_solid_key(LED, 0x40, 0xFF, 0x40));
+    sim_pixel_t below = led_after(0);
+
+    /* The engine clock stands still, so the overlay never fades however much time the keyboard sees go by */
+    sgv_animation_set_clock([]() -> uint32_t { return SIM_START_TIME + 5000; });
+    EXPECT_TRUE(sgv_animation_overlay_set(LED, key_color(0xFF), 1000));
+    sim_pixel_t start = led_after(0);
+    sim_pixel_t later = led_after(3000);
+    sgv_animation_set_clock(nullptr);
+
+    EXPECT_NE(std::memcmp(&start, &below, sizeof start), 0);
+    EXPECT_EQ(std::memcmp(&later, &start, sizeof later), 0);
+    EXPECT_EQ(sgv_animation_check(), nullptr);
+}
+
+TEST_F(AnimationOverlayTest, overlays_last_across_rebases) {
+    ASSERT_TRUE(sgv_animation_overlay_set(LED, key_color(0xFF), 0));
+    ASSERT_TRUE(sgv_animation_overlay_set(LED + 1, key_color(0xFF), 30000));
+
+    for (uint32_t elapsed = 0; elapsed < 20000; elapsed += 1000) {
+        SCOPED_TRACE(elapsed);
+        EXPECT_TRUE(lit(led_after(elapsed ? 1000 : 0)));
+        EXPECT_EQ(sgv_animation_check(), nullptr);
+    }
+
+    led_after(20000);
+    EXPECT_TRUE(sgv_animation_overlay_clear(LED));
+    EXPECT_FALSE(sgv_animation_overlay_clear(LED + 1));
+}
+
+TEST_F(AnimationOverlayTest, rejects_what_it_cannot_draw) {
+    EXPECT_FALSE(sgv_animation_overlay_set(0xFF, key_color(0xFF), 0));
+    EXPECT_FALSE(sgv_animation_overlay_set(LED, animation_color_special(ANIMATION_COLOR_SHIMMER), 0));
+    EXPECT_FALSE(sgv_animation_overlay_set(LED, key_color(0xFF), 40000));
+    EXPECT_FALSE(sgv_animation_overlay_clear(LED));
+}
+
+/**
+ * @brief Random colors are picked once per animation and LED, not every frame
+ */
+class AnimationRandomTest : public AnimationHandleTest {
+   protected:
+    static animation_t random_wave() {
+        return animation_wave_solid(LED, animation_color_special(ANIMATION_COLOR_RANDOM));
+    }
+};
+
+TEST_F(AnimationRandomTest, random_colors_stay_the_same_every_frame) {
+    sgv_animation_add_animation(random_wave());
+
+    sim_pixel_t first = led_after(200);
+    ASSERT_TRUE(lit(first));
+    for (uint32_t ms = 16; ms < 1000; ms += 16) {
+        SCOPED_TRACE(ms);
+        sim_pixel_t pixel = led_after(16);
+        EXPECT_EQ(std::memcmp(&pixel, &first, sizeof pixel), 0);
+    }
+    EXPECT_EQ(sgv_animation_check(), nullptr);
+}
+
+TEST_F(AnimationRandomTest, animations_added_together_get_their_own_colors) {
+    sgv_animation_add_animation(random_wave());
+    sim_advance_time(1000);
+    sim_frame_t alone = *sim_render_frame(false);
+
+    sim_reset();
+    sim_set_time(SIM_START_TIME);
+
+    /* Same time, same LED. The second one covers the first */
+    sgv_animation_add_animation(random_wave());
+    sgv_animation_add_animation(random_wave());
+    sim_advance_time(1000);
+    const sim_frame_t* frame = sim_render_frame(false);
+
+    uint8_t different = 0;
+    for (uint8_t led = 0; led < SIM_FRAME_LEDS; ++led) {
+        different += std::memcmp(&frame->leds[led], &alone.leds[led], sizeof frame->leds[led]) != 0;
+    }
+    EXPECT_GT(different, SIM_FRAME_LEDS / 2);
+    EXPECT_EQ(sgv_animation_check(), nullptr);
+}
+
+TEST_F(AnimationRandomTest, random_colors_differ_between_leds) {
+    sgv_animation_add_animation(random_wave());
+    sim_advance_time(1000);
+    const sim_frame_t* frame = sim_render_frame(false);
+
+    uint8_t different = 0;
+    for (uint8_t led = 0; led < SIM_FRAME_LEDS; ++led) {
+        different += std::memcmp(&frame->leds[led], &frame->leds[LED], sizeof frame->leds[led]) != 0;
+    }
+    EXPECT_GT(different, SIM_FRAME_LEDS / 2);
+}
+
+/**
+ * @brief Other modules can add animation types, which play like the built in ones
+ */
+class AnimationTypeTest : public AnimationHandleTest {
+   protected:
+    /* Lights every other LED of the zone with the base color, and leaves the rest alone */
+    static apply_res_e stripes_apply(sgv_animation_ctx_t* ctx, packed_animation_t* animation,
+                                     const color_source_t* sources, bool first, bool new_base, bool finish) {
+        uint8_t        led_count = 0;
+        const uint8_t* leds      = sgv_animation_kernel_leds(ctx, &led_count);
+        for (uint8_t k = 0; k < led_count; ++k) {
+            if (leds[k] % 2 == 0) {
+                sgv_animation_kernel_draw(ctx, leds[k],
+                                          sgv_animation_kernel_color(ctx, animation, sources, leds[k],
+                                                                     ANIMATION_HSV_COLOR_BASE),
+                                          new_base);
+            }
+        }
+        return APPLY_OK;
+    }
+
+    static bool never_opaque(const packed_animation_t* animation) {
+        return false;
+    }
+
+    /* Types can't be unregistered, so every test shares this one */
+    static animation_type_e stripes() {
+        static const animation_type_def_t def  = {sgv_animation_kernel_resolve_zone, stripes_apply, NULL, never_opaque};
+        static const animation_type_e     type = sgv_animation_register_type(&def);
+        return type;
+    }
+
+    static animation_t stripes_animation() {
+        animation_t anim = animation_solid(0xFF, 0xFF, 0xFF);
+        anim.type        = stripes();
+        return anim;
+    }
+};
+
+TEST_F(AnimationTypeTest, registered_types_play) {
+    ASSERT_GE(stripes(), ANIMATION_TYPE_COUNT);
+    ASSERT_LT(stripes(), ANIMATION_TYPE_CAPACITY);
+    ASSERT_NE(sgv_animation_add_animation(stripes_animation()), ANIMATION_HANDLE_NONE);
+
+    const sim_frame_t* frame = sim_render_frame(false);
+    EXPECT_TRUE(lit(frame->leds[LED]));
+    EXPECT_FALSE(lit(frame->leds[LED + 1]));
+    EXPECT_EQ(sgv_animation_check(), nullptr);
+}
+
+TEST_F(AnimationTypeTest, unknown_types_are_rejected) {
+    animation_t anim = animation_solid(0xFF, 0xFF, 0xFF);
+    anim.type        = static_cast<animation_type_e>(ANIMATION_TYPE_CAPACITY);
+    EXPECT_EQ(sgv_animation_add_animation(anim), ANIMATION_HANDLE_NONE);
+
+    animation_type_def_t missing = {sgv_animation_kernel_resolve_zone, NULL, NULL, never_opaque};
+    EXPECT_EQ(sgv_animation_register_type(&missing), ANIMATION_TYPE_CAPACITY);
+}
+
+TEST_F(AnimationTypeTest, registration_stops_at_capacity) {
+    stripes();
+
+    animation_type_def_t def = {sgv_animation_kernel_resolve_zone, stripes_apply, NULL, never_opaque};
+    for (uint8_t type = ANIMATION_TYPE_COUNT; type < ANIMATION_TYPE_CAPACITY; ++type) {
+        sgv_animation_register_type(&def);
+    }
+    EXPECT_EQ(sgv_animation_register_type(&def), ANIMATION_TYPE_CAPACITY);
+
+    /* Types registered before keep working */
+    EXPECT_NE(sgv_animation_add_animation(stripes_animation()), ANIMATION_HANDLE_NONE);
+    EXPECT_TRUE(lit(led_after(0)));
+}
@@ -0,0 +1,103 @@
+#include "capture.h"
+
+#if SGV_CAPTURE
+
+#    include "circular_buffer/circular_buffer.h"
+
+#    include <stdlib.h>
+
+#    define CAPTURE_BYTE_SIZE (sizeof(capture_event_t) * CAPTURE_RING_SIZE)
+
+/* Memory for the circular buffer. Contains raw data */
+static uint8_t capture_mem[CAPTURE_BYTE_SIZE] = {0};
+
+/* Circular buffer handle, created on first use */
+static circular_buffer_t *captures = NULL;
+
+static uint16_t capture_dropped_count = 0;
+
+/**
+ * @brief Pushes one event, dropping the oldest if the ring is full
+ */
+static void capture_push(capture_event_t event) {
+    if (captures == NULL) {
+        // Free not needed
+        captures = malloc(circular_buffer_type_size);
+        circular_buffer_new(captures, circular_buffer_type_size, &capture_mem, CAPTURE_BYTE_SIZE, CAPTURE_RING_SIZE,
+                            sizeof(capture_event_t));
+    }
+
+    if (circular_buffer_full(captures)) {
+        capture_event_t scrap;
+        circular_buffer_shift(captures, &scrap);
+        if (capture_dropped_count < UINT16_MAX) {
+            capture_dropped_count++;
+        }
+    }
+
+    circular_buffer_push(captures, &event);
+}
+
+void capture_key(keyrecord_t *record) {
+    capture_push((capture_event_t){
+        .time   = timer_read32(),
+        .layers = layer_state,
+        .type   = record->event.pressed ? CAPTURE_KEY_DOWN : CAPTURE_KEY_UP,
+        .row    = record->event.key.row,
+        .col    = record->event.key.col,
+        .tap    = record->tap.count,
+        .mods   = get_mods(),
+    });
+}
+
+void capture_layer(layer_state_t state) {
+    capture_push((capture_event_t){
+        .time   = timer_read32(),
+        .layers = state,
+        .type   = CAPTURE_LAYER,
+    });
+}
+
+void capture_clear(void) {
+    capture_event_t scrap;
+    while (capture_drain(&scrap, 1)) {
+    }
+    capture_dropped_count = 0;
+}
+
+uint8_t capture_drain(capture_event_t *events, uint8_t max) {
+    uint8_t taken = 0;
+
+    if (captures == NULL) {
+        return 0;
+    }
+
+    while (taken < max && circular_buffer_shift(captures, &events[taken])) {
+        taken++;
+    }
+
+    return taken;
+}
+
+uint16_t capture_dropped(void) {
+    uint16_t dropped      = capture_dropped_count;
+    capture_dropped_count = 0;
+    return dropped;
+}
+
+void capture_print(void) {
+#    ifdef CONSOLE_ENABLE
+    capture_event_t event;
+    uint16_t        dropped = capture_dropped();
+
+    if (dropped) {
+        uprintf("capture dropped %u\n", dropped);
+    }
+    while (capture_drain(&event, 1)) {
+        uprintf("capture %lu %u %u %u %u %u %u\n", (unsigned long)event.time, event.type, event.row, event.col,
+                event.tap, event.mods, event.layers);
+    }
+#    endif
+}
+
+#endif
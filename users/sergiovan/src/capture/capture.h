@@ -0,0 +1,88 @@
+#pragma once
+#include "common/common.h"
+
+/* Key event capture, to replay real typing sessions in the host simulator. Off by default, enable by defining
+   SGV_CAPTURE as true */
+#ifndef SGV_CAPTURE
+#    define SGV_CAPTURE false
+#endif
+
+/* Amount of events kept. Once full, the oldest events are overwritten */
+#ifndef CAPTURE_RING_SIZE
+#    define CAPTURE_RING_SIZE 128
+#endif
+
+/**
+ * @brief Captured event types
+ */
+typedef enum capture_event_type : uint8_t {
+    CAPTURE_KEY_UP,   /* A key was released */
+    CAPTURE_KEY_DOWN, /* A key was pressed */
+    CAPTURE_LAYER,    /* The layer state changed */
+
+    CAPTURE_EVENT_COUNT, /* Capture event type count enum value for convenience */
+} capture_event_type_e;
+
+/**
+ * @brief One captured event. Keycodes are not stored, replays resolve them from the keymap and the layer state
+ */
+typedef struct capture_event {
+    uint32_t             time;   /* When the event happened, in milliseconds */
+    uint16_t             layers; /* Layer state when the key event happened, or the new layer state */
+    capture_event_type_e type;   /* What happened */
+    uint8_t              row;    /* Matrix row of the key */
+    uint8_t              col;    /* Matrix column of the key */
+    uint8_t              tap;    /* Tap count QMK gave the key event */
+    uint8_t              mods;   /* Modifiers held during the key event */
+} capture_event_t;
+
+#if SGV_CAPTURE
+
+/**
+ * @brief Records a key event as it reaches `process_record_user`
+ *
+ * @param record The key record
+ */
+void capture_key(keyrecord_t *record);
+
+/**
+ * @brief Records a layer state change as it reaches `layer_state_set_user`
+ *
+ * @param state The new layer state
+ */
+void capture_layer(layer_state_t state);
+
+/**
+ * @brief Throws away every captured event and the dropped count
+ */
+void capture_clear(void);
+
+/**
+ * @brief Takes the oldest events out of the ring
+ *
+ * @param events Where to write the events
+ * @param max Maximum amount of events to take
+ * @return uint8_t Amount of events taken
+ */
+uint8_t capture_drain(capture_event_t *events, uint8_t max);
+
+/**
+ * @brief Returns how many events were overwritten before being drained, and resets the count
+ */
+uint16_t capture_dropped(void);
+
+/**
+ * @brief Drains the whole ring over the QMK console, one `capture <time> <type> <row> <col> <tap> <mods> <layers>`
+ *        line per event. Does nothing without CONSOLE_ENABLE
+ */
+void capture_print(void);
+
+#    define CAPTURE_KEY(record) capture_key(record)
+#    define CAPTURE_LAYER(state) capture_layer(state)
+
+#else
+
+#    define CAPTURE_KEY(record)
+#    define CAPTURE_LAYER(state)
+
+#endif
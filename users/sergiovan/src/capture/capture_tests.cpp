@@ -0,0 +1,169 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <vector>
+
+extern "C" {
+#include "capture/capture.h"
+#include "replay.h"
+#include "sim.h"
+}
+
+/* Milliseconds between replayed frames */
+constexpr uint32_t REPLAY_STEP = 16;
+
+class CaptureTest : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        sim_reset();
+    }
+
+    void TearDown() override {
+        sim_reset();
+    }
+
+    static capture_event_t key(uint32_t time, bool pressed, uint8_t row, uint8_t col, layer_state_t layers = 0) {
+        return capture_event_t{
+            .time   = time,
+            .layers = static_cast<uint16_t>(layers),
+            .type   = pressed ? CAPTURE_KEY_DOWN : CAPTURE_KEY_UP,
+            .row    = row,
+            .col    = col,
+            .tap    = 0,
+            .mods   = 0,
+        };
+    }
+
+    static capture_event_t layer(uint32_t time, layer_state_t layers) {
+        return capture_event_t{
+            .time   = time,
+            .layers = static_cast<uint16_t>(layers),
+            .type   = CAPTURE_LAYER,
+            .row    = 0,
+            .col    = 0,
+            .tap    = 0,
+            .mods   = 0,
+        };
+    }
+
+    /* A short typing session: a few letters, then a peek at the FN layer. Times start at SIM_START_TIME so the
+       events captured during the replay have the same times */
+    static std::vector<capture_event_t> session() {
+        constexpr layer_state_t fn = 1UL << FN;
+
+        return {
+            key(SIM_START_TIME + 0, true, 2, 1),       key(SIM_START_TIME + 80, false, 2, 1),
+            key(SIM_START_TIME + 150, true, 3, 0),     key(SIM_START_TIME + 190, true, 2, 3),
+            key(SIM_START_TIME + 260, false, 3, 0),    key(SIM_START_TIME + 300, false, 2, 3),
+            layer(SIM_START_TIME + 500, fn),           key(SIM_START_TIME + 520, true, 1, 4, fn),
+            key(SIM_START_TIME + 600, false, 1, 4, fn), layer(SIM_START_TIME + 700, 0),
+            key(SIM_START_TIME + 900, true, 4, 5),     key(SIM_START_TIME + 950, false, 4, 5),
+        };
+    }
+
+    static std::vector<sim_frame_t> replay(std::vector<capture_event_t>& events) {
+        std::vector<sim_frame_t> frames;
+        sim_replay_t             replay = {events.data(), static_cast<uint32_t>(events.size())};
+
+        sim_replay_run(
+            &replay, REPLAY_STEP,
+            [](void* arg, const sim_frame_t* frame) {
+                reinterpret_cast<std::vector<sim_frame_t>*>(arg)->push_back(*frame);
+            },
+            &frames);
+
+        return frames;
+    }
+};
+
+TEST_F(CaptureTest, overwrites_oldest_when_full) {
+    for (uint32_t i = 0; i < CAPTURE_RING_SIZE + 3; ++i) {
+        sim_set_time(i);
+        capture_layer(i);
+    }
+
+    EXPECT_EQ(capture_dropped(), 3);
+    EXPECT_EQ(capture_dropped(), 0);
+
+    capture_event_t event;
+    ASSERT_EQ(capture_drain(&event, 1), 1);
+    EXPECT_EQ(event.time, 3u);
+    EXPECT_EQ(event.type, CAPTURE_LAYER);
+    EXPECT_EQ(event.layers, 3);
+
+    uint32_t left = 0;
+    while (capture_drain(&event, 1)) {
+        ++left;
+    }
+    EXPECT_EQ(left, CAPTURE_RING_SIZE - 1u);
+}
+
+TEST_F(CaptureTest, loads_console_logs) {
+    const char log[] = "capture dropped 2\n"
+                       "trace 10 0 0 0\n"
+                       "keyboard: capture 1200 1 2 3 1 2 4\n"
+                       "capture 1300 2 0 0 0 0 0\n"
+                       "capture 1400 9 0 0 0 0 0\n";
+
+    FILE* file = fmemopen(const_cast<char*>(log), sizeof log - 1, "r");
+    ASSERT_NE(file, nullptr);
+
+    sim_replay_t replay;
+    ASSERT_TRUE(sim_replay_load(file, &replay));
+    std::fclose(file);
+
+    ASSERT_EQ(replay.count, 2u);
+    EXPECT_EQ(replay.events[0].time, 1200u);
+    EXPECT_EQ(replay.events[0].type, CAPTURE_KEY_DOWN);
+    EXPECT_EQ(replay.events[0].row, 2);
+    EXPECT_EQ(replay.events[0].col, 3);
+    EXPECT_EQ(replay.events[0].tap, 1);
+    EXPECT_EQ(replay.events[0].mods, 2);
+    EXPECT_EQ(replay.events[0].layers, 4);
+    EXPECT_EQ(replay.events[1].type, CAPTURE_LAYER);
+    EXPECT_EQ(sim_replay_duration(&replay), 100u + SIM_REPLAY_TAIL);
+
+    sim_replay_free(&replay);
+}
+
+TEST_F(CaptureTest, replay_recaptures_the_session) {
+    std::vector<capture_event_t> events = session();
+
+    replay(events);
+
+    std::vector<capture_event_t> captured(events.size() + 1);
+    ASSERT_EQ(capture_drain(captured.data(), captured.size()), events.size());
+
+    for (size_t i = 0; i < events.size(); ++i) {
+        SCOPED_TRACE(i);
+        EXPECT_EQ(captured[i].time, events[i].time);
+        EXPECT_EQ(captured[i].type, events[i].type);
+        EXPECT_EQ(captured[i].layers, events[i].layers);
+        if (events[i].type != CAPTURE_LAYER) {
+            EXPECT_EQ(captured[i].row, events[i].row);
+            EXPECT_EQ(captured[i].col, events[i].col);
+        }
+    }
+}
+
+TEST_F(CaptureTest, replay_is_deterministic) {
+    std::vector<capture_event_t> events = session();
+
+    std::vector<sim_frame_t> first  = replay(events);
+    std::vector<sim_frame_t> second = replay(events);
+
+    sim_replay_t loaded = {events.data(), static_cast<uint32_t>(events.size())};
+    ASSERT_EQ(first.size(), (sim_replay_duration(&loaded) + REPLAY_STEP - 1) / REPLAY_STEP);
+    ASSERT_EQ(first.size(), second.size());
+
+    bool lit = false;
+    for (size_t i = 0; i < first.size(); ++i) {
+        ASSERT_EQ(std::memcmp(&first[i], &second[i], sizeof(sim_frame_t)), 0) << "Frame " << i << " differs";
+        for (uint8_t led = 0; led < SIM_FRAME_LEDS; ++led) {
+            lit = lit || first[i].leds[led].r || first[i].leds[led].g || first[i].leds[led].b;
+        }
+    }
+
+    /* The keys started animations, or the replay didn't reach the engine */
+    EXPECT_TRUE(lit);
+}
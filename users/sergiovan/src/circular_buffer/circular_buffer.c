@@ -19,6 +19,9 @@ typedef struct circular_buffer {
 
 const size_t circular_buffer_type_size = sizeof(circular_buffer_t);
 
+_Static_assert(sizeof(circular_buffer_t) <= sizeof(circular_buffer_storage_t),
+               "Circular buffers don't fit in circular_buffer_storage_t");
+
 bool circular_buffer_new(void* cb_location, size_t cb_location_size, void* buffer, size_t buffer_size, uint8_t elems,
                          uint8_t elem_size) {
     if (cb_location == NULL || buffer == NULL) {
@@ -10,6 +10,12 @@ typedef struct circular_buffer circular_buffer_t;
 /* Size in bytes of the circular buffer structure */
 extern const size_t circular_buffer_type_size;
 
+/* Memory a circular buffer structure fits in, for owners that keep it inline instead of allocating it */
+typedef union circular_buffer_storage {
+    void*   align;
+    uint8_t bytes[sizeof(void*) + 8];
+} circular_buffer_storage_t;
+
 /**
  * @brief Creates a circular buffer for elements of a certain size
  *
@@ -4,18 +4,15 @@
 #define DEBUG_FUNCTIONS false
 
 #if LED_MATRIX_ENABLE
-typedef union color {
-    uint8_t h;
-    uint8_t s;
-    uint8_t v;
-} color_t;
+/* LED_MATRIX boards only have one channel, so a color is just the brightness of an LED. Colors given as h, s and
+   v use the first component as the brightness, so anything that changes hue on RGB boards changes brightness
+   here instead */
+typedef uint8_t color_t;
 
 #    define USING_RGB false
 #    define COLOR color_t
-#    define MAKE_COLOR(x, ...) \
-        (COLOR) {              \
-            x                  \
-        }
+#    define MAKE_COLOR(x, ...) ((COLOR)(x))
+#    define COLOR_VAL(c) (c)
 #    define COLOR_OFF 0x0
 #    define LED_COUNT LED_MATRIX_LED_COUNT
 #    define MATRIX_USE_LIMITS LED_MATRIX_USE_LIMITS
@@ -27,6 +24,7 @@ typedef union color {
         (COLOR) {           \
             __VA_ARGS__     \
         }
+#    define COLOR_VAL(c) ((c).v)
 #    define COLOR_OFF RGB_OFF
 #    define LED_COUNT RGB_MATRIX_LED_COUNT
 #    define MATRIX_USE_LIMITS RGB_MATRIX_USE_LIMITS
@@ -35,6 +33,7 @@ typedef union color {
 #    define USING_RGB false
 #    define COLOR
 #    define MAKE_COLOR(...)
+#    define COLOR_VAL(c)
 #    define COLOR_OFF 0x0
 #    define LED_COUNT 0
 #    define MATRIX_USE_LIMITS
@@ -53,6 +52,12 @@ extern COLOR debug_leds[10];
 
 #endif
 
+/* Storage for module state that is per thread on hosts that run several simulated keyboards at once. The firmware
+   has a single thread, so this is empty unless QMK_KEYBOARD_H says otherwise */
+#ifndef SGV_THREAD_LOCAL
+#    define SGV_THREAD_LOCAL
+#endif
+
 // TODO Add q notation typedefs
 
 /**
@@ -88,6 +93,9 @@ enum custom_keycodes {
     SGV_PRSC, /* Custom keycode that goes on the screenshot */
     SGV_MUTE, /* Custom keycode that goes on the mute */
 
+    SGV_PROF, /* Dump the LED task profiling counters over the console */
+    SGV_CAPT, /* Dump the captured key events over the console, for replays in the simulator */
+
     SGV_COUNT, /* Layer count enum value for convenience */
     /* COPIES GO HERE */
 };
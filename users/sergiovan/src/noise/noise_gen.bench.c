@@ -0,0 +1,95 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "noise_gen.h"
+
+/* Same sampling grid as the keyboard: QMK LED coordinates go from (0, 0) to (224, 64) */
+#define GRID_W 225
+#define GRID_H 65
+#define GRID_STEP 8
+
+#define FRAMES 2000
+
+/* Sink so the compiler can't drop the noise calls */
+static volatile uint32_t sink = 0;
+
+typedef struct bench {
+    const char *name;
+    uint32_t (*run)(uint32_t frame);
+} bench_t;
+
+static uint32_t run_perlin2d(uint32_t frame) {
+    uint32_t acc = 0;
+    for (int32_t x = 0; x < GRID_W; x += GRID_STEP) {
+        for (int32_t y = 0; y < GRID_H; y += GRID_STEP) {
+            acc += perlin2d_fixed(x + frame, y + frame, 0x1666);
+        }
+    }
+    return acc;
+}
+
+static uint32_t run_simplex2d(uint32_t frame) {
+    uint32_t acc = 0;
+    for (int32_t x = 0; x < GRID_W; x += GRID_STEP) {
+        for (int32_t y = 0; y < GRID_H; y += GRID_STEP) {
+            acc += simplex2d_fixed(x + frame, y + frame, 0x1666);
+        }
+    }
+    return acc;
+}
+
+static uint32_t run_perlin3d(uint32_t frame) {
+    uint32_t acc = 0;
+    for (int32_t x = 0; x < GRID_W; x += GRID_STEP) {
+        for (int32_t y = 0; y < GRID_H; y += GRID_STEP) {
+            acc += perlin3d_fixed(x, y, frame, 0x1666);
+        }
+    }
+    return acc;
+}
+
+static uint32_t run_simplex3d(uint32_t frame) {
+    uint32_t acc = 0;
+    for (int32_t x = 0; x < GRID_W; x += GRID_STEP) {
+        for (int32_t y = 0; y < GRID_H; y += GRID_STEP) {
+            acc += simplex3d_fixed(x, y, frame, 0x1666);
+        }
+    }
+    return acc;
+}
+
+static const bench_t benches[] = {
+    {"perlin2d_fixed", run_perlin2d},
+    {"simplex2d_fixed", run_simplex2d},
+    {"perlin3d_fixed", run_perlin3d},
+    {"simplex3d_fixed", run_simplex3d},
+};
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+int main(void) {
+    const uint32_t samples_per_frame = ((GRID_W + GRID_STEP - 1) / GRID_STEP) * ((GRID_H + GRID_STEP - 1) / GRID_STEP);
+    const uint32_t samples           = samples_per_frame * FRAMES;
+
+    printf("%-16s %12s %12s\n", "backend", "ns/sample", "ns/frame");
+
+    for (size_t b = 0; b < sizeof benches / sizeof benches[0]; ++b) {
+        /* Warm up caches and the hash table */
+        sink += benches[b].run(0);
+
+        uint64_t start = now_ns();
+        for (uint32_t frame = 0; frame < FRAMES; ++frame) {
+            sink += benches[b].run(frame);
+        }
+        uint64_t elapsed = now_ns() - start;
+
+        printf("%-16s %12.2f %12.2f\n", benches[b].name, (double)elapsed / samples, (double)elapsed / FRAMES);
+    }
+
+    return 0;
+}
@@ -30,6 +30,20 @@ static uint8_t noise2(int32_t x, int32_t y) {
     return hash[(tmp + x) & 255];
 }
 
+/**
+ * @brief Hashes x, y and z together using the hash table
+ *
+ * @param x x value of perlin 3d position
+ * @param y y value of perlin 3d position
+ * @param z z value of perlin 3d position
+ * @return uint8_t The hash of (x, y, z)
+ */
+static uint8_t noise3(int32_t x, int32_t y, int32_t z) {
+    uint8_t tmp = hash[(z + SEED) & 255];
+    tmp         = hash[(tmp + y) & 255];
+    return hash[(tmp + x) & 255];
+}
+
 // x, y = u8, s = u16q16
 
 /**
@@ -79,8 +93,233 @@ inline static uint8_t noise2d(int32_t x, int32_t y) {
     return smooth_inter(low, high, y_frac);
 }
 
+// x, y, z = i32q16
+
+/**
+ * @brief Get one 3D noise data point
+ *
+ * @param x x value of the perlin 3D noise, in i32q16
+ * @param y y value of the perlin 3D noise, in i32q16
+ * @param z z value of the perlin 3D noise, in i32q16
+ * @return uint8_t Perlin noise at location (x, y, z)
+ */
+inline static uint8_t noise3d(int32_t x, int32_t y, int32_t z) {
+    // i16
+    int16_t x_int = x >> 16;
+    int16_t y_int = y >> 16;
+    int16_t z_int = z >> 16;
+    // u16q16
+    uint16_t x_frac = x & 0xFFFF;
+    uint16_t y_frac = y & 0xFFFF;
+    uint16_t z_frac = z & 0xFFFF;
+
+    uint8_t near_low  = smooth_inter(noise3(x_int, y_int, z_int), noise3(x_int + 1, y_int, z_int), x_frac);
+    uint8_t near_high = smooth_inter(noise3(x_int, y_int + 1, z_int), noise3(x_int + 1, y_int + 1, z_int), x_frac);
+    uint8_t far_low   = smooth_inter(noise3(x_int, y_int, z_int + 1), noise3(x_int + 1, y_int, z_int + 1), x_frac);
+    uint8_t far_high =
+        smooth_inter(noise3(x_int, y_int + 1, z_int + 1), noise3(x_int + 1, y_int + 1, z_int + 1), x_frac);
+
+    uint8_t near = smooth_inter(near_low, near_high, y_frac);
+    uint8_t far  = smooth_inter(far_low, far_high, y_frac);
+    return smooth_inter(near, far, z_frac);
+}
+
+/* Simplex noise. Based off Stefan Gustavson's "Simplex noise demystified", in fixed point */
+
+/* Skew and unskew factors, in i32q16 */
+#define SIMPLEX_F2 23988 /* (sqrt(3) - 1) / 2 */
+#define SIMPLEX_G2 13849 /* (3 - sqrt(3)) / 6 */
+#define SIMPLEX_F3 21845 /* 1 / 3 */
+#define SIMPLEX_G3 10923 /* 1 / 6 */
+
+/* Squared radius of influence of each corner, in i32q16 */
+#define SIMPLEX_R2_2D 0x8000 /* 0.5 */
+#define SIMPLEX_R2_3D 39322  /* 0.6 */
+
+/* Gradient directions for 2D simplex noise, indexed by the low 3 bits of the corner hash */
+static const int8_t grad2[8][2] = {
+    {1, 1}, {-1, 1}, {1, -1}, {-1, -1}, {1, 0}, {-1, 0}, {0, 1}, {0, -1},
+};
+
+/* Gradient directions for 3D simplex noise, the 12 cube edges padded to 16 to index by the low 4 bits
+   of the corner hash */
+static const int8_t grad3[16][3] = {
+    {1, 1, 0},  {-1, 1, 0},  {1, -1, 0}, {-1, -1, 0}, {1, 0, 1},  {-1, 0, 1}, {1, 0, -1}, {-1, 0, -1},
+    {0, 1, 1},  {0, -1, 1},  {0, 1, -1}, {0, -1, -1}, {1, 1, 0},  {0, -1, 1}, {-1, 1, 0}, {0, -1, -1},
+};
+
+/**
+ * @brief Multiplies two i32q16 values
+ */
+static inline int32_t mul_q16(int32_t a, int32_t b) {
+    return ((int64_t)a * b) >> 16;
+}
+
+/**
+ * @brief Squares an i32q16 value smaller than 2.0 without 64 bit math
+ */
+static inline int32_t sqr_q16(int32_t a) {
+    a >>= 8;
+    return a * a;
+}
+
+/**
+ * @brief Turns a simplex noise sum in i32q16, roughly in [-1, 1], into a byte centered around 128
+ */
+static inline uint8_t simplex_to_u8(int32_t n) {
+    n = 128 + ((n * 127) >> 16);
+    return n < 0 ? 0 : n > 255 ? 255 : n;
+}
+
+/**
+ * @brief Contribution of one 2D simplex corner
+ *
+ * @param h Hash of the corner
+ * @param x x distance to the corner, in i32q16
+ * @param y y distance to the corner, in i32q16
+ * @return int32_t The contribution of the corner, in i32q16
+ */
+static inline int32_t simplex2_corner(uint8_t h, int32_t x, int32_t y) {
+    int32_t t = SIMPLEX_R2_2D - sqr_q16(x) - sqr_q16(y);
+    t         = t > 0 ? t : 0;
+
+    const int8_t *g = grad2[h & 7];
+
+    /* t is at most 0.5, and the offsets are below 0.71 whenever t > 0, so none of these overflow */
+    t = (t * t) >> 16;
+    t = (t * t) >> 16;
+    return (t * (g[0] * x + g[1] * y)) >> 16;
+}
+
+/**
+ * @brief Contribution of one 3D simplex corner
+ *
+ * @param h Hash of the corner
+ * @param x x distance to the corner, in i32q16
+ * @param y y distance to the corner, in i32q16
+ * @param z z distance to the corner, in i32q16
+ * @return int32_t The contribution of the corner, in i32q16
+ */
+static inline int32_t simplex3_corner(uint8_t h, int32_t x, int32_t y, int32_t z) {
+    int32_t t = SIMPLEX_R2_3D - sqr_q16(x) - sqr_q16(y) - sqr_q16(z);
+    t         = t > 0 ? t : 0;
+
+    const int8_t *g = grad3[h & 15];
+
+    /* t is at most 0.6, and the offsets are below 0.78 whenever t > 0, so none of these overflow */
+    t = (t * t) >> 16;
+    t = (t * t) >> 16;
+    return (t * (g[0] * x + g[1] * y + g[2] * z)) >> 16;
+}
+
+// x, y = i32q16
+
+/**
+ * @brief Get one simplex noise data point
+ *
+ * @param x x value of the simplex 2D noise, in i32q16
+ * @param y y value of the simplex 2D noise, in i32q16
+ * @return uint8_t Simplex noise at location (x, y)
+ */
+inline static uint8_t simplex2d(int32_t x, int32_t y) {
+    /* Skew the input space to find which simplex cell we're in */
+    int32_t s = mul_q16(x + y, SIMPLEX_F2);
+    int32_t i = (x + s) >> 16;
+    int32_t j = (y + s) >> 16;
+
+    /* Unskew the cell origin back to (x, y) space */
+    int32_t t  = (i + j) * SIMPLEX_G2;
+    int32_t x0 = x - ((i << 16) - t);
+    int32_t y0 = y - ((j << 16) - t);
+
+    /* Lower or upper triangle of the skewed cell */
+    int32_t i1 = x0 > y0 ? 1 : 0;
+    int32_t j1 = 1 - i1;
+
+    int32_t x1 = x0 - (i1 << 16) + SIMPLEX_G2;
+    int32_t y1 = y0 - (j1 << 16) + SIMPLEX_G2;
+    int32_t x2 = x0 - (1 << 16) + 2 * SIMPLEX_G2;
+    int32_t y2 = y0 - (1 << 16) + 2 * SIMPLEX_G2;
+
+    int32_t n = simplex2_corner(noise2(i, j), x0, y0);
+    n += simplex2_corner(noise2(i + i1, j + j1), x1, y1);
+    n += simplex2_corner(noise2(i + 1, j + 1), x2, y2);
+
+    /* Scale to roughly [-1, 1] */
+    return simplex_to_u8(n * 70);
+}
+
+// x, y, z = i32q16
+
+/**
+ * @brief Get one 3D simplex noise data point
+ *
+ * @param x x value of the simplex 3D noise, in i32q16
+ * @param y y value of the simplex 3D noise, in i32q16
+ * @param z z value of the simplex 3D noise, in i32q16
+ * @return uint8_t Simplex noise at location (x, y, z)
+ */
+inline static uint8_t simplex3d(int32_t x, int32_t y, int32_t z) {
+    /* Skew the input space to find which simplex cell we're in */
+    int32_t s = mul_q16(x + y + z, SIMPLEX_F3);
+    int32_t i = (x + s) >> 16;
+    int32_t j = (y + s) >> 16;
+    int32_t k = (z + s) >> 16;
+
+    /* Unskew the cell origin back to (x, y, z) space */
+    int32_t t  = (i + j + k) * SIMPLEX_G3;
+    int32_t x0 = x - ((i << 16) - t);
+    int32_t y0 = y - ((j << 16) - t);
+    int32_t z0 = z - ((k << 16) - t);
+
+    /* Offsets of the second and third corners, depending on which of the 6 simplices we're in. Ranking the
+       coordinates instead of branching keeps this cheap on out of order hosts too */
+    uint8_t rank_x = (x0 >= y0) + (x0 >= z0);
+    uint8_t rank_y = (y0 > x0) + (y0 >= z0);
+    uint8_t rank_z = (z0 > x0) + (z0 > y0);
+
+    int32_t i1 = rank_x >= 2, j1 = rank_y >= 2, k1 = rank_z >= 2;
+    int32_t i2 = rank_x >= 1, j2 = rank_y >= 1, k2 = rank_z >= 1;
+
+    int32_t x1 = x0 - (i1 << 16) + SIMPLEX_G3;
+    int32_t y1 = y0 - (j1 << 16) + SIMPLEX_G3;
+    int32_t z1 = z0 - (k1 << 16) + SIMPLEX_G3;
+    int32_t x2 = x0 - (i2 << 16) + 2 * SIMPLEX_G3;
+    int32_t y2 = y0 - (j2 << 16) + 2 * SIMPLEX_G3;
+    int32_t z2 = z0 - (k2 << 16) + 2 * SIMPLEX_G3;
+    int32_t x3 = x0 - (1 << 16) + 3 * SIMPLEX_G3;
+    int32_t y3 = y0 - (1 << 16) + 3 * SIMPLEX_G3;
+    int32_t z3 = z0 - (1 << 16) + 3 * SIMPLEX_G3;
+
+    int32_t n = simplex3_corner(noise3(i, j, k), x0, y0, z0);
+    n += simplex3_corner(noise3(i + i1, j + j1, k + k1), x1, y1, z1);
+    n += simplex3_corner(noise3(i + i2, j + j2, k + k2), x2, y2, z2);
+    n += simplex3_corner(noise3(i + 1, j + 1, k + 1), x3, y3, z3);
+
+    /* Scale to roughly [-1, 1] */
+    return simplex_to_u8(n * 32);
+}
+
+void noise_gen_set_seed(uint8_t seed) {
+    SEED = seed;
+}
+
 // x, y = i32q0, freq = i16q16
 
 uint8_t perlin2d_fixed(int32_t x, int32_t y, int32q16_t freq) {
     return noise2d(x * freq, y * freq);
 }
+
+// x, y, z = i32q0, freq = i16q16
+
+uint8_t perlin3d_fixed(int32_t x, int32_t y, int32_t z, int32q16_t freq) {
+    return noise3d(x * freq, y * freq, z * freq);
+}
+
+uint8_t simplex2d_fixed(int32_t x, int32_t y, int32q16_t freq) {
+    return simplex2d(x * freq, y * freq);
+}
+
+uint8_t simplex3d_fixed(int32_t x, int32_t y, int32_t z, int32q16_t freq) {
+    return simplex3d(x * freq, y * freq, z * freq);
+}
@@ -1,9 +1,23 @@
 #pragma once
 
 #include <stdint.h>
+#include <stdbool.h>
 
 typedef int32_t int32q16_t;
 
+/* Noise backend used by `noise2d_fixed` and `noise3d_fixed`. Set to true to use simplex noise instead of perlin */
+#ifndef NOISE_GEN_SIMPLEX
+#    define NOISE_GEN_SIMPLEX false
+#endif
+
+/**
+ * @brief Sets the seed used by all noise functions. The seed is added to the lattice y coordinate (z in 3D) before
+ *        hashing, so a different seed gives the same noise field moved by `seed` lattice cells along that axis
+ *
+ * @param seed The new seed
+ */
+void noise_gen_set_seed(uint8_t seed);
+
 /**
  * @brief Gets one byte of perlin noise at location x, y. Based off https://gist.github.com/nowl/828013
  *
@@ -13,3 +27,59 @@ typedef int32_t int32q16_t;
  * @return uint8_t The value of the perlin noise at x, y
  */
 uint8_t perlin2d_fixed(int32_t x, int32_t y, int32q16_t freq);
+
+/**
+ * @brief Gets one byte of perlin noise at location x, y, z. Needs 8 corner hashes and 7 interpolations
+ *
+ * @param x x position, in i32q0
+ * @param y y position, in i32q0
+ * @param z z position, in i32q0
+ * @param freq "Zoom" value, in i16q16. The smaller this is, the more "zoomed in" the noise becomes
+ * @return uint8_t The value of the perlin noise at x, y, z
+ */
+uint8_t perlin3d_fixed(int32_t x, int32_t y, int32_t z, int32q16_t freq);
+
+/**
+ * @brief Gets one byte of simplex noise at location x, y. Integer only, needs 3 corner hashes and
+ *        no interpolation
+ *
+ * @param x x position, in i32q0
+ * @param y y position, in i32q0
+ * @param freq "Zoom" value, in i16q16. The smaller this is, the more "zoomed in" the noise becomes
+ * @return uint8_t The value of the simplex noise at x, y, centered around 128
+ */
+uint8_t simplex2d_fixed(int32_t x, int32_t y, int32q16_t freq);
+
+/**
+ * @brief Gets one byte of simplex noise at location x, y, z. Integer only, needs 4 corner hashes and
+ *        no interpolation
+ *
+ * @param x x position, in i32q0
+ * @param y y position, in i32q0
+ * @param z z position, in i32q0
+ * @param freq "Zoom" value, in i16q16. The smaller this is, the more "zoomed in" the noise becomes
+ * @return uint8_t The value of the simplex noise at x, y, z, centered around 128
+ */
+uint8_t simplex3d_fixed(int32_t x, int32_t y, int32_t z, int32q16_t freq);
+
+/**
+ * @brief Gets one byte of 2D noise from the backend selected by `NOISE_GEN_SIMPLEX`
+ */
+static inline uint8_t noise2d_fixed(int32_t x, int32_t y, int32q16_t freq) {
+#if NOISE_GEN_SIMPLEX
+    return simplex2d_fixed(x, y, freq);
+#else
+    return perlin2d_fixed(x, y, freq);
+#endif
+}
+
+/**
+ * @brief Gets one byte of 3D noise from the backend selected by `NOISE_GEN_SIMPLEX`
+ */
+static inline uint8_t noise3d_fixed(int32_t x, int32_t y, int32_t z, int32q16_t freq) {
+#if NOISE_GEN_SIMPLEX
+    return simplex3d_fixed(x, y, z, freq);
+#else
+    return perlin3d_fixed(x, y, z, freq);
+#endif
+}
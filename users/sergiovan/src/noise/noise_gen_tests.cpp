@@ -0,0 +1,126 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdlib>
+
+extern "C" {
+#include "noise_gen.h"
+}
+
+/* QMK LED coordinates go from (0, 0) to (224, 64) */
+constexpr int32_t GRID_W = 225;
+constexpr int32_t GRID_H = 65;
+
+/* Same frequency the LED matrix shimmer uses */
+constexpr int32q16_t FREQ = 0x1666;
+
+class NoiseGenTest : public ::testing::Test {
+   protected:
+    void TearDown() override {
+        noise_gen_set_seed(0);
+    }
+};
+
+#define NOISE_TEST(x) TEST_F(NoiseGenTest, x)
+
+NOISE_TEST(perlin_deterministic) {
+    for (int32_t x = 0; x < GRID_W; x += 7) {
+        for (int32_t y = 0; y < GRID_H; y += 5) {
+            ASSERT_EQ(perlin2d_fixed(x, y, FREQ), perlin2d_fixed(x, y, FREQ))
+                << "Perlin noise at (" << x << ", " << y << ") changed between calls";
+        }
+    }
+}
+
+NOISE_TEST(simplex_deterministic) {
+    for (int32_t x = 0; x < GRID_W; x += 7) {
+        for (int32_t y = 0; y < GRID_H; y += 5) {
+            ASSERT_EQ(simplex2d_fixed(x, y, FREQ), simplex2d_fixed(x, y, FREQ))
+                << "Simplex noise at (" << x << ", " << y << ") changed between calls";
+            ASSERT_EQ(simplex3d_fixed(x, y, 3, FREQ), simplex3d_fixed(x, y, 3, FREQ))
+                << "3D simplex noise at (" << x << ", " << y << ", 3) changed between calls";
+        }
+    }
+}
+
+NOISE_TEST(seed_changes_output) {
+    auto checksum = [](auto noise) {
+        uint32_t acc = 0;
+        for (int32_t x = 0; x < GRID_W; x += 3) {
+            for (int32_t y = 0; y < GRID_H; y += 3) {
+                acc = acc * 31 + noise(x, y);
+            }
+        }
+        return acc;
+    };
+
+    auto perlin  = [](int32_t x, int32_t y) { return perlin2d_fixed(x, y, FREQ); };
+    auto simplex = [](int32_t x, int32_t y) { return simplex2d_fixed(x, y, FREQ); };
+
+    noise_gen_set_seed(0);
+    uint32_t perlin_0  = checksum(perlin);
+    uint32_t simplex_0 = checksum(simplex);
+
+    noise_gen_set_seed(42);
+    EXPECT_NE(checksum(perlin), perlin_0) << "Seeding did not change perlin noise";
+    EXPECT_NE(checksum(simplex), simplex_0) << "Seeding did not change simplex noise";
+
+    noise_gen_set_seed(0);
+    EXPECT_EQ(checksum(perlin), perlin_0) << "Going back to the original seed did not restore perlin noise";
+    EXPECT_EQ(checksum(simplex), simplex_0) << "Going back to the original seed did not restore simplex noise";
+}
+
+NOISE_TEST(simplex_covers_range) {
+    uint8_t  lowest = 0xFF, highest = 0;
+    uint64_t total = 0, samples = 0;
+
+    for (int32_t t = 0; t < 64; ++t) {
+        for (int32_t x = 0; x < GRID_W; x += 4) {
+            for (int32_t y = 0; y < GRID_H; y += 4) {
+                uint8_t n = simplex2d_fixed(x + t * 11, y + t * 7, FREQ);
+                lowest    = std::min(lowest, n);
+                highest   = std::max(highest, n);
+                total += n;
+                samples++;
+            }
+        }
+    }
+
+    EXPECT_LT(lowest, 0x30) << "Simplex noise never gets dark";
+    EXPECT_GT(highest, 0xD0) << "Simplex noise never gets bright";
+    EXPECT_NEAR((double)total / samples, 128.0, 16.0) << "Simplex noise is not centered";
+}
+
+NOISE_TEST(simplex_continuous) {
+    /* Neighbouring samples at a low frequency must be close to each other, no seams between cells */
+    constexpr int32q16_t SLOW_FREQ = 0x400;
+    constexpr int        MAX_STEP  = 24;
+
+    for (int32_t x = -300; x < 300; ++x) {
+        for (int32_t y = -40; y < 40; y += 3) {
+            int16_t here = simplex2d_fixed(x, y, SLOW_FREQ);
+            ASSERT_LE(std::abs(here - simplex2d_fixed(x + 1, y, SLOW_FREQ)), MAX_STEP)
+                << "Simplex 2D jumps between (" << x << ", " << y << ") and its right neighbour";
+            ASSERT_LE(std::abs(here - simplex2d_fixed(x, y + 1, SLOW_FREQ)), MAX_STEP)
+                << "Simplex 2D jumps between (" << x << ", " << y << ") and its bottom neighbour";
+
+            int16_t here_3d = simplex3d_fixed(x, y, x ^ y, SLOW_FREQ);
+            ASSERT_LE(std::abs(here_3d - simplex3d_fixed(x + 1, y, x ^ y, SLOW_FREQ)), MAX_STEP)
+                << "Simplex 3D jumps between (" << x << ", " << y << ") and its right neighbour";
+        }
+    }
+}
+
+NOISE_TEST(backend_selection) {
+    for (int32_t x = 0; x < GRID_W; x += 9) {
+        for (int32_t y = 0; y < GRID_H; y += 9) {
+#if NOISE_GEN_SIMPLEX
+            ASSERT_EQ(noise2d_fixed(x, y, FREQ), simplex2d_fixed(x, y, FREQ));
+            ASSERT_EQ(noise3d_fixed(x, y, 1, FREQ), simplex3d_fixed(x, y, 1, FREQ));
+#else
+            ASSERT_EQ(noise2d_fixed(x, y, FREQ), perlin2d_fixed(x, y, FREQ));
+            ASSERT_EQ(noise3d_fixed(x, y, 1, FREQ), perlin3d_fixed(x, y, 1, FREQ));
+#endif
+        }
+    }
+}
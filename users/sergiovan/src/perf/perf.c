@@ -0,0 +1,156 @@
+#include "perf.h"
+
+#include <string.h>
+
+#if SGV_PERF
+
+static perf_stats_t          perf_stats[PERF_COUNTER_COUNT] = {0};
+static perf_queue_stats_t    perf_queue                     = {0};
+static perf_pressure_stats_t perf_pressure                  = {0};
+
+static const char *const perf_names[PERF_COUNTER_COUNT] = {
+    [PERF_UPDATE]                  = "update",
+    [PERF_APPLY_FIRST + SOLID_KEY] = "apply_solid_key",
+    [PERF_APPLY_FIRST + SOLID_ALL] = "apply_solid_all",
+    [PERF_APPLY_FIRST + SHIMMER]   = "apply_shimmer",
+    [PERF_APPLY_FIRST + WAVE]      = "apply_wave",
+    [PERF_APPLY_FIRST + RIPPLE]    = "apply_ripple",
+    [PERF_APPLY_REGISTERED]        = "apply_registered",
+    [PERF_PERLIN]                  = "perlin",
+    [PERF_CALC_STATE]              = "calc_state",
+};
+
+/**
+ * @brief Histogram bucket of a measurement. Bucket n holds [4^(n-1), 4^n)
+ */
+static inline uint8_t perf_bucket(uint32_t elapsed) {
+    uint8_t bits = elapsed ? 32 - __builtin_clz(elapsed) : 0;
+    return (bits + 1) / 2;
+}
+
+void perf_init(void) {
+#    if PERF_DWT
+    perf_clock_init();
+#    endif
+
+    perf_reset();
+}
+
+void perf_reset(void) {
+    memset(perf_stats, 0, sizeof perf_stats);
+    memset(&perf_queue, 0, sizeof perf_queue);
+    memset(&perf_pressure, 0, sizeof perf_pressure);
+
+    for (uint8_t i = 0; i < PERF_COUNTER_COUNT; ++i) {
+        perf_stats[i].min = UINT32_MAX;
+    }
+    perf_queue.min = UINT8_MAX;
+}
+
+void perf_record(perf_counter_e counter, uint32_t elapsed) {
+    perf_stats_t *stats = &perf_stats[counter];
+
+    stats->count++;
+    stats->total += elapsed;
+    if (elapsed < stats->min) {
+        stats->min = elapsed;
+    }
+    if (elapsed > stats->max) {
+        stats->max = elapsed;
+    }
+
+    uint8_t bucket = perf_bucket(elapsed);
+    stats->histogram[bucket < PERF_HISTOGRAM_BUCKETS ? bucket : PERF_HISTOGRAM_BUCKETS - 1]++;
+}
+
+void perf_record_queue(uint8_t depth) {
+    perf_queue.count++;
+    perf_queue.total += depth;
+    if (depth < perf_queue.min) {
+        perf_queue.min = depth;
+    }
+    if (depth > perf_queue.max) {
+        perf_queue.max = depth;
+    }
+
+    perf_queue.depths[depth < PERF_QUEUE_DEPTHS ? depth : PERF_QUEUE_DEPTHS - 1]++;
+}
+
+void perf_record_pressure(perf_pressure_e what, animation_priority_e priority) {
+    if (what < PERF_PRESSURE_COUNT && priority < ANIMATION_PRIORITY_COUNT) {
+        perf_pressure.counts[what][priority]++;
+    }
+}
+
+const perf_stats_t *perf_get(perf_counter_e counter) {
+    return counter < PERF_COUNTER_COUNT ? &perf_stats[counter] : NULL;
+}
+
+const perf_queue_stats_t *perf_get_queue(void) {
+    return &perf_queue;
+}
+
+const perf_pressure_stats_t *perf_get_pressure(void) {
+    return &perf_pressure;
+}
+
+const char *perf_name(perf_counter_e counter) {
+    return counter < PERF_COUNTER_COUNT ? perf_names[counter] : "unknown";
+}
+
+void perf_print(void) {
+#    ifdef CONSOLE_ENABLE
+    uprintf("perf unit %s\n", PERF_UNIT);
+
+    for (uint8_t i = 0; i < PERF_COUNTER_COUNT; ++i) {
+        const perf_stats_t *stats = &perf_stats[i];
+        if (!stats->count) {
+            continue;
+        }
+
+        uprintf("perf %s count %lu min %lu avg %lu max %lu\n", perf_names[i], (unsigned long)stats->count,
+                (unsigned long)stats->min, (unsigned long)(stats->total / stats->count), (unsigned long)stats->max);
+
+        /* Only the buckets that were hit, as <first value in bucket>:<measurements> */
+        uprintf("perf %s histogram", perf_names[i]);
+        for (uint8_t b = 0; b < PERF_HISTOGRAM_BUCKETS; ++b) {
+            if (stats->histogram[b]) {
+                uprintf(" %lu:%lu", b ? 1UL << (2 * (b - 1)) : 0UL, (unsigned long)stats->histogram[b]);
+            }
+        }
+        uprintf("\n");
+    }
+
+    if (perf_queue.count) {
+        uprintf("perf queue count %lu min %u avg %u max %u\n", (unsigned long)perf_queue.count, perf_queue.min,
+                (unsigned)(perf_queue.total / perf_queue.count), perf_queue.max);
+
+        uprintf("perf queue depths");
+        for (uint8_t d = 0; d < PERF_QUEUE_DEPTHS; ++d) {
+            if (perf_queue.depths[d]) {
+                uprintf(" %u:%lu", d, (unsigned long)perf_queue.depths[d]);
+            }
+        }
+        uprintf("\n");
+    }
+
+    static const char *const perf_pressure_names[PERF_PRESSURE_COUNT] = {
+        [PERF_EVICTED]  = "evicted",
+        [PERF_DROPPED]  = "dropped",
+        [PERF_REJECTED] = "rejected",
+    };
+
+    /* Per priority, from cosmetic to indicator */
+    for (uint8_t what = 0; what < PERF_PRESSURE_COUNT; ++what) {
+        uprintf("perf %s", perf_pressure_names[what]);
+        for (uint8_t priority = 0; priority < ANIMATION_PRIORITY_COUNT; ++priority) {
+            uprintf(" %lu", (unsigned long)perf_pressure.counts[what][priority]);
+        }
+        uprintf("\n");
+    }
+
+    perf_reset();
+#    endif
+}
+
+#endif
@@ -0,0 +1,173 @@
+#pragma once
+#include "animation/animation.h"
+#include "common/common.h"
+
+/* Profiling counters of the LED task. Off by default, enable by defining SGV_PERF as true */
+#ifndef SGV_PERF
+#    define SGV_PERF false
+#endif
+
+/* Clock the counters are measured with. Cortex-M3/M4/M7 have the DWT cycle counter, everything else falls back to
+   the millisecond QMK timer. Boards and the simulator can bring their own clock */
+#ifndef PERF_CLOCK
+#    if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__)
+#        define PERF_DWT true
+#        define PERF_CLOCK() (*(volatile uint32_t *)0xE0001004) /* DWT_CYCCNT */
+#        define PERF_UNIT "cycles"
+#    else
+#        define PERF_CLOCK() timer_read32()
+#        define PERF_UNIT "ms"
+#    endif
+#endif
+
+#ifndef PERF_DWT
+#    define PERF_DWT false
+#endif
+
+#if PERF_DWT
+#    define PERF_DEMCR (*(volatile uint32_t *)0xE000EDFC)
+#    define PERF_DEMCR_TRCENA (1UL << 24)
+#    define PERF_DWT_CTRL (*(volatile uint32_t *)0xE0001000)
+#    define PERF_DWT_CTRL_CYCCNTENA (1UL << 0)
+
+/**
+ * @brief Starts the cycle counter PERF_CLOCK reads. Tracing reads it too, so it's available without SGV_PERF
+ */
+static inline void perf_clock_init(void) {
+    PERF_DEMCR |= PERF_DEMCR_TRCENA;
+    PERF_DWT_CTRL |= PERF_DWT_CTRL_CYCCNTENA;
+}
+#endif
+
+/* Histogram buckets. Bucket n holds measurements in [4^(n-1), 4^n), bucket 0 holds 0 */
+#define PERF_HISTOGRAM_BUCKETS 16
+
+/* Queue depths above this go in the last bucket */
+#define PERF_QUEUE_DEPTHS 17
+
+/**
+ * @brief Measured sections of the LED task
+ */
+typedef enum perf_counter : uint8_t {
+    PERF_UPDATE,       /* sgv_animation_update, one LED batch */
+    PERF_APPLY_FIRST,  /* apply_animation, one counter per built in animation type from here */
+    PERF_APPLY_REGISTERED = PERF_APPLY_FIRST + ANIMATION_TYPE_COUNT, /* apply_animation, every registered type */
+    PERF_PERLIN,       /* get_perlin, one LED */
+    PERF_CALC_STATE,   /* apply_calc_state, one LED batch */
+
+    PERF_COUNTER_COUNT, /* Counter count enum value for convenience */
+} perf_counter_e;
+
+/**
+ * @brief What happened to an animation because the queue was out of room
+ */
+typedef enum perf_pressure : uint8_t {
+    PERF_EVICTED,  /* Finished early and removed from the front of the queue */
+    PERF_DROPPED,  /* Removed from the middle of the queue without being applied */
+    PERF_REJECTED, /* Never added, everything queued was more important */
+
+    PERF_PRESSURE_COUNT, /* Pressure outcome count enum value for convenience */
+} perf_pressure_e;
+
+/**
+ * @brief Accumulated measurements of one section, in PERF_UNIT
+ */
+typedef struct perf_stats {
+    uint32_t count;                             /* Measurements taken */
+    uint32_t min;                               /* Shortest measurement */
+    uint32_t max;                               /* Longest measurement */
+    uint64_t total;                             /* Sum of all measurements, for the average */
+    uint32_t histogram[PERF_HISTOGRAM_BUCKETS]; /* Measurements per power of 4 */
+} perf_stats_t;
+
+/**
+ * @brief Queue depth seen at the start of every LED batch
+ */
+typedef struct perf_queue_stats {
+    uint32_t count;                     /* Batches seen */
+    uint8_t  min;                       /* Shallowest queue */
+    uint8_t  max;                       /* Deepest queue */
+    uint32_t total;                     /* Sum of all depths, for the average */
+    uint32_t depths[PERF_QUEUE_DEPTHS]; /* Batches per queue depth */
+} perf_queue_stats_t;
+
+/**
+ * @brief Animations that had to make room, or couldn't get any, per priority
+ */
+typedef struct perf_pressure_stats {
+    uint32_t counts[PERF_PRESSURE_COUNT][ANIMATION_PRIORITY_COUNT];
+} perf_pressure_stats_t;
+
+#if SGV_PERF
+
+/**
+ * @brief Starts the cycle counter if there is one, and clears all counters
+ */
+void perf_init(void);
+
+/**
+ * @brief Clears all counters
+ */
+void perf_reset(void);
+
+/**
+ * @brief Adds one measurement to a counter
+ *
+ * @param counter Counter to add to
+ * @param elapsed Measurement, in PERF_UNIT
+ */
+void perf_record(perf_counter_e counter, uint32_t elapsed);
+
+/**
+ * @brief Adds one queue depth measurement
+ *
+ * @param depth Animations in the queue
+ */
+void perf_record_queue(uint8_t depth);
+
+/**
+ * @brief Counts one animation that had to make room, or couldn't get any
+ *
+ * @param what What happened to the animation
+ * @param priority Priority of the animation
+ */
+void perf_record_pressure(perf_pressure_e what, animation_priority_e priority);
+
+/**
+ * @brief Returns the accumulated measurements of one counter
+ */
+const perf_stats_t *perf_get(perf_counter_e counter);
+
+/**
+ * @brief Returns the accumulated queue depth measurements
+ */
+const perf_queue_stats_t *perf_get_queue(void);
+
+/**
+ * @brief Returns the animations that had to make room, or couldn't get any
+ */
+const perf_pressure_stats_t *perf_get_pressure(void);
+
+/**
+ * @brief Returns a printable name for a counter
+ */
+const char *perf_name(perf_counter_e counter);
+
+/**
+ * @brief Dumps every counter over the QMK console and clears them. Does nothing without CONSOLE_ENABLE
+ */
+void perf_print(void);
+
+#    define PERF_BEGIN(name) uint32_t name = PERF_CLOCK()
+#    define PERF_END(counter, start) perf_record(counter, PERF_CLOCK() - (start))
+#    define PERF_QUEUE(depth) perf_record_queue(depth)
+#    define PERF_PRESSURE(what, priority) perf_record_pressure(what, priority)
+
+#else
+
+#    define PERF_BEGIN(name)
+#    define PERF_END(counter, start)
+#    define PERF_QUEUE(depth)
+#    define PERF_PRESSURE(what, priority)
+
+#endif
@@ -0,0 +1,101 @@
+#include <gtest/gtest.h>
+
+extern "C" {
+#include "animation/animation.h"
+#include "perf/perf.h"
+#include "scenarios.h"
+#include "sim.h"
+}
+
+class PerfTest : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        perf_reset();
+    }
+
+    void TearDown() override {
+        perf_reset();
+    }
+};
+
+TEST_F(PerfTest, accumulates) {
+    perf_record(PERF_UPDATE, 10);
+    perf_record(PERF_UPDATE, 30);
+    perf_record(PERF_UPDATE, 20);
+
+    const perf_stats_t *stats = perf_get(PERF_UPDATE);
+    EXPECT_EQ(stats->count, 3u);
+    EXPECT_EQ(stats->min, 10u);
+    EXPECT_EQ(stats->max, 30u);
+    EXPECT_EQ(stats->total, 60u);
+
+    EXPECT_EQ(perf_get(PERF_PERLIN)->count, 0u);
+}
+
+TEST_F(PerfTest, histogram_buckets_by_powers_of_4) {
+    perf_record(PERF_PERLIN, 0);
+    perf_record(PERF_PERLIN, 1);
+    perf_record(PERF_PERLIN, 3);
+    perf_record(PERF_PERLIN, 4);
+    perf_record(PERF_PERLIN, 15);
+    perf_record(PERF_PERLIN, 16);
+    perf_record(PERF_PERLIN, UINT32_MAX);
+
+    const perf_stats_t *stats = perf_get(PERF_PERLIN);
+    EXPECT_EQ(stats->histogram[0], 1u);
+    EXPECT_EQ(stats->histogram[1], 2u);
+    EXPECT_EQ(stats->histogram[2], 2u);
+    EXPECT_EQ(stats->histogram[3], 1u);
+    EXPECT_EQ(stats->histogram[PERF_HISTOGRAM_BUCKETS - 1], 1u);
+}
+
+TEST_F(PerfTest, queue_depths) {
+    perf_record_queue(0);
+    perf_record_queue(4);
+    perf_record_queue(200);
+
+    const perf_queue_stats_t *queue = perf_get_queue();
+    EXPECT_EQ(queue->count, 3u);
+    EXPECT_EQ(queue->min, 0);
+    EXPECT_EQ(queue->max, 200);
+    EXPECT_EQ(queue->depths[4], 1u);
+    EXPECT_EQ(queue->depths[PERF_QUEUE_DEPTHS - 1], 1u);
+}
+
+TEST_F(PerfTest, counts_simulated_frames) {
+    /* Every batch of every frame goes through the update and the output stage once */
+    uint32_t frames = sim_scenario_run(sim_scenario_find("storm"), 16, nullptr, nullptr);
+
+    const perf_stats_t *update = perf_get(PERF_UPDATE);
+    EXPECT_GT(frames, 0u);
+    EXPECT_EQ(update->count % frames, 0u);
+    EXPECT_EQ(perf_get(PERF_CALC_STATE)->count, update->count);
+    EXPECT_EQ(perf_get_queue()->count, update->count);
+    EXPECT_GT(perf_get(static_cast<perf_counter_e>(PERF_APPLY_FIRST + static_cast<int>(WAVE)))->count, 0u);
+    EXPECT_LE(update->min, update->max);
+}
+
+TEST_F(PerfTest, queue_pressure) {
+    sim_reset();
+    sim_set_time(SIM_START_TIME);
+
+    /* Indicators a second from now fill the queue, the front ones are finished early to make room */
+    for (uint8_t i = 0; i < 40; ++i) {
+        animation_t anim = animation_solid_key(0, 0xFF, 0xFF, 0xFF);
+        anim.ticks += 1000;
+        anim.priority = ANIMATION_PRIORITY_INDICATOR;
+        sgv_animation_add_animation(anim);
+    }
+
+    animation_t ambient = animation_solid_key(1, 0xFF, 0xFF, 0xFF);
+    ambient.priority    = ANIMATION_PRIORITY_AMBIENT;
+    EXPECT_EQ(sgv_animation_add_animation(ambient), ANIMATION_HANDLE_NONE);
+
+    const perf_pressure_stats_t *pressure = perf_get_pressure();
+    EXPECT_GT(pressure->counts[PERF_EVICTED][ANIMATION_PRIORITY_INDICATOR], 0u);
+    EXPECT_EQ(pressure->counts[PERF_DROPPED][ANIMATION_PRIORITY_INDICATOR], 0u);
+    EXPECT_EQ(pressure->counts[PERF_REJECTED][ANIMATION_PRIORITY_AMBIENT], 1u);
+    EXPECT_EQ(pressure->counts[PERF_REJECTED][ANIMATION_PRIORITY_INDICATOR], 0u);
+
+    sim_reset();
+}
@@ -1,3 +1,6 @@
 SRC += 	circular_buffer/circular_buffer.c \
 		noise/noise_gen.c \
-		animation/animation.c
+		animation/animation.c \
+		trace/trace.c \
+		perf/perf.c \
+		capture/capture.c
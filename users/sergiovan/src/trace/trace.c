@@ -0,0 +1,151 @@
+#include "trace.h"
+
+#include <string.h>
+
+#if SGV_TRACE
+
+#    if defined(RAW_ENABLE) && !defined(VIA_ENABLE)
+#        include "raw_hid.h"
+#    endif
+
+/* Ring of events. `trace_begin` is the oldest event, `trace_length` how many there are */
+static trace_event_t trace_ring[TRACE_RING_SIZE] = {0};
+static uint8_t       trace_begin                 = 0;
+static uint8_t       trace_length                = 0;
+static uint16_t      trace_dropped_count         = 0;
+
+#    if PERF_DWT
+/* Microseconds counted so far, and the cycle count they were counted up to */
+static uint32_t trace_clock_us     = 0;
+static uint32_t trace_clock_cycles = 0;
+#    endif
+
+void trace_init(void) {
+#    if PERF_DWT
+    perf_clock_init();
+    trace_clock_us     = 0;
+    trace_clock_cycles = PERF_CLOCK();
+#    endif
+
+    trace_clear();
+}
+
+#    if PERF_DWT
+uint32_t trace_clock(void) {
+    /* Only whole microseconds are taken, the cycles left over count towards the next one */
+    uint32_t elapsed = (PERF_CLOCK() - trace_clock_cycles) / TRACE_CYCLES_PER_US;
+    trace_clock_cycles += elapsed * TRACE_CYCLES_PER_US;
+    trace_clock_us += elapsed;
+    return trace_clock_us;
+}
+#    endif
+
+void trace_event(trace_event_type_e type, uint8_t arg, uint16_t data) {
+    trace_event_at(TRACE_CLOCK(), type, arg, data);
+}
+
+void trace_event_at(uint32_t time, trace_event_type_e type, uint8_t arg, uint16_t data) {
+    uint8_t end = (trace_begin + trace_length) % TRACE_RING_SIZE;
+
+    trace_ring[end] = (trace_event_t){
+        .time = time,
+        .type = type,
+        .arg  = arg,
+        .data = data,
+    };
+
+    if (trace_length < TRACE_RING_SIZE) {
+        trace_length++;
+    } else {
+        trace_begin = (trace_begin + 1) % TRACE_RING_SIZE;
+        if (trace_dropped_count < UINT16_MAX) {
+            trace_dropped_count++;
+        }
+    }
+}
+
+void trace_clear(void) {
+    trace_begin         = 0;
+    trace_length        = 0;
+    trace_dropped_count = 0;
+}
+
+uint8_t trace_drain(trace_event_t *events, uint8_t max) {
+    uint8_t taken = 0;
+
+    while (taken < max && trace_length) {
+        events[taken++] = trace_ring[trace_begin];
+        trace_begin     = (trace_begin + 1) % TRACE_RING_SIZE;
+        trace_length--;
+    }
+
+    return taken;
+}
+
+uint16_t trace_dropped(void) {
+    uint16_t dropped    = trace_dropped_count;
+    trace_dropped_count = 0;
+    return dropped;
+}
+
+uint8_t trace_pack(uint8_t *data, uint8_t length) {
+    if (data == NULL || length < 1 + sizeof(trace_event_t)) {
+        return 0;
+    }
+
+    /* Reports have no alignment guarantees, so events are copied in byte by byte */
+    trace_event_t event;
+    uint8_t       count = 0;
+    uint8_t       max   = (length - 1) / sizeof(trace_event_t);
+
+    while (count < max && trace_drain(&event, 1)) {
+        memcpy(&data[1 + count * sizeof(trace_event_t)], &event, sizeof(trace_event_t));
+        count++;
+    }
+
+    data[0] = count;
+
+    return count;
+}
+
+void trace_print(void) {
+#    ifdef CONSOLE_ENABLE
+    trace_event_t event;
+    uint16_t      dropped = trace_dropped();
+
+    if (dropped) {
+        uprintf("trace dropped %u\n", dropped);
+    }
+    while (trace_drain(&event, 1)) {
+        uprintf("trace %lu %u %u %u\n", (unsigned long)event.time, event.type, event.arg, event.data);
+    }
+#    endif
+}
+
+void trace_stream(void) {
+#    ifdef CONSOLE_ENABLE
+    static uint32_t last_stream = 0;
+
+    if (timer_elapsed32(last_stream) < TRACE_STREAM_MS) {
+        return;
+    }
+
+    last_stream = timer_read32();
+    trace_print();
+#    endif
+}
+
+#    if defined(RAW_ENABLE) && !defined(VIA_ENABLE)
+/* Any report starting with 'T' is answered with a report full of events. The host keeps asking until a report
+   comes back with no events in it */
+void raw_hid_receive(uint8_t *data, uint8_t length) {
+    if (length == 0 || data[0] != 'T') {
+        return;
+    }
+
+    trace_pack(data, length);
+    raw_hid_send(data, length);
+}
+#    endif
+
+#endif
@@ -0,0 +1,148 @@
+#pragma once
+#include "common/common.h"
+#include "perf/perf.h"
+
+/* Frame level tracing of the animation engine. Off by default, enable by defining SGV_TRACE as true */
+#ifndef SGV_TRACE
+#    define SGV_TRACE false
+#endif
+
+/* Amount of events kept. Once full, the oldest events are overwritten */
+#ifndef TRACE_RING_SIZE
+#    define TRACE_RING_SIZE 128
+#endif
+
+/* Microsecond clock used to timestamp events. Where the perf counters have the DWT cycle counter it's counted from
+   that, everything else falls back to the millisecond QMK timer. Boards and the simulator can bring their own clock */
+#ifndef TRACE_CLOCK
+#    if PERF_DWT
+#        define TRACE_CLOCK() trace_clock()
+#    else
+#        define TRACE_CLOCK() (timer_read32() * 1000)
+#    endif
+#endif
+
+/* Cycles of the DWT cycle counter in one microsecond */
+#ifndef TRACE_CYCLES_PER_US
+#    define TRACE_CYCLES_PER_US (CPU_CLOCK / 1000000)
+#endif
+
+/* Milliseconds between the times `trace_stream` drains the ring over the console */
+#ifndef TRACE_STREAM_MS
+#    define TRACE_STREAM_MS 250
+#endif
+
+/**
+ * @brief Trace event types
+ */
+typedef enum trace_event_type : uint8_t {
+    TRACE_FRAME_BEGIN, /* A batch of LEDs started rendering. arg is the batch, data the queue length */
+    TRACE_FRAME_END,   /* A batch of LEDs finished rendering. arg is the batch, data the queue length */
+    TRACE_APPLY,       /* An animation was applied. arg is its type, data the time it took in microseconds */
+    TRACE_PUSH,        /* An animation was added to the queue. arg is its type, data the queue length after */
+    TRACE_EVICT,       /* The queue was full and the oldest animation was finished. arg is type, data priority */
+    TRACE_PRUNE,       /* Animations were removed from the front of the queue. arg is the apply result, data how many */
+    TRACE_CANCEL,      /* A queued animation was cancelled. arg is its type, data the queue length */
+    TRACE_DROP,        /* A queued animation was dropped to make room. arg is its type, data its priority */
+    TRACE_REJECT,      /* An animation wasn't added, there was no room. arg is its type, data its priority */
+    TRACE_ABSORB,      /* A ripple joined the newest queued ripple. arg is its type, data that ripple's origins */
+
+    TRACE_EVENT_COUNT, /* Trace event type count enum value for convenience */
+} trace_event_type_e;
+
+/**
+ * @brief One trace event, 8 bytes
+ */
+typedef struct trace_event {
+    uint32_t           time; /* When the event happened, in microseconds */
+    trace_event_type_e type; /* What happened */
+    uint8_t            arg;  /* Event specific argument */
+    uint16_t           data; /* Event specific data */
+} trace_event_t;
+
+#if SGV_TRACE
+
+/**
+ * @brief Starts the clock events are timestamped with, and throws away every event in the ring
+ */
+void trace_init(void);
+
+#    if PERF_DWT
+/**
+ * @brief Microseconds since `trace_init`, counted on the DWT cycle counter. The counter wraps in less than a minute,
+ *        so longer gaps between events come out shorter than they were
+ */
+uint32_t trace_clock(void);
+#    endif
+
+/**
+ * @brief Records one event that happened now
+ *
+ * @param type Event type
+ * @param arg Event specific argument
+ * @param data Event specific data
+ */
+void trace_event(trace_event_type_e type, uint8_t arg, uint16_t data);
+
+/**
+ * @brief Records one event that happened at a specific time
+ *
+ * @param time When the event happened, in microseconds
+ * @param type Event type
+ * @param arg Event specific argument
+ * @param data Event specific data
+ */
+void trace_event_at(uint32_t time, trace_event_type_e type, uint8_t arg, uint16_t data);
+
+/**
+ * @brief Throws away every event in the ring and the dropped count
+ */
+void trace_clear(void);
+
+/**
+ * @brief Takes the oldest events out of the ring
+ *
+ * @param events Where to write the events
+ * @param max Maximum amount of events to take
+ * @return uint8_t Amount of events taken
+ */
+uint8_t trace_drain(trace_event_t *events, uint8_t max);
+
+/**
+ * @brief Returns how many events were overwritten before being drained, and resets the count
+ */
+uint16_t trace_dropped(void);
+
+/**
+ * @brief Packs as many of the oldest events as fit into a raw HID report, taking them out of the ring. The first
+ *        byte of the report is the amount of events packed, followed by the events
+ *
+ * @param data Report to fill
+ * @param length Length of the report
+ * @return uint8_t Amount of events packed
+ */
+uint8_t trace_pack(uint8_t *data, uint8_t length);
+
+/**
+ * @brief Drains the whole ring over the QMK console, one `trace <time> <type> <arg> <data>` line per event. Does
+ *        nothing without CONSOLE_ENABLE
+ */
+void trace_print(void);
+
+/**
+ * @brief Drains the whole ring over the QMK console like `trace_print`, at most once every TRACE_STREAM_MS. Meant to
+ *        be called every loop of the main task. Does nothing without CONSOLE_ENABLE
+ */
+void trace_stream(void);
+
+#    define TRACE(type, arg, data) trace_event(type, arg, data)
+#    define TRACE_TIME(name) uint32_t name = TRACE_CLOCK()
+#    define TRACE_SINCE(start, type, arg) trace_event_at(start, type, arg, TRACE_CLOCK() - (start))
+
+#else
+
+#    define TRACE(type, arg, data)
+#    define TRACE_TIME(name)
+#    define TRACE_SINCE(start, type, arg)
+
+#endif
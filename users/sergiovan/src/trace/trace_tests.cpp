@@ -0,0 +1,80 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+
+extern "C" {
+#include "trace/trace.h"
+}
+
+class TraceTest : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        trace_clear();
+    }
+
+    void TearDown() override {
+        trace_clear();
+    }
+};
+
+TEST_F(TraceTest, drains_in_order) {
+    trace_event_at(10, TRACE_FRAME_BEGIN, 0, 3);
+    trace_event_at(20, TRACE_APPLY, 2, 7);
+    trace_event_at(30, TRACE_FRAME_END, 0, 3);
+
+    trace_event_t events[4];
+    ASSERT_EQ(trace_drain(events, 4), 3);
+
+    EXPECT_EQ(events[0].time, 10u);
+    EXPECT_EQ(events[0].type, TRACE_FRAME_BEGIN);
+    EXPECT_EQ(events[1].time, 20u);
+    EXPECT_EQ(events[1].type, TRACE_APPLY);
+    EXPECT_EQ(events[1].arg, 2);
+    EXPECT_EQ(events[1].data, 7);
+    EXPECT_EQ(events[2].type, TRACE_FRAME_END);
+
+    EXPECT_EQ(trace_drain(events, 4), 0);
+    EXPECT_EQ(trace_dropped(), 0);
+}
+
+TEST_F(TraceTest, overwrites_oldest_when_full) {
+    for (uint32_t i = 0; i < TRACE_RING_SIZE + 5; ++i) {
+        trace_event_at(i, TRACE_PUSH, 0, 0);
+    }
+
+    EXPECT_EQ(trace_dropped(), 5);
+    EXPECT_EQ(trace_dropped(), 0);
+
+    trace_event_t event;
+    ASSERT_EQ(trace_drain(&event, 1), 1);
+    EXPECT_EQ(event.time, 5u);
+
+    uint32_t left = 0;
+    while (trace_drain(&event, 1)) {
+        ++left;
+    }
+    EXPECT_EQ(left, TRACE_RING_SIZE - 1u);
+    EXPECT_EQ(event.time, TRACE_RING_SIZE + 4u);
+}
+
+TEST_F(TraceTest, packs_reports) {
+    for (uint32_t i = 0; i < 5; ++i) {
+        trace_event_at(i, TRACE_APPLY, 3, i * 2);
+    }
+
+    /* 32 byte raw HID reports fit three events after the count */
+    uint8_t report[32];
+    ASSERT_EQ(trace_pack(report, sizeof report), 3);
+    EXPECT_EQ(report[0], 3);
+
+    trace_event_t event;
+    std::memcpy(&event, &report[1 + 2 * sizeof(trace_event_t)], sizeof event);
+    EXPECT_EQ(event.time, 2u);
+    EXPECT_EQ(event.data, 4);
+
+    EXPECT_EQ(trace_pack(report, sizeof report), 2);
+    EXPECT_EQ(trace_pack(report, sizeof report), 0);
+    EXPECT_EQ(report[0], 0);
+
+    EXPECT_EQ(trace_pack(report, sizeof(trace_event_t)), 0);
+}